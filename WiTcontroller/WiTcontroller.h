@@ -8,6 +8,10 @@
 #define maxTurnoutList 60     // must be a multiple of 10
 #define maxRouteList 60     // must be a multiple of 10
 
+// list entries are formatted for the screen once, when they are received
+#define ROSTER_LABEL_SIZE 25     // "n: <name> (<address>)" one per row
+#define LIST_LABEL_SIZE 14       // "n: <10 characters>"  two columns
+
 
 extern int keypadUseType;
 extern int encoderUseType;
@@ -19,18 +23,38 @@ extern bool menuIsShowing;
 extern String oledText[];
 extern bool oledTextInvert[];
 
-extern int currentSpeed[];
-extern Direction currentDirection[];
+// everything kept for each throttle, in a pool of THROTTLE_POOL_SIZE. The most used first
+struct ThrottleState {
+  int speed;
+  Direction direction;
+  int speedStep;
+  int momentumTargetSpeed;            // speed the throttle is heading for
+  long momentumSpeedFixed;            // speed actually reached, in 1/256ths of a speed step
+  unsigned long momentumLastSentTime;
+  uint32_t functionStates;            // one bit per function.  Use getFunctionState() / setFunctionState()
+  int8_t functionFollow[MAX_FUNCTIONS];   // CONSIST_LEAD_LOCO or CONSIST_ALL_LOCOS
+  String functionLabels[MAX_FUNCTIONS];
+  char functionListLabels[MAX_FUNCTIONS][LIST_LABEL_SIZE];   // as shown in the function list. See buildFunctionListLabels()
+
+  // derived from the library's consist.  Only valid after updateDerivedState()
+  int locoCount;
+  String leadLoco;
+  uint32_t reverseFacing;             // bit per consist position (first 32) facing the other way to the lead loco
+  String displayLocos;                // the consist as shown on the throttle screen
+};
+static_assert(MAX_FUNCTIONS <= 32, "ThrottleState::functionStates holds 32 functions");
+
+extern ThrottleState throttleStates[];
+extern uint16_t activeThrottles;
+extern uint16_t derivedStateDirty;
+extern uint16_t derivedStatePendingLibrary;
+extern unsigned long derivedStateRebuildCount;
 extern int speedStepCurrentMultiplier;
 
 extern TrackPower trackPower;
 extern String turnoutPrefix;
 extern String routePrefix;
 
-extern bool circleValues;
-extern int encoderValue;
-extern int lastEncoderValue;
-
 extern String selectedSsid;
 extern String selectedSsidPassword;
 extern int ssidConnectionState;
@@ -79,10 +103,6 @@ extern int routeListIndex[];
 extern String routeListSysName[]; 
 extern String routeListUserName[];
 extern int routeListState[];
-extern bool functionStates[][MAX_FUNCTIONS];
-extern String functionLabels[][MAX_FUNCTIONS];
-extern int functionFollow[][MAX_FUNCTIONS];
-extern int currentSpeedStep[];
 extern int heartBeatPeriod;
 extern long lastServerResponseTime;
 extern bool heartbeatCheckEnabled;
@@ -90,7 +110,7 @@ extern const char* deviceName;
 extern const bool encoderRotationClockwiseIsIncreaseSpeed;
 extern const bool toggleDirectionOnEncoderButtonPressWhenStationary;
 extern int buttonActions[];
-extern const String directCommandText[][3];
+extern const char* const directCommandText[][3];
 extern int additionalButtonActions[];
 
 extern long lastSpeedSentTime;
@@ -107,6 +127,39 @@ extern int currentThrottleIndex;
 void displayUpdateFromWit(void);
 void ssidsLoop(void);
 void browseSsids(void);
+void buildRosterLabel(int);
+void buildTurnoutOrRouteLabel(char*, int, String);
+void buildFunctionListLabels(int);
+void linkProbeSent(int, char);
+void linkInboundLine(const char*, int);
+void linkProbeAnswered(int, int);
+void linkTelemetryLoop();
+int linkRssiBars(int);
+void writeOledLinkIndicator(bool);
+void writeOledDiagnostics();
+void roamingLoop();
+int roamingSmoothRssi(int, int);
+bool roamingShouldRoam(int, int, bool);
+void roamingStartScan();
+void roamingScanLoop();
+void roamToCandidate();
+void roamingMoveLoop();
+void roamingReconnect();
+void roamingRestoreThrottles();
+void roamingSimulate(const char*);
+void writeSessionSnapshot();
+void startSsidScan();
+void stopSsidScan();
+void browseSsidsLoop();
+uint32_t fnv1aHash(String);
+int findFoundSsid(String, uint32_t, int*);
+void mergeSsidScanResults(int);
+void sortFoundSsids();
+void showFoundSsids();
+void readKnownSsidChannels();
+void writeKnownSsidChannels();
+bool updateKnownSsidChannels();
+void rememberSsidChannel(String, uint8_t);
 void selectSsidFromFound(int);
 void getSsidPasswordAndWitIpForFound(void);
 void enterSsidPassword(void);
@@ -130,22 +183,105 @@ void buildWitEntry(void);
 void IRAM_ATTR readEncoderISR(void);
 void rotary_onButtonClick(void);
 void rotary_loop(void);
+void encoderDetents(int, int);
 void encoderSpeedChange(bool, int);
 void keypadEvent(KeypadEvent);
 void initialiseAdditionalButtons(void);
 void additionalButtonLoop(void);
 
+int sliceToInt(const char*, int);
+int sliceIndexOf(const char*, int, const char*, int);
+String sliceToString(const char*, int);
+bool witStreamFastParse(const char*, int);
+bool witStreamParseLocoAction(const char*, int);
+bool witStreamParseRosterList(const char*, int);
+bool witStreamParseTurnoutOrRouteList(const char*, int, bool);
+bool witStreamParseDccExBroadcast(const char*, int);
+void witStreamStatsLoop(void);
+void selectThrottleBackend(void);
+
+int getOutboundClass(int);
+void queueOutboundCommand(int, char, int);
+void queueOutboundCommand(int, char, int, String);
+void queueOutboundCommand(int, char, int, String, bool, bool);
+void outboundCommandsLoop(void);
+void sendNextOutboundCommand(int);
+void removeOutboundCommand(int, int);
+void outboundCaptureStart(void);
+void outboundCaptureQueue(char);
+void queueReleaseLoco(char, String);
+void recordOutboundWait(int, unsigned long);
+void sendOutboundEstop(char);
+void dropOutboundSpeedCommands(char);
+void flushOutbound(void);
+void drainOutbound(void);
+void clearOutboundQueue(void);
+
+void queueAcquireLoco(char, String);
+bool acquireSendNext(void);
+void removeAcquireLoco(int);
+void dropAcquireLocos(char);
+void acquireLoop(void);
+void acquireReplyReceived(void);
+void clearAcquireQueue(void);
+
+void latencyMarkInput(void);
+void latencyStartScenario(int);
+void latencyEndLoop(void);
+bool latencyTagCommand(void);
+void latencyCommandSent(void);
+void latencyMarkWire(void);
+void latencyMarkPixel(void);
+void latencyReportLoop(void);
+
+bool sessionRecordLine(const char*, int);
+void sessionRecordInput(char, char, int);
+void sessionLoop(void);
+void sessionSerialCommand(void);
+void serialCommandLoop(void);
+bool serialApiCommand(void);
+void serialApiInput(char, int, int);
+bool serialApiIsKey(char);
+bool serialApiAreKeys(const char*);
+void serialApiReportState(void);
+void serialApiReportThrottle(int);
+void serialApiReportMetrics(void);
+int serialApiThrottleIndex(const char*);
+void sessionReplayEvent(void);
+void sessionReplayReport(void);
+void metricsLoop(void);
+void metricsSend(void);
+void metricsReset(void);
+void loopStageStart(void);
+void loopStageMark(int);
+void loopStageEnd(void);
+void loopStageReset(void);
+void loopStageReport(void);
+
+void oledStartSendTask(void);
+void oledSendBuffer(void);
+void oledSendTask(void *);
+void oledWaitForSend(void);
+
 void setup(void);
 void loop(void);
 
 void doKeyPress(char, bool);
 void doDirectCommand (char, bool);
 void doDirectAdditionalButtonCommand (int, bool);
-void doDirectAction(int);
+void benchmarkActionDispatch(void);
 void doMenu(void);
 void resetMenu(void);
 
 void resetFunctionStates(int);
+bool getFunctionState(int, int);
+void invalidateDerivedState(int);
+void derivedStateInboundLine(const char*, int);
+void derivedStateLibraryChecked();
+void rebuildDerivedState(int);
+void updateDerivedState();
+String getDisplayLocoName(String);
+void setFunctionState(int, int, bool);
 void resetFunctionLabels(int); 
 void resetAllFunctionLabels(void); 
 String getLocoWithLength(String);
@@ -153,11 +289,18 @@ void speedEstop(void);
 void speedDown(int, int);
 void speedUp(int, int);
 void speedSet(int, int);
+void speedSetNow(int, int);
+void momentumSetTarget(int, int);
+bool momentumIsRamping(int);
+void momentumCancel(int);
+void throttleReleased(int);
+void momentumLoop();
 void releaseAllLocos(int);
 void toggleAdditionalMultiplier(void);
 void toggleHeartbeatCheck(void);
 void toggleDirection(int);
 void changeDirection(int, Direction);
+void sendConsistDirection(int, Direction);
 
 void doDirectFunction(int, bool);
 void doDirectFunction(int, bool, bool force);
@@ -173,6 +316,27 @@ void nextThrottle(void);
 void reconnect(void);
 void setLastServerResponseTime(bool);
 
+const char* getText(int);
+const char* getMenuText(int, int);
+void nextLanguage(void);
+void readLanguagePreference(void);
+
+int buildLocoRecord(uint8_t *);
+bool applyLocoRecord(const uint8_t *, int);
+uint16_t locoRecordChecksum(const uint8_t *, int);
+void autoSaveLocosLoop(void);
+
+bool fastResumeAvailable(void);
+void fastResumeWriteSnapshot(void);
+void fastResumeStart(void);
+void fastResumeRestoreLocos(void);
+void fastResumeCancel(void);
+void fastResumeClearPassword(void);
+void writeLanguagePreference(void);
+
+void parseStartupCommands(void);
+void doStartupCommands(void);
+void doOneStartupCommand(String);
 void selectRoster(int);
 void selectTurnoutList(int, TurnoutAction);
 void selectRouteList(int);
@@ -211,4 +375,86 @@ void deepSleepStart();
 void deepSleepStart(int);
 
 char getMultiThrottleChar(int);
-int getMultiThrottleIndex(char);
\ No newline at end of file
+int getMultiThrottleIndex(char);
+
+// action handlers.  One per non-function action in actions.h
+void actionDirectionForward(void);
+void actionDirectionReverse(void);
+void actionDirectionToggle(void);
+void actionSpeedStop(void);
+void actionSpeedUp(void);
+void actionSpeedDown(void);
+void actionSpeedUpFast(void);
+void actionSpeedDownFast(void);
+void actionSleep(void);
+void actionDiagnostics(void);
+void actionPowerOn(void);
+void actionPowerOff(void);
+void actionThrottle1(void);
+void actionThrottle2(void);
+void actionThrottle3(void);
+void actionThrottle4(void);
+void actionThrottle5(void);
+void actionThrottle6(void);
+void actionMaxThrottleIncrease(void);
+void actionMaxThrottleDecrease(void);
+void actionCustom1(void);
+void actionCustom2(void);
+void actionCustom3(void);
+void actionCustom4(void);
+void actionCustom5(void);
+void actionCustom6(void);
+void actionCustom7(void);
+void speedEstopCurrentLoco(void);
+void batteryShowToggle(void);
+void nextThrottle(void);
+void stopThenToggleDirection(void);
+void actionNone(void);
+
+typedef void (*ActionHandler)(void);
+
+// Resolved by the compiler for the actions chosen in config_buttons.h, so only the handlers 
+// actually used are linked.  But anything that looks an action up at run time (the new additional button 
+// format, SERIAL_API, LATENCY_BENCHMARK) links them all.  Functions (FUNCTION_0 - FUNCTION_31) and FUNCTION_NULL have no handler
+constexpr ActionHandler getActionHandler(int action) {
+  return (action == DIRECTION_FORWARD) ? actionDirectionForward
+       : (action == DIRECTION_REVERSE) ? actionDirectionReverse
+       : (action == DIRECTION_TOGGLE) ? actionDirectionToggle
+       : (action == SPEED_STOP) ? actionSpeedStop
+       : (action == SPEED_UP) ? actionSpeedUp
+       : (action == SPEED_DOWN) ? actionSpeedDown
+       : (action == SPEED_UP_FAST) ? actionSpeedUpFast
+       : (action == SPEED_DOWN_FAST) ? actionSpeedDownFast
+       : (action == SPEED_MULTIPLIER) ? toggleAdditionalMultiplier
+       : (action == E_STOP) ? speedEstop
+       : (action == E_STOP_CURRENT_LOCO) ? speedEstopCurrentLoco
+       : (action == POWER_ON) ? actionPowerOn
+       : (action == POWER_OFF) ? actionPowerOff
+       : (action == POWER_TOGGLE) ? powerToggle
+       : (action == SHOW_HIDE_BATTERY) ? batteryShowToggle
+       : (action == SLEEP) ? actionSleep
+       : (action == DIAGNOSTICS) ? actionDiagnostics
+       : (action == NEXT_THROTTLE) ? nextThrottle
+       : (action == THROTTLE_1) ? actionThrottle1
+       : (action == THROTTLE_2) ? actionThrottle2
+       : (action == THROTTLE_3) ? actionThrottle3
+       : (action == THROTTLE_4) ? actionThrottle4
+       : (action == THROTTLE_5) ? actionThrottle5
+       : (action == THROTTLE_6) ? actionThrottle6
+       : (action == SPEED_STOP_THEN_TOGGLE_DIRECTION) ? stopThenToggleDirection
+       : (action == MAX_THROTTLE_INCREASE) ? actionMaxThrottleIncrease
+       : (action == MAX_THROTTLE_DECREASE) ? actionMaxThrottleDecrease
+       : (action == CUSTOM_1) ? actionCustom1
+       : (action == CUSTOM_2) ? actionCustom2
+       : (action == CUSTOM_3) ? actionCustom3
+       : (action == CUSTOM_4) ? actionCustom4
+       : (action == CUSTOM_5) ? actionCustom5
+       : (action == CUSTOM_6) ? actionCustom6
+       : (action == CUSTOM_7) ? actionCustom7
+       : nullptr;
+}
+
+// for a button that only takes an action, so it can be called without checking.  Anything else does nothing
+constexpr ActionHandler getActionHandlerOrNone(int action) {
+  return (getActionHandler(action) != nullptr) ? getActionHandler(action) : actionNone;
+}
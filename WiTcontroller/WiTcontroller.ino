@@ -13,6 +13,7 @@
 // DO NOT DOWNLOAD THEM DIRECTLY!!!
 #include <WiFi.h>                 // https://github.com/espressif/arduino-esp32/tree/master/libraries/WiFi     GPL 2.1
 #include <ESPmDNS.h>              // https://github.com/espressif/arduino-esp32/blob/master/libraries/ESPmDNS  GPL 2.1
+#include <WiFiUdp.h>              // https://github.com/espressif/arduino-esp32/tree/master/libraries/WiFi     GPL 2.1
 #include <esp_wifi.h>             // https://git.liberatedsystems.co.uk/jacob.eva/arduino-esp32/src/branch/master/tools/sdk/esp32s2/include/esp_wif  GPL 2.0
 
 // ----------------------
@@ -27,6 +28,8 @@
 
 // this library is included with the WiTController code
 #include "Pangodream_18650_CL.h"  // https://github.com/pangodream/18650CL                                     Copyright (c) 2019 Pangodream
+#include "WitStream.h"
+#include "WitLog.h"
 
 // create these files by copying the example files and editing them as needed
 #include "config_network.h"      // LAN networks (SSIDs and passwords)
@@ -35,17 +38,24 @@
 // DO NOT ALTER these files
 #include "config_keypad_etc.h"
 #include "static.h"
+#include "language_tables.h"      // menu and message text for all the languages
 #include "actions.h"
 #include "WiTcontroller.h"
 
+// the messages are queued and written to the console by a low priority task. See WitLog.h
+// debug_log() messages are only compiled in if the level is at or below the level set for the subsystem
+// e.g.  debug_log(LOG_LEVEL_THROTTLE, DEBUG_LEVEL_VERBOSE, "Speed Set: ", speed);
 #if WITCONTROLLER_DEBUG == 0
- #define debug_print(params...) Serial.print(params)
- #define debug_println(params...) Serial.print(params); Serial.print(" ("); Serial.print(millis()); Serial.println(")")
- #define debug_printf(params...) Serial.printf(params)
+ WitLog witLog;
+ #define debug_print(params...) witLog.print(params)
+ #define debug_println(params...) witLog.println(params)
+ #define debug_printf(params...) witLog.printf(params)
+ #define debug_log(subsystem, level, params...) do { if ((level) <= (subsystem)) witLog.line(params); } while (0)
 #else
  #define debug_print(...)
  #define debug_println(...)
  #define debug_printf(...)
+ #define debug_log(...)
 #endif
 int debugLevel = DEBUG_LEVEL;
 
@@ -57,6 +67,14 @@ Preferences nvsPrefs;
 bool nvsInit = false;
 bool nvsPrefsSaved = false;
 bool preferencesRead = false;
+bool nvsLegacyLocoKeys = false;   // the locos were read from the old one key per loco format
+uint8_t nvsLocoRecordSaved[NVS_LOCO_RECORD_SIZE];   // what is currently in NVS, to only write when it changes
+int nvsLocoRecordSavedLength = -1;   // -1 = not known
+unsigned long nvsLastReadTime = 0;   // micros
+unsigned long nvsLastWriteTime = 0;   // micros
+unsigned long nvsWriteCount = 0;
+unsigned long nvsWriteSkippedCount = 0;
+unsigned long nvsLastAutoSaveCheck = 0;
 
 // *********************************************************************************
 
@@ -69,23 +87,58 @@ String menuCommand = "";
 bool menuIsShowing = false;
 
 String startupCommands[4] = {STARTUP_COMMAND_1, STARTUP_COMMAND_2, STARTUP_COMMAND_3, STARTUP_COMMAND_4};
+int startupActionType[4];        // STARTUP_ACTION_*
+String startupActionText[4];     // the keys, or the menu command without the * and #
+bool oledRenderSuppressed = false;  // while a batch of commands runs
+
+int currentLanguage = DEFAULT_LANGUAGE;  // LANGUAGE_... can be changed from the Extras menu
+
+// asynchronous oLED transfer.  Frames are copied into one of two buffers and a task on the other core sends them
+bool useAsyncDisplay = USE_ASYNC_DISPLAY;
+uint8_t oledFrameBuffers[2][OLED_FRAME_BUFFER_SIZE];
+volatile int oledFrameSending = -1;   // buffer the task is transferring
+volatile int oledFrameWaiting = -1;   // newest complete frame not yet picked up by the task
+portMUX_TYPE oledFrameMux = portMUX_INITIALIZER_UNLOCKED;
+TaskHandle_t oledSendTaskHandle = NULL;
+unsigned long oledFramesSent = 0;
+unsigned long oledFramesDropped = 0;   // replaced by a newer frame before the task got to them
+unsigned long oledBlockedTimeTotal = 0;  // micros the main loop spent handing over frames
+unsigned long oledBlockedTimeMax = 0;
 
 String oledText[18] = {"", "", "", "", "", "", "", "", "", "", "", "", "", "", "", "", "", ""};
 bool oledTextInvert[18] = {false, false, false, false, false, false, false, false, false, 
                            false, false, false, false, false, false, false, false, false};
 
-int currentSpeed[6];   // set to maximum possible (6)
-Direction currentDirection[6];   // set to maximum possible (6)
+// everything kept for each throttle. See ThrottleState in WiTcontroller.h
+ThrottleState throttleStates[THROTTLE_POOL_SIZE];
+
+// the consist details the throttle screen needs are worked out from the library only when they change
+uint16_t activeThrottles = 0;                     // bit per throttle that has locos
+uint16_t derivedStateDirty = 0xFFFF;              // bit per throttle to rebuild before it is next read
+uint16_t derivedStatePendingLibrary = 0;          // received changes the library has not processed yet
+unsigned long derivedStateRebuildCount = 0;
 int speedStepCurrentMultiplier = 1;
 
+// momentum
+bool useMomentum = USE_MOMENTUM;
+unsigned long momentumLastUpdateTime = 0;
+
 TrackPower trackPower = PowerUnknown;
 String turnoutPrefix = "";
 String routePrefix = "";
 
 // encoder variables
-bool circleValues = true;
-int encoderValue = 0;
-int lastEncoderValue = 0;
+// detents decoded in the encoder interrupt.  Single producer (the ISR), single consumer (rotary_loop)
+volatile int8_t encoderRingDirection[ENCODER_RING_SIZE];
+volatile unsigned long encoderRingTime[ENCODER_RING_SIZE];   // micros
+volatile uint8_t encoderRingHead = 0;   // written only by the ISR
+volatile uint8_t encoderRingTail = 0;   // written only by rotary_loop
+volatile int encoderRingOverflow = 0;   // net detents that did not fit in the ring
+portMUX_TYPE encoderRingMux = portMUX_INITIALIZER_UNLOCKED;
+volatile uint8_t encoderQuadratureState = 0;
+volatile int8_t encoderQuadratureCount = 0;
+unsigned long encoderLastDetentTime = 0;
+int8_t encoderLastDetentDirection = 0;
 
 // throttle pot values
 bool useRotaryEncoderForThrottle = USE_ROTARY_ENCODER_FOR_THROTTLE;
@@ -136,6 +189,7 @@ String selectedWitServerName ="";
 int noOfWitServices = 0;
 int witConnectionState = CONNECTION_STATE_DISCONNECTED;
 String serverType = "";
+bool useDccExNativeProtocol = USE_DCC_EX_NATIVE_PROTOCOL;
 
 //found wiThrottle servers
 IPAddress foundWitServersIPs[maxFoundWitServers];
@@ -152,7 +206,22 @@ String foundSsids[maxFoundSsids];
 long foundSsidRssis[maxFoundSsids];
 bool foundSsidsOpen[maxFoundSsids];
 int foundSsidsCount = 0;
+uint32_t foundSsidsHashes[maxFoundSsids];
+uint8_t foundSsidsChannels[maxFoundSsids];
+int8_t foundSsidsHashSet[FOUND_SSIDS_HASH_SIZE];  // index into foundSsids, -1 = empty
 int ssidSelectionSource;
+
+// ssid scan (runs in the background)
+bool ssidScanRunning = false;
+bool ssidScanIsFast = false;
+bool ssidScanFullRequested = false;        // browse was asked for, so show everything
+uint8_t ssidScanChannels[SSID_SCAN_MAX_CHANNELS];  // 0 = all
+int ssidScanChannelCount = 0;
+int ssidScanChannelIndex = 0;
+unsigned long ssidScanStartTime = 0;
+unsigned long ssidScanChannelStartTime = 0;
+uint8_t knownSsidChannels[maxSsids];       // where each of ssids[] was last found. 0 = unknown
+bool knownSsidChannelsRead = false;
 double startWaitForSelection;
 
 // wit Server ip entry
@@ -169,6 +238,7 @@ char rosterLength[maxRoster];
 char rosterSortStrings[maxRoster][14]; 
 char* rosterSortPointers[maxRoster]; 
 int rosterSortedIndex[maxRoster]; 
+char rosterLabels[maxRoster][ROSTER_LABEL_SIZE];   // by sorted position
 
 int page = 0;
 int functionPage = 0;
@@ -192,6 +262,7 @@ int turnoutListIndex[maxTurnoutList];
 String turnoutListSysName[maxTurnoutList]; 
 String turnoutListUserName[maxTurnoutList];
 int turnoutListState[maxTurnoutList];
+char turnoutListLabels[maxTurnoutList][LIST_LABEL_SIZE];
 
 // route variables
 int routeListSize = 0;
@@ -199,24 +270,77 @@ int routeListIndex[maxRouteList];
 String routeListSysName[maxRouteList]; 
 String routeListUserName[maxRouteList];
 int routeListState[maxRouteList];
-
-// function states
-bool functionStates[6][MAX_FUNCTIONS];   // set to maximum possible (6 throttles)
-
-// function labels
-String functionLabels[6][MAX_FUNCTIONS];   // set to maximum possible (6 throttles)
-
-// consist function follow
-int functionFollow[6][MAX_FUNCTIONS];   // set to maximum possible (6 throttles)
-
-// speedstep
-int currentSpeedStep[6];   // set to maximum possible (6 throttles)
+char routeListLabels[maxRouteList][LIST_LABEL_SIZE];
 
 // throttle
 int currentThrottleIndex = 0;
 char currentThrottleIndexChar = '0';
 int maxThrottles = MAX_THROTTLES;
 
+// roaming between access points with the same SSID
+bool roamingEnabled = ROAMING_ENABLED;
+int roamingAverageRssi = 0;              // 0 = no samples yet
+unsigned long roamingLastSampleTime = 0;
+unsigned long roamingLastScanTime = 0;
+unsigned long roamingLastRoamTime = 0;
+bool roamingScanRunning = false;
+bool roamingScanDone = false;
+uint8_t roamingCandidateBssid[6];
+int roamingCandidateChannel = 0;         // 0 = none
+int roamingCandidateRssi = 0;
+unsigned long roamingCandidateTime = 0;
+int roamingSimulatedRssi = 0;            // 0 = use the measured RSSI
+int roamingSimulatedCandidateRssi = 0;   // not 0 = the current access point is offered as a candidate at this RSSI
+bool roamingInProgress = false;          // reconnected after a move, and not yet back to the speeds below
+int roamingState = ROAMING_STATE_IDLE;
+unsigned long roamingStateTime = 0;
+uint32_t roamingLocalIp = 0;             // before the move. The session is only kept if it is the same after
+int roamingRestoreSpeed[THROTTLE_POOL_SIZE];
+Direction roamingRestoreDirection[THROTTLE_POOL_SIZE];
+int roamCount = 0;
+
+// link telemetry.  Round trip times from each command to its echo from the server
+unsigned long linkProbeSentTime[LINK_PROBE_COUNT][THROTTLE_POOL_SIZE];   // 0 = nothing waiting
+uint16_t linkRttSamples[LINK_RTT_SAMPLES];   // ms
+int linkRttSampleCount = 0;
+int linkRttSampleNext = 0;
+int linkRttP50 = -1;                          // -1 = no samples yet
+int linkRttP90 = -1;
+int linkRttP99 = -1;
+unsigned long linkProbesAnswered = 0;
+unsigned long linkProbesLost = 0;
+int linkRssi = 0;
+int linkRssiAverage = 0;
+int linkRssiMin = 0;
+int linkWifiConnectCount = 0;
+int linkServerConnectCount = 0;
+unsigned long linkLastTelemetryTime = 0;
+String linkLastIndicatorText = "";
+bool linkIndicatorShowsRtt = true;   // false while the next throttle's speed is in its place
+
+// fast resume.  A snapshot kept in RTC memory over deep sleep, so waking can go straight back to the throttle
+// Also used to reconnect after roaming to another access point
+bool fastResumePending = false;
+RTC_DATA_ATTR uint32_t rtcSnapshotMagic = 0;
+RTC_DATA_ATTR char rtcSnapshotSsid[33];
+RTC_DATA_ATTR char rtcSnapshotPassword[65];
+RTC_DATA_ATTR uint8_t rtcSnapshotBssid[6];
+RTC_DATA_ATTR int rtcSnapshotChannel;
+RTC_DATA_ATTR uint32_t rtcSnapshotServerIP;
+RTC_DATA_ATTR int rtcSnapshotServerPort;
+RTC_DATA_ATTR char rtcSnapshotServerName[33];
+RTC_DATA_ATTR int rtcSnapshotMaxThrottles;
+RTC_DATA_ATTR int rtcSnapshotCurrentThrottleIndex;
+RTC_DATA_ATTR int rtcSnapshotSpeedStepMultiplier;
+RTC_DATA_ATTR int rtcSnapshotSpeedStep[THROTTLE_POOL_SIZE];
+RTC_DATA_ATTR uint8_t rtcSnapshotDirection[THROTTLE_POOL_SIZE];
+RTC_DATA_ATTR uint32_t rtcSnapshotFunctions[THROTTLE_POOL_SIZE];   // one bit per function
+RTC_DATA_ATTR int rtcSnapshotLocoCount[THROTTLE_POOL_SIZE];
+RTC_DATA_ATTR char rtcSnapshotLocos[THROTTLE_POOL_SIZE][MAX_LOCOS][8];   // e.g. "L1234"
+RTC_DATA_ATTR bool rtcSnapshotTruncated;   // a loco did not fit. Use the saved locos instead
+RTC_DATA_ATTR int rtcSnapshotLanguage;
+RTC_DATA_ATTR bool rtcSnapshotNvsInit;
+
 int heartBeatPeriod = 10; // default to 10 seconds
 long lastServerResponseTime;  // seconds since start of Arduino
 bool heartbeatCheckEnabled = HEARTBEAT_ENABLED;
@@ -227,6 +351,108 @@ int lastSpeedSent = 0;
 // int lastDirectionSent = -1;
 int lastSpeedThrottleIndex = 0;
 
+// outbound command scheduler queues (one per priority class)
+int outboundQueueType[OUTBOUND_CLASS_COUNT][OUTBOUND_QUEUE_SIZE];
+char outboundQueueThrottle[OUTBOUND_CLASS_COUNT][OUTBOUND_QUEUE_SIZE];
+int outboundQueueValue[OUTBOUND_CLASS_COUNT][OUTBOUND_QUEUE_SIZE];
+String outboundQueueText[OUTBOUND_CLASS_COUNT][OUTBOUND_QUEUE_SIZE];
+bool outboundQueueState[OUTBOUND_CLASS_COUNT][OUTBOUND_QUEUE_SIZE];
+bool outboundQueueForce[OUTBOUND_CLASS_COUNT][OUTBOUND_QUEUE_SIZE];
+unsigned long outboundQueueTime[OUTBOUND_CLASS_COUNT][OUTBOUND_QUEUE_SIZE];
+bool outboundQueueLatencyTag[OUTBOUND_CLASS_COUNT][OUTBOUND_QUEUE_SIZE];   // the command of a latency benchmark scenario
+int outboundQueueCount[OUTBOUND_CLASS_COUNT] = {0, 0, 0, 0};
+unsigned long outboundLastSentTime = 0;
+unsigned long outboundMaxWait[OUTBOUND_CLASS_COUNT] = {0, 0, 0, 0};   // worst case time spent queued (ms)
+unsigned long outboundSentCount[OUTBOUND_CLASS_COUNT] = {0, 0, 0, 0};
+unsigned long outboundDroppedCount[OUTBOUND_CLASS_COUNT] = {0, 0, 0, 0};   // dropped because the queue was full
+String outboundCapture = "";   // what the protocol library wrote while capturing
+
+// loco acquisition pipeline
+char acquireQueueThrottle[ACQUIRE_QUEUE_SIZE];
+String acquireQueueLoco[ACQUIRE_QUEUE_SIZE];
+bool acquireQueueAdded[ACQUIRE_QUEUE_SIZE];   // sent, but its query is not yet
+int acquireQueueCount = 0;
+unsigned long acquireLastSendTime = 0;
+int acquireBatchThrottles = 0;   // bit per throttle, whose first loco of the batch has been sent
+bool acquireBatchActive = false;   // acquired, but the server has not finished answering yet
+unsigned long acquireBatchStartTime = 0;
+int acquireBatchLocoCount = 0;
+int acquireBatchRepliesPending = 0;   // direction replies still to come for the batch's locos
+unsigned long acquireBatchLastReplyTime = 0;
+int acquireLastBatchLocoCount = 0;    // the last batch that settled
+unsigned long acquireLastBatchTime = 0;   // ms from sending it to the last reply
+
+// inbound fast path
+bool witStreamFastParseEnabled = WIT_STREAM_FAST_PARSE;
+unsigned long witStreamStringsCreated = 0;
+unsigned long witStreamLastStatsTime = 0;
+unsigned long witStreamLastHandledCount = 0;
+unsigned long witStreamLastPassthroughCount = 0;
+unsigned long witStreamLastStringsCreated = 0;
+unsigned long witStreamLastSegmentsSent = 0;
+unsigned long witStreamLastBytesSent = 0;
+
+// latency benchmark
+#if LATENCY_BENCHMARK
+  unsigned long latencyInputTime = 0;       // micros() of the most recent input event
+  bool latencyInputPending = false;
+  int latencyScenario = LATENCY_SCENARIO_NONE;
+  unsigned long latencyScenarioStartTime = 0;
+  bool latencyWirePending = false;
+  bool latencyWireTagged = false;           // the scenario's own command has been queued
+  bool latencyWireSent = false;             // and handed to the socket, so the next flush is its wire time
+  bool latencyPixelPending = false;
+  unsigned long latencyWireSamples[LATENCY_SCENARIO_COUNT][LATENCY_BENCHMARK_SAMPLES];
+  unsigned long latencyPixelSamples[LATENCY_SCENARIO_COUNT][LATENCY_BENCHMARK_SAMPLES];
+  int latencyWireSampleCount[LATENCY_SCENARIO_COUNT] = {0, 0, 0, 0, 0};
+  int latencyPixelSampleCount[LATENCY_SCENARIO_COUNT] = {0, 0, 0, 0, 0};
+  bool latencyNewSamples = false;
+  unsigned long latencyLastReportTime = 0;
+#endif
+
+// commands received on the serial console
+#if SESSION_RECORDER || SERIAL_API
+  char serialLine[SESSION_REPLAY_LINE_SIZE];
+  int serialLineLength = 0;
+  bool serialLineOverflow = false;
+#endif
+
+#if SESSION_RECORDER || METRICS_UDP
+  unsigned long loopStageLastMark = 0;
+#endif
+
+// metrics pushed over UDP.  The loop timings are for the time since the last datagram
+#if METRICS_UDP
+  WiFiUDP metricsUdp;
+  uint8_t metricsDatagram[METRICS_DATAGRAM_SIZE];
+  int metricsDatagramLength = 0;
+  uint32_t metricsSequence = 0;
+  unsigned long metricsLastSendTime = 0;
+  unsigned long metricsStageTotal[LOOP_STAGE_COUNT];
+  unsigned long metricsStageMax[LOOP_STAGE_COUNT];
+  unsigned long metricsLoopCount = 0;
+  unsigned long metricsLoopStartTime = 0;
+  unsigned long metricsLoopMax = 0;
+#endif
+
+// session recorder and replay
+#if SESSION_RECORDER
+  bool sessionRecording = true;
+  bool sessionReplaying = false;
+  bool sessionReplayOffline = false;   // replaying without a server connection
+  float sessionReplaySpeed = 1.0;      // 1 = original timing. 0 = as fast as possible
+  unsigned long sessionReplayStartTime = 0;
+  unsigned long sessionReplayFirstEventTime = 0;
+  bool sessionReplayFirstEvent = true;
+  unsigned long sessionReplayEventCount = 0;
+  bool sessionReplayEventPending = false;
+  unsigned long sessionReplayEventTime = 0;
+
+  unsigned long loopStageTotal[LOOP_STAGE_COUNT];
+  unsigned long loopStageMax[LOOP_STAGE_COUNT];
+  unsigned long loopStageLoopCount = 0;
+#endif
+
 bool dropBeforeAcquire = DROP_BEFORE_ACQUIRE;
 
 // don't alter the assignments here
@@ -261,8 +487,34 @@ int buttonActions[14] = { CHOSEN_KEYPAD_0_FUNCTION,
                           CHOSEN_KEYPAD_D_FUNCTION
 };
 
+// handlers for the actions above, worked out when compiling. (nullptr for functions and FUNCTION_NULL)
+#if COLUMN_NUM == 4
+  const int keypadActionCount = 14;
+#else
+  const int keypadActionCount = 10;
+#endif
+constexpr ActionHandler keypadActionHandlers[keypadActionCount] = { 
+                          getActionHandler(CHOSEN_KEYPAD_0_FUNCTION),
+                          getActionHandler(CHOSEN_KEYPAD_1_FUNCTION),
+                          getActionHandler(CHOSEN_KEYPAD_2_FUNCTION),
+                          getActionHandler(CHOSEN_KEYPAD_3_FUNCTION),
+                          getActionHandler(CHOSEN_KEYPAD_4_FUNCTION),
+                          getActionHandler(CHOSEN_KEYPAD_5_FUNCTION),
+                          getActionHandler(CHOSEN_KEYPAD_6_FUNCTION),
+                          getActionHandler(CHOSEN_KEYPAD_7_FUNCTION),
+                          getActionHandler(CHOSEN_KEYPAD_8_FUNCTION),
+                          getActionHandler(CHOSEN_KEYPAD_9_FUNCTION)
+#if COLUMN_NUM == 4
+                        , getActionHandler(CHOSEN_KEYPAD_A_FUNCTION),
+                          getActionHandler(CHOSEN_KEYPAD_B_FUNCTION),
+                          getActionHandler(CHOSEN_KEYPAD_C_FUNCTION),
+                          getActionHandler(CHOSEN_KEYPAD_D_FUNCTION)
+#endif
+};
+constexpr ActionHandler encoderButtonHandler = getActionHandlerOrNone(ENCODER_BUTTON_ACTION);
+
 // text that will appear when you press #
-const String directCommandText[4][3] = {
+const char* const directCommandText[4][3] = {
     {CHOSEN_KEYPAD_1_DISPLAY_NAME, CHOSEN_KEYPAD_2_DISPLAY_NAME, CHOSEN_KEYPAD_3_DISPLAY_NAME},
     {CHOSEN_KEYPAD_4_DISPLAY_NAME, CHOSEN_KEYPAD_5_DISPLAY_NAME, CHOSEN_KEYPAD_6_DISPLAY_NAME},
     {CHOSEN_KEYPAD_7_DISPLAY_NAME, CHOSEN_KEYPAD_8_DISPLAY_NAME, CHOSEN_KEYPAD_9_DISPLAY_NAME},
@@ -300,6 +552,16 @@ bool oledDirectCommandsAreBeingDisplayed = false;
                             ADDITIONAL_BUTTON_6_LATCHING
   };
 
+  constexpr ActionHandler additionalButtonHandlers[MAX_ADDITIONAL_BUTTONS] = {
+                            getActionHandler(CHOSEN_ADDITIONAL_BUTTON_0_FUNCTION),
+                            getActionHandler(CHOSEN_ADDITIONAL_BUTTON_1_FUNCTION),
+                            getActionHandler(CHOSEN_ADDITIONAL_BUTTON_2_FUNCTION),
+                            getActionHandler(CHOSEN_ADDITIONAL_BUTTON_3_FUNCTION),
+                            getActionHandler(CHOSEN_ADDITIONAL_BUTTON_4_FUNCTION),
+                            getActionHandler(CHOSEN_ADDITIONAL_BUTTON_5_FUNCTION),
+                            getActionHandler(CHOSEN_ADDITIONAL_BUTTON_6_FUNCTION)
+  };
+
   unsigned long lastAdditionalButtonDebounceTime[MAX_ADDITIONAL_BUTTONS];  // the last time the output pin was toggled
   bool additionalButtonRead[MAX_ADDITIONAL_BUTTONS];
   bool additionalButtonLastRead[MAX_ADDITIONAL_BUTTONS];
@@ -311,6 +573,7 @@ bool oledDirectCommandsAreBeingDisplayed = false;
     int additionalButtonType[NEW_MAX_ADDITIONAL_BUTTONS] = NEW_ADDITIONAL_BUTTON_TYPE;
     int additionalButtonActions[NEW_MAX_ADDITIONAL_BUTTONS] = NEW_ADDITIONAL_BUTTON_ACTIONS;
     int additionalButtonLatching[NEW_MAX_ADDITIONAL_BUTTONS] = NEW_ADDITIONAL_BUTTON_LATCHING;
+    ActionHandler additionalButtonHandlers[NEW_MAX_ADDITIONAL_BUTTONS];  // filled in by initialiseAdditionalButtons()
 
     unsigned long lastAdditionalButtonDebounceTime[NEW_MAX_ADDITIONAL_BUTTONS];  // the last time the output pin was toggled
     bool additionalButtonRead[NEW_MAX_ADDITIONAL_BUTTONS];
@@ -321,6 +584,7 @@ bool oledDirectCommandsAreBeingDisplayed = false;
     int additionalButtonType[1] = {INPUT_PULLUP};
     int additionalButtonActions[1] = {FUNCTION_NULL};
     int additionalButtonLatching[1] = {false};
+    ActionHandler additionalButtonHandlers[1] = {nullptr};
 
     unsigned long lastAdditionalButtonDebounceTime[1];  // the last time the output pin was toggled
     bool additionalButtonRead[1];
@@ -338,6 +602,7 @@ void displayUpdateFromWit(int multiThrottleIndex) {
   debug_print(" menuIsShowing "); debug_print(menuIsShowing);
   debug_print(" multiThrottleIndex "); debug_print(multiThrottleIndex);
   debug_println("");
+  if (acquireBatchActive) return;  // drawn once the acquisition has settled
   if ( (keypadUseType == KEYPAD_USE_OPERATION) && (!menuIsShowing) 
   && (multiThrottleIndex==currentThrottleIndex) ) {
     writeOledSpeed();
@@ -366,6 +631,7 @@ class MyDelegate : public WiThrottleProtocolDelegate {
         turnoutPrefix = DCC_EX_TURNOUT_PREFIX;
         routePrefix = DCC_EX_ROUTE_PREFIX;
       }
+      selectThrottleBackend();
     }
     void receivedMessage(String message) {
       debug_print("Broadcast Message: ");
@@ -389,33 +655,38 @@ class MyDelegate : public WiThrottleProtocolDelegate {
       }
     }
     void receivedSpeedMultiThrottle(char multiThrottle, int speed) {             // Vnnn
-      debug_print("Received Speed: ("); debug_print(millis()); debug_print(") throttle: "); debug_print(multiThrottle);  debug_print(" speed: "); debug_println(speed); 
+      debug_log(LOG_LEVEL_SERVER, DEBUG_LEVEL_VERBOSE, "Received Speed: throttle: ", multiThrottle, " speed: ", speed);
       int multiThrottleIndex = getMultiThrottleIndex(multiThrottle);
 
-      if (currentSpeed[multiThrottleIndex] != speed) {
+      if (throttleStates[multiThrottleIndex].speed != speed) {
         
         // check for bounce. (intermediate speed sent back from the server, but is not up to date with the throttle)
-        if ( (lastSpeedThrottleIndex!=multiThrottleIndex)
-             || ((millis()-lastSpeedSentTime)>500)
+        if ( ( (lastSpeedThrottleIndex!=multiThrottleIndex)
+               || ((millis()-lastSpeedSentTime)>500) )
+             && (!momentumIsRamping(multiThrottleIndex))
         ) {
-          currentSpeed[multiThrottleIndex] = speed;
+          throttleStates[multiThrottleIndex].speed = speed;
+          throttleStates[multiThrottleIndex].momentumTargetSpeed = speed;
+          throttleStates[multiThrottleIndex].momentumSpeedFixed = ((long) speed) << 8;
           displayUpdateFromWit(multiThrottleIndex);
         } else {
-          debug_print("Received Speed: skipping response: ("); debug_print(millis()); debug_print(") speed: "); debug_println(speed);
+          debug_log(LOG_LEVEL_SERVER, DEBUG_LEVEL_VERBOSE, "Received Speed: skipping response: speed: ", speed);
         }
       }
     }
     void receivedDirectionMultiThrottle(char multiThrottle, Direction dir) {     // R{0,1}
-      debug_print("Received Direction: "); debug_println(dir); 
+      debug_log(LOG_LEVEL_SERVER, DEBUG_LEVEL_VERBOSE, "Received Direction: ", dir);
       int multiThrottleIndex = getMultiThrottleIndex(multiThrottle);
 
-      if (currentDirection[multiThrottleIndex] != dir) {
-        currentDirection[multiThrottleIndex] = dir;
+      if (throttleStates[multiThrottleIndex].direction != dir) {
+        throttleStates[multiThrottleIndex].direction = dir;
         displayUpdateFromWit(multiThrottleIndex);
       }
     }
     void receivedDirectionMultiThrottle(char multiThrottle, String loco, Direction dir) {     // R{0,1}
-      debug_print("Received Direction: loco: "); debug_print(loco); debug_print(" Received Direction: "); debug_println(dir); 
+      debug_log(LOG_LEVEL_SERVER, DEBUG_LEVEL_VERBOSE, "Received Direction: loco: ", loco, " Received Direction: ", dir);
+      invalidateDerivedState(getMultiThrottleIndex(multiThrottle));
+      acquireReplyReceived();
       // int multiThrottleIndex = getMultiThrottleIndex(multiThrottle);
 
       // if (wiThrottleProtocol.getNumberOfLocomotives(currentThrottleIndexChar) > 0) {
@@ -428,11 +699,11 @@ class MyDelegate : public WiThrottleProtocolDelegate {
       // }
     }
     void receivedFunctionStateMultiThrottle(char multiThrottle, uint8_t func, bool state) { 
-      debug_print("Received Fn: "); debug_print(func); debug_print(" State: "); debug_println( (state) ? "True" : "False" );
+      debug_log(LOG_LEVEL_SERVER, DEBUG_LEVEL_VERBOSE, "Received Fn: ", func, " State: ", (state) ? "True" : "False");
       int multiThrottleIndex = getMultiThrottleIndex(multiThrottle);
 
-      if (functionStates[multiThrottleIndex][func] != state) {
-        functionStates[multiThrottleIndex][func] = state;
+      if (getFunctionState(multiThrottleIndex, func) != state) {
+        setFunctionState(multiThrottleIndex, func, state);
         displayUpdateFromWit(multiThrottleIndex);
       }
     }
@@ -441,9 +712,10 @@ class MyDelegate : public WiThrottleProtocolDelegate {
       int multiThrottleIndex = getMultiThrottleIndex(multiThrottle);
 
       for(int i = 0; i < MAX_FUNCTIONS; i++) {
-        functionLabels[multiThrottleIndex][i] = functions[i];
+        throttleStates[multiThrottleIndex].functionLabels[i] = functions[i];
         debug_print(" Function: "); debug_print(i); debug_print(" - "); debug_println( functions[i] );
       }
+      buildFunctionListLabels(multiThrottleIndex);
     }
     void receivedTrackPower(TrackPower state) { 
       debug_print("Received TrackPower: "); debug_println(state);
@@ -456,6 +728,7 @@ class MyDelegate : public WiThrottleProtocolDelegate {
     void receivedRosterEntries(int size) {
       debug_print("Received Roster Entries. Size: "); debug_println(size);
       rosterSize = (size<maxRoster) ? size : maxRoster;
+      invalidateDerivedState(-1);  // the loco names may change
 
       if (rosterSize==0) {
         setupPreferences(false);  // if not roster read the prefeences immediately otherwise wait till we get them all
@@ -469,6 +742,7 @@ class MyDelegate : public WiThrottleProtocolDelegate {
         rosterName[index] = name; 
         rosterAddress[index] = address;
         rosterLength[index] = length;
+        buildRosterLabel(index);  // replaced once sorted
 
         if (ROSTER_SORT_SEQUENCE == 1) {
           strncpy(rosterSortStrings[index], ((name+"          ").substring(0,10) + ":" + (index < 10 ? "0" : "") + String(index)).c_str(), 13);
@@ -485,6 +759,7 @@ class MyDelegate : public WiThrottleProtocolDelegate {
           for (int i=0; i<rosterSize; i++) {
             rosterSortedIndex[i] = (rosterSortPointers[i][11]-'0')*10 + (rosterSortPointers[i][12]-'0');
             debug_print("Roster sorted: "); debug_print(rosterSortPointers[i]); debug_print(" | "); debug_println(rosterName[rosterSortedIndex[i]]);
+            buildRosterLabel(i);
           }
 
           setupPreferences(false);  // if there is a roster, we will have waited 
@@ -494,7 +769,7 @@ class MyDelegate : public WiThrottleProtocolDelegate {
 
       #if ACQUIRE_ROSTER_ENTRY_IF_ONLY_ONE
         if ( (rosterSize == 1) && (index == 0) ) {
-          doOneStartupCommand("*1#0");
+          selectRoster(0);
         }
       #endif
 
@@ -509,6 +784,7 @@ class MyDelegate : public WiThrottleProtocolDelegate {
         turnoutListSysName[index] = sysName; 
         turnoutListUserName[index] = userName;
         turnoutListState[index] = state;
+        buildTurnoutOrRouteLabel(turnoutListLabels[index], index, userName);
       }
       receivingServerInfoOled(index, turnoutListSize);
     }
@@ -523,6 +799,7 @@ class MyDelegate : public WiThrottleProtocolDelegate {
         routeListSysName[index] = sysName; 
         routeListUserName[index] = userName;
         routeListState[index] = state;
+        buildTurnoutOrRouteLabel(routeListLabels[index], index, userName);
       }
       receivingServerInfoOled(index, routeListSize);
     }
@@ -552,7 +829,7 @@ class MyDelegate : public WiThrottleProtocolDelegate {
 
 int getMultiThrottleIndex(char multiThrottle) {
     int mThrottle = multiThrottle - '0';
-    if ((mThrottle >= 0) && (mThrottle<=5)) {
+    if ((mThrottle >= 0) && (mThrottle<THROTTLE_POOL_SIZE)) {
         return mThrottle;
     } else {
         return 0;
@@ -564,10 +841,401 @@ char getMultiThrottleChar(int multiThrottleIndex) {
 }
 
 WiFiClient client;
+WitStream witStream;   // between the client and the protocol library
 WiThrottleProtocol wiThrottleProtocol;
 MyDelegate myDelegate;
 int deviceId = random(1000,9999);
 
+// *********************************************************************************
+//  Protocol backends
+// *********************************************************************************
+// The outbound command scheduler sends the throttle commands (speed, direction, functions, power, 
+// turnouts, routes, E Stop) through a backend.  The WiThrottle protocol is always used for the 
+// session itself (acquire/release, roster, heartbeat etc.).
+// With USE_DCC_EX_NATIVE_PROTOCOL, DCC-EX command stations are sent native <...> commands 
+// instead, which the command station does not need to translate.
+
+class ThrottleBackend {
+  public:
+    virtual const char* getName() = 0;
+    virtual void setSpeed(char multiThrottle, int speed) = 0;
+    // loco "" = all the locos on the throttle
+    virtual void setDirection(char multiThrottle, String loco, Direction direction, bool force) = 0;
+    // loco "" = lead loco only, "*" = all the locos on the throttle
+    virtual void setFunction(char multiThrottle, String loco, int functionNumber, bool pressed, bool force) = 0;
+    virtual void setTrackPower(TrackPower state) = 0;
+    virtual void setTurnout(String turnout, TurnoutAction action) = 0;
+    virtual void setRoute(String route) = 0;
+    // multiThrottle '*' = all throttles
+    virtual void emergencyStop(char multiThrottle) = 0;
+    virtual ~ThrottleBackend() {}
+};
+
+class WiThrottleBackend : public ThrottleBackend {
+  public:
+    const char* getName() { return "WiThrottle"; }
+    void setSpeed(char multiThrottle, int speed) {
+      wiThrottleProtocol.setSpeed(multiThrottle, speed);
+    }
+    void setDirection(char multiThrottle, String loco, Direction direction, bool force) {
+      if (loco.equals("")) {
+        wiThrottleProtocol.setDirection(multiThrottle, direction);
+      } else {
+        wiThrottleProtocol.setDirection(multiThrottle, loco, direction, force);
+      }
+      invalidateDerivedState(getMultiThrottleIndex(multiThrottle));
+    }
+    void setFunction(char multiThrottle, String loco, int functionNumber, bool pressed, bool force) {
+      wiThrottleProtocol.setFunction(multiThrottle, loco, functionNumber, pressed, force);
+    }
+    void setTrackPower(TrackPower state) {
+      wiThrottleProtocol.setTrackPower(state);
+    }
+    void setTurnout(String turnout, TurnoutAction action) {
+      wiThrottleProtocol.setTurnout(turnout, action);
+    }
+    void setRoute(String route) {
+      wiThrottleProtocol.setRoute(route);
+    }
+    void emergencyStop(char multiThrottle) {
+      if (multiThrottle == '*') {
+        wiThrottleProtocol.emergencyStop();
+      } else {
+        wiThrottleProtocol.emergencyStop(multiThrottle);
+      }
+    }
+};
+
+WiThrottleBackend wiThrottleBackend;
+
+// Native DCC-EX commands.  Sent on the same connection as the WiThrottle session.
+//   <t cab speed dir>  <F cab function state>  <T id 0|1>  </START id>  <1>  <0>  <!>
+// Direction changes are still sent as WiThrottle commands, so that the library keeps track of which 
+// way each loco in a consist is facing.  The native speed commands use that to set each loco's direction.
+class DccExBackend : public ThrottleBackend {
+  public:
+    const char* getName() { return "DCC-EX native"; }
+    void setSpeed(char multiThrottle, int speed) {
+      sendThrottle(multiThrottle, speed);
+    }
+    void setDirection(char multiThrottle, String loco, Direction direction, bool force) {
+      wiThrottleBackend.setDirection(multiThrottle, loco, direction, force);
+    }
+    void setFunction(char multiThrottle, String loco, int functionNumber, bool pressed, bool force) {
+      // The native command has no latching information.  A momentary function is on while pressed, 
+      // otherwise a press toggles the function and the release is ignored.
+      // Forced (additional button) functions are set to exactly the state given.
+      bool state = pressed;
+      if ( (!force) && (!isMomentary(getMultiThrottleIndex(multiThrottle), functionNumber)) ) {
+        if (!pressed) return;
+        state = !getFunctionState(getMultiThrottleIndex(multiThrottle), functionNumber);
+      }
+      int locoCount = wiThrottleProtocol.getNumberOfLocomotives(multiThrottle);
+      for (int i=0; i<locoCount; i++) {
+        if ( (i > 0) && (!loco.equals("*")) ) break;  // lead only
+        String cab = wiThrottleProtocol.getLocomotiveAtPosition(multiThrottle, i).substring(1);
+        witStream.print("<F " + cab + " " + String(functionNumber) + " " + String(state ? 1 : 0) + ">");
+      }
+      if (locoCount > 0) {  // no echo from the server, so update the display here
+        myDelegate.receivedFunctionStateMultiThrottle(multiThrottle, functionNumber, state);
+      }
+    }
+    void setTrackPower(TrackPower state) {
+      witStream.print( (state == PowerOn) ? "<1>" : "<0>" );
+    }
+    void setTurnout(String turnout, TurnoutAction action) {
+      if (action == TurnoutToggle) {
+        action = TurnoutThrow;
+        for (int i=0; i<turnoutListSize; i++) {
+          if ( (turnoutListSysName[i].equals(turnout)) && (turnoutListState[i] == TurnoutThrown) ) {
+            action = TurnoutClose;
+            break;
+          }
+        }
+      }
+      witStream.print("<T " + turnout + ((action == TurnoutThrow) ? " 1>" : " 0>"));
+    }
+    void setRoute(String route) {
+      if ( (routePrefix.length() > 0) && (route.startsWith(routePrefix)) ) {
+        route = route.substring(routePrefix.length());
+      }
+      witStream.print("</START " + route + ">");
+    }
+    void emergencyStop(char multiThrottle) {
+      if (multiThrottle == '*') {
+        witStream.print("<!>");
+      } else {
+        sendThrottle(multiThrottle, -1);
+      }
+    }
+
+  private:
+    // '*' at the start of the label is how the DCC-EX roster marks a momentary function
+    bool isMomentary(int multiThrottleIndex, int functionNumber) {
+      if ((DCC_EX_MOMENTARY_FUNCTIONS >> functionNumber) & 1) return true;
+      return throttleStates[multiThrottleIndex].functionLabels[functionNumber].startsWith("*");
+    }
+
+    // <t> always carries the direction as well as the speed, so the direction of each loco 
+    // is worked out from which way it faces compared to the lead loco
+    void sendThrottle(char multiThrottle, int speed) {
+      int locoCount = wiThrottleProtocol.getNumberOfLocomotives(multiThrottle);
+      if (locoCount == 0) return;
+      Direction direction = throttleStates[getMultiThrottleIndex(multiThrottle)].direction;
+      Direction reverseFacingDirection = (direction == Forward) ? Reverse : Forward;
+      String leadLoco = wiThrottleProtocol.getLocomotiveAtPosition(multiThrottle, 0);
+      Direction leadLocoDirection = wiThrottleProtocol.getDirection(multiThrottle, leadLoco);
+      for (int i=0; i<locoCount; i++) {
+        String loco = (i == 0) ? leadLoco : wiThrottleProtocol.getLocomotiveAtPosition(multiThrottle, i);
+        bool reverseFacing = (i > 0) && (wiThrottleProtocol.getDirection(multiThrottle, loco) != leadLocoDirection);
+        witStream.print("<t " + loco.substring(1) + " " + String(speed) + " " 
+                        + String(((reverseFacing ? reverseFacingDirection : direction) == Forward) ? 1 : 0) + ">");
+      }
+    }
+};
+
+DccExBackend dccExBackend;
+ThrottleBackend *throttleBackend = &wiThrottleBackend;
+
+void selectThrottleBackend() {
+  if ( (useDccExNativeProtocol) && (serverType.equals("DCC-EX")) ) {
+    throttleBackend = &dccExBackend;
+  } else {
+    throttleBackend = &wiThrottleBackend;
+  }
+  debug_print("Throttle backend: "); debug_println(throttleBackend->getName());
+}
+
+// *********************************************************************************
+//  Inbound fast path
+// *********************************************************************************
+// The most frequent messages from the server (speed, function state, roster/turnout/route lists)
+// are parsed directly from the receive buffer (no String copies of the line) and passed to the delegate.
+// Everything else (including direction, which the library needs to keep track of) goes to the library as normal.
+// Speed and function state need no Strings at all.  The list entries are still made into Strings,
+// one per name, as that is how they are stored.  The heartbeat ('*') is left to the library, as it keeps the period itself.
+
+int sliceToInt(const char* text, int length) {
+  int result = 0;
+  bool negative = false;
+  int i = 0;
+  if ( (length > 0) && (text[0] == '-') ) { negative = true; i++; }
+  for (; i<length; i++) {
+    if ( (text[i] < '0') || (text[i] > '9') ) break;
+    result = result * 10 + (text[i] - '0');
+  }
+  return (negative) ? -result : result;
+}
+
+int sliceIndexOf(const char* text, int length, const char* find, int from) {
+  int findLength = strlen(find);
+  for (int i=from; i<=length-findLength; i++) {
+    if (strncmp(text+i, find, findLength) == 0) return i;
+  }
+  return -1;
+}
+
+// one allocation, sized up front
+String sliceToString(const char* text, int length) {
+  String result;
+  result.reserve(length);
+  for (int i=0; i<length; i++) result += text[i];
+  witStreamStringsCreated++;
+  return result;
+}
+
+bool witStreamFastParse(const char* line, int length) {
+  derivedStateInboundLine(line, length);
+  linkInboundLine(line, length);
+  if (!witStreamFastParseEnabled) return false;
+  if (length < 3) return false;
+
+  switch (line[0]) {
+    case 'M': 
+      if (line[2] == 'A') return witStreamParseLocoAction(line, length);
+      break;
+    case '<':
+      if (throttleBackend == &dccExBackend) return witStreamParseDccExBroadcast(line, length);
+      break;
+    case 'R': 
+      if (line[1] == 'L') return witStreamParseRosterList(line, length);
+      break;
+    case 'P': 
+      if ( (line[2] == 'L') && ((line[1] == 'T') || (line[1] == 'R')) ) return witStreamParseTurnoutOrRouteList(line, length, (line[1] == 'T'));
+      break;
+  }
+  return false;
+}
+
+// M{multiThrottle}A{loco}<;>V{speed}    or    M{multiThrottle}A{loco}<;>F{state}{function}
+bool witStreamParseLocoAction(const char* line, int length) {
+  char multiThrottleChar = line[1];
+  int separator = sliceIndexOf(line, length, WIT_PROPERTY_SEPARATOR, 3);
+  if ( (separator < 0) || (separator+4 > length) ) return false;
+  const char* loco = line + 3;
+  int locoLength = separator - 3;
+  const char* property = line + separator + 3;
+  int propertyLength = length - separator - 3;
+
+  switch (property[0]) {
+    case 'V': {
+        myDelegate.receivedSpeedMultiThrottle(multiThrottleChar, sliceToInt(property+1, propertyLength-1));
+        return true;
+      }
+    case 'F': {
+        if (propertyLength < 3) return false;
+        if ( (locoLength != 1) || (loco[0] != '*') ) { // only the lead loco's functions are shown. leave the rest to the library
+          String leadLoco = wiThrottleProtocol.getLeadLocomotive(multiThrottleChar);
+          if ( (leadLoco.length() != (unsigned int) locoLength) || (strncmp(leadLoco.c_str(), loco, locoLength) != 0) ) return false;
+        }
+        int functionNumber = sliceToInt(property+2, propertyLength-2);
+        if ( (functionNumber < 0) || (functionNumber >= MAX_FUNCTIONS) ) return false;
+        myDelegate.receivedFunctionStateMultiThrottle(multiThrottleChar, functionNumber, (property[1] == '1'));
+        return true;
+      }
+  }
+  return false;
+}
+
+// RL{count}]\[{name}}|{{address}}|{{length}]\[...
+bool witStreamParseRosterList(const char* line, int length) {
+  int entryStart = sliceIndexOf(line, length, WIT_ENTRY_SEPARATOR, 2);
+  int count = sliceToInt(line+2, ((entryStart < 0) ? length : entryStart) - 2);
+  myDelegate.receivedRosterEntries(count);
+
+  int index = 0;
+  while ( (entryStart >= 0) && (index < count) ) {
+    entryStart = entryStart + strlen(WIT_ENTRY_SEPARATOR);
+    int entryEnd = sliceIndexOf(line, length, WIT_ENTRY_SEPARATOR, entryStart);
+    if (entryEnd < 0) entryEnd = length;
+
+    int nameEnd = sliceIndexOf(line, entryEnd, WIT_SEGMENT_SEPARATOR, entryStart);
+    if (nameEnd < 0) break;
+    int addressStart = nameEnd + strlen(WIT_SEGMENT_SEPARATOR);
+    int addressEnd = sliceIndexOf(line, entryEnd, WIT_SEGMENT_SEPARATOR, addressStart);
+    if (addressEnd < 0) break;
+    int lengthStart = addressEnd + strlen(WIT_SEGMENT_SEPARATOR);
+    char addressLength = (lengthStart < entryEnd) ? line[lengthStart] : 'S';
+
+    myDelegate.receivedRosterEntry(index, sliceToString(line+entryStart, nameEnd-entryStart), 
+                                   sliceToInt(line+addressStart, addressEnd-addressStart), addressLength);
+    index++;
+    entryStart = (entryEnd < length) ? entryEnd : -1;
+  }
+  return true;
+}
+
+// PTL]\[{sysName}}|{{userName}}|{{state}]\[...     or    PRL]\[...
+bool witStreamParseTurnoutOrRouteList(const char* line, int length, bool isTurnouts) {
+  int count = 0;
+  int entryStart = sliceIndexOf(line, length, WIT_ENTRY_SEPARATOR, 3);
+  for (int i=entryStart; i>=0; i=sliceIndexOf(line, length, WIT_ENTRY_SEPARATOR, i+1)) count++;
+
+  if (isTurnouts) {
+    myDelegate.receivedTurnoutEntries(count);
+  } else {
+    myDelegate.receivedRouteEntries(count);
+  }
+
+  int index = 0;
+  while (entryStart >= 0) {
+    entryStart = entryStart + strlen(WIT_ENTRY_SEPARATOR);
+    int entryEnd = sliceIndexOf(line, length, WIT_ENTRY_SEPARATOR, entryStart);
+    if (entryEnd < 0) entryEnd = length;
+
+    int sysNameEnd = sliceIndexOf(line, entryEnd, WIT_SEGMENT_SEPARATOR, entryStart);
+    if (sysNameEnd < 0) sysNameEnd = entryEnd;
+    int userNameStart = (sysNameEnd < entryEnd) ? sysNameEnd + strlen(WIT_SEGMENT_SEPARATOR) : entryEnd;
+    int userNameEnd = sliceIndexOf(line, entryEnd, WIT_SEGMENT_SEPARATOR, userNameStart);
+    if (userNameEnd < 0) userNameEnd = entryEnd;
+    int stateStart = (userNameEnd < entryEnd) ? userNameEnd + strlen(WIT_SEGMENT_SEPARATOR) : entryEnd;
+    int state = sliceToInt(line+stateStart, entryEnd-stateStart);
+
+    String sysName = sliceToString(line+entryStart, sysNameEnd-entryStart);
+    String userName = sliceToString(line+userNameStart, userNameEnd-userNameStart);
+    if (isTurnouts) {
+      myDelegate.receivedTurnoutEntry(index, sysName, userName, state);
+    } else {
+      myDelegate.receivedRouteEntry(index, sysName, userName, state);
+    }
+    index++;
+    entryStart = (entryEnd < length) ? entryEnd : -1;
+  }
+  return true;
+}
+
+// DCC-EX sends native broadcasts once native commands have been used on the connection
+// <l cab reg speedByte functionMap>
+bool witStreamParseDccExBroadcast(const char* line, int length) {
+  if ( (length < 4) || (line[1] != 'l') ) return true;  // other native responses are not used
+
+  int values[4] = {0, 0, 0, 0};
+  int valueCount = 0;
+  int i = 2;
+  while ( (i < length) && (valueCount < 4) ) {
+    while ( (i < length) && (line[i] == ' ') ) i++;
+    int start = i;
+    while ( (i < length) && (line[i] != ' ') && (line[i] != '>') ) i++;
+    if (i == start) break;
+    values[valueCount] = sliceToInt(line+start, i-start);
+    valueCount++;
+  }
+  if (valueCount < 4) return true;
+
+  int cab = values[0];
+  int speedByte = values[2];
+  Direction direction = (speedByte & 0x80) ? Forward : Reverse;
+  int speed = speedByte & 0x7F;
+  speed = (speed <= 1) ? 0 : speed - 1;   // 1 = emergency stop
+
+  for (int throttleIndex=0; throttleIndex<maxThrottles; throttleIndex++) {
+    char multiThrottleChar = getMultiThrottleChar(throttleIndex);
+    if (wiThrottleProtocol.getNumberOfLocomotives(multiThrottleChar) == 0) continue;
+    if (wiThrottleProtocol.getLeadLocomotive(multiThrottleChar).substring(1).toInt() != cab) continue;
+
+    ThrottleState *throttle = &throttleStates[throttleIndex];
+    if (throttle->speed != speed) myDelegate.receivedSpeedMultiThrottle(multiThrottleChar, speed);
+    if (throttle->direction != direction) myDelegate.receivedDirectionMultiThrottle(multiThrottleChar, direction);
+    uint32_t changed = (((uint32_t) values[3]) ^ throttle->functionStates) & 0x1FFFFFFFUL;  // only the functions (F0-F28) that have changed
+    for (int functionNumber=0; changed != 0; functionNumber++, changed >>= 1) {
+      if (changed & 1) myDelegate.receivedFunctionStateMultiThrottle(multiThrottleChar, functionNumber, (values[3] >> functionNumber) & 1);
+    }
+  }
+  return true;
+}
+
+// messages per second through the fast path and the library, and the writes sent. Debug output only
+void witStreamStatsLoop() {
+  if (millis() - witStreamLastStatsTime < 10000) return;
+  unsigned long elapsed = millis() - witStreamLastStatsTime;
+  witStreamLastStatsTime = millis();
+
+  unsigned long handled = witStream.getHandledLineCount() - witStreamLastHandledCount;
+  unsigned long passthrough = witStream.getPassthroughLineCount() - witStreamLastPassthroughCount;
+  unsigned long stringsCreated = witStreamStringsCreated - witStreamLastStringsCreated;
+  witStreamLastHandledCount = witStream.getHandledLineCount();
+  witStreamLastPassthroughCount = witStream.getPassthroughLineCount();
+  witStreamLastStringsCreated = witStreamStringsCreated;
+
+  unsigned long segments = witStream.getSegmentsSent() - witStreamLastSegmentsSent;
+  unsigned long bytesSent = witStream.getBytesSent() - witStreamLastBytesSent;
+  witStreamLastSegmentsSent = witStream.getSegmentsSent();
+  witStreamLastBytesSent = witStream.getBytesSent();
+
+  if ( (handled > 0) || (passthrough > 0) ) {
+    debug_print("inbound msgs/s - fast: "); debug_print(handled * 1000.0 / elapsed);
+    debug_print(" library: "); debug_print(passthrough * 1000.0 / elapsed);
+    debug_print(" strings per fast msg: "); debug_println( (handled > 0) ? (float) stringsCreated / handled : 0.0);
+  }
+  if (segments > 0) {
+    debug_print("outbound - writes: "); debug_print(segments); 
+    debug_print(" bytes: "); debug_print(bytesSent);
+    debug_print(" (total writes: "); debug_print(witStream.getSegmentsSent()); 
+    debug_print(" bytes: "); debug_print(witStream.getBytesSent()); debug_println(")");
+  }
+}
+
+
 // *********************************************************************************
 // wifi / SSID 
 // *********************************************************************************
@@ -580,6 +1248,10 @@ void ssidsLoop() {
       browseSsids();
     }
   }
+
+  if (ssidConnectionState == CONNECTION_STATE_SCANNING) {
+    browseSsidsLoop();
+  }
   
   if (ssidConnectionState == CONNECTION_STATE_PASSWORD_ENTRY) {
     enterSsidPassword();
@@ -590,78 +1262,262 @@ void ssidsLoop() {
   }
 }
 
-void browseSsids() { // show the found SSIDs
+void browseSsids() { // start looking for SSIDs.  browseSsidsLoop() shows them when found
   debug_println("browseSsids()");
 
-  double startTime = millis();
-  double nowTime = startTime;
-
   debug_println("Browsing for ssids");
   clearOledArray(); 
   setAppnameForOled();
-  oledText[2] = MSG_BROWSING_FOR_SSIDS;
+  oledText[2] = getText(TEXT_MSG_BROWSING_FOR_SSIDS);
   writeOledBattery();
   writeOledArray(false, false, true, true);
 
+  stopSsidScan();
   WiFi.setScanMethod(WIFI_ALL_CHANNEL_SCAN);
   WiFi.setSortMethod(WIFI_CONNECT_AP_BY_SIGNAL);
-  
-  int numSsids = WiFi.scanNetworks();
-  while ( (numSsids == -1)
-    && ((nowTime-startTime) <= 10000) ) { // try for 10 seconds
-    delay(250);
-    debug_print(".");
-    nowTime = millis();
-  }
 
-  startWaitForSelection = millis();
+  readKnownSsidChannels();
+  ssidScanChannelCount = 0;
+  if ( (SSID_FAST_SCAN_KNOWN_CHANNELS) && (!ssidScanFullRequested) ) {
+    for (int i=0; i<maxSsids; i++) {
+      bool listed = (knownSsidChannels[i] == 0);
+      for (int j=0; j<ssidScanChannelCount; j++) {
+        if (ssidScanChannels[j] == knownSsidChannels[i]) listed = true;
+      }
+      if ( (!listed) && (ssidScanChannelCount < SSID_SCAN_MAX_CHANNELS) ) {
+        ssidScanChannels[ssidScanChannelCount] = knownSsidChannels[i];
+        ssidScanChannelCount++;
+      }
+    }
+  }
+  ssidScanIsFast = (ssidScanChannelCount > 0);
+  if (!ssidScanIsFast) {
+    ssidScanChannels[0] = 0;
+    ssidScanChannelCount = 1;
+  }
+  ssidScanFullRequested = false;
 
   foundSsidsCount = 0;
-  if (numSsids == -1) {
-    debug_println("Couldn't get a wifi connection");
+  for (int i=0; i<FOUND_SSIDS_HASH_SIZE; i++) foundSsidsHashSet[i] = -1;
 
-  } else {
-    for (int thisSsid = 0; thisSsid < numSsids; thisSsid++) {
-      /// remove duplicates (repeaters and mesh networks)
-      bool found = false;
-      for (int i=0; i<foundSsidsCount && i<maxFoundSsids; i++) {
-        if (WiFi.SSID(thisSsid) == foundSsids[i]) {
-          found = true;
-          break;
-        }
-      }
-      if (!found) {
-        foundSsids[foundSsidsCount] = WiFi.SSID(thisSsid);
-        foundSsidRssis[foundSsidsCount] = WiFi.RSSI(thisSsid);
-        foundSsidsOpen[foundSsidsCount] = (WiFi.encryptionType(thisSsid) == 7) ? true : false;
-        foundSsidsCount++;
+  ssidScanStartTime = millis();
+  ssidScanChannelIndex = 0;
+  startSsidScan();
+  ssidConnectionState = CONNECTION_STATE_SCANNING;
+}
+
+void startSsidScan() {
+  debug_print("Scanning for ssids on channel: "); debug_println(ssidScanChannels[ssidScanChannelIndex]);  // 0 = all
+  WiFi.scanNetworks(true, false, false, SSID_SCAN_TIME_PER_CHANNEL, ssidScanChannels[ssidScanChannelIndex]);
+  ssidScanRunning = true;
+  ssidScanChannelStartTime = millis();
+}
+
+// abandon the scan if an SSID is picked from the list before it finishes
+void stopSsidScan() {
+  if (!ssidScanRunning) return;
+  esp_wifi_scan_stop();
+  WiFi.scanDelete();
+  ssidScanRunning = false;
+}
+
+void browseSsidsLoop() {
+  int numSsids = WiFi.scanComplete();
+  if (numSsids == WIFI_SCAN_RUNNING) {
+    if ((millis() - ssidScanChannelStartTime) <= SSID_SCAN_TIMEOUT) return;
+    debug_println("Scan timed out");
+    stopSsidScan();
+    numSsids = 0;
+  }
+  ssidScanRunning = false;
+
+  if (numSsids > 0) {
+    mergeSsidScanResults(numSsids);
+  }
+  WiFi.scanDelete();
+
+  ssidScanChannelIndex++;
+  if (ssidScanChannelIndex < ssidScanChannelCount) {
+    startSsidScan();
+    return;
+  }
+
+  bool foundKnownSsid = updateKnownSsidChannels();
+  if ( (ssidScanIsFast) && (!foundKnownSsid) ) {  // they have moved, or are not on. Look everywhere
+    debug_println("None of the ssids found on their last channels");
+    ssidScanIsFast = false;
+    ssidScanChannels[0] = 0;
+    ssidScanChannelCount = 1;
+    ssidScanChannelIndex = 0;
+    startSsidScan();
+    return;
+  }
+
+  debug_print("Scan took (ms): "); debug_println(millis() - ssidScanStartTime);
+  sortFoundSsids();
+  showFoundSsids();
+}
+
+uint32_t fnv1aHash(String text) {
+  uint32_t hash = 2166136261UL;
+  for (unsigned int i=0; i<text.length(); i++) {
+    hash ^= (uint8_t) text.charAt(i);
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+// returns the index in foundSsids, or -1.  slot is where it would go
+int findFoundSsid(String ssid, uint32_t hash, int *slot) {
+  int i = hash & (FOUND_SSIDS_HASH_SIZE - 1);
+  while (foundSsidsHashSet[i] >= 0) {
+    int index = foundSsidsHashSet[i];
+    if ( (foundSsidsHashes[index] == hash) && (foundSsids[index] == ssid) ) {
+      if (slot != NULL) *slot = i;
+      return index;
+    }
+    i = (i + 1) & (FOUND_SSIDS_HASH_SIZE - 1);
+  }
+  if (slot != NULL) *slot = i;
+  return -1;
+}
+
+void mergeSsidScanResults(int numSsids) {
+  for (int thisSsid = 0; thisSsid < numSsids; thisSsid++) {
+    String ssid = WiFi.SSID(thisSsid);
+    uint32_t hash = fnv1aHash(ssid);
+    int slot;
+    int index = findFoundSsid(ssid, hash, &slot);
+    if (index >= 0) { // duplicate (repeaters and mesh networks). Keep the strongest
+      if (WiFi.RSSI(thisSsid) > foundSsidRssis[index]) {
+        foundSsidRssis[index] = WiFi.RSSI(thisSsid);
+        foundSsidsChannels[index] = WiFi.channel(thisSsid);
       }
+    } else if (foundSsidsCount < maxFoundSsids) {
+      foundSsids[foundSsidsCount] = ssid;
+      foundSsidsHashes[foundSsidsCount] = hash;
+      foundSsidRssis[foundSsidsCount] = WiFi.RSSI(thisSsid);
+      foundSsidsOpen[foundSsidsCount] = (WiFi.encryptionType(thisSsid) == 7) ? true : false;
+      foundSsidsChannels[foundSsidsCount] = WiFi.channel(thisSsid);
+      foundSsidsHashSet[slot] = foundSsidsCount;
+      foundSsidsCount++;
     }
-    for (int i=0; i<foundSsidsCount; i++) {
-      debug_println(foundSsids[i]);      
+  }
+}
+
+// strongest first, as each channel is scanned separately. The hash set is not used after this
+void sortFoundSsids() {
+  for (int i=1; i<foundSsidsCount; i++) {
+    for (int j=i; (j>0) && (foundSsidRssis[j] > foundSsidRssis[j-1]); j--) {
+      String ssid = foundSsids[j]; foundSsids[j] = foundSsids[j-1]; foundSsids[j-1] = ssid;
+      long rssi = foundSsidRssis[j]; foundSsidRssis[j] = foundSsidRssis[j-1]; foundSsidRssis[j-1] = rssi;
+      bool open = foundSsidsOpen[j]; foundSsidsOpen[j] = foundSsidsOpen[j-1]; foundSsidsOpen[j-1] = open;
+      uint8_t channel = foundSsidsChannels[j]; foundSsidsChannels[j] = foundSsidsChannels[j-1]; foundSsidsChannels[j-1] = channel;
+      uint32_t hash = foundSsidsHashes[j]; foundSsidsHashes[j] = foundSsidsHashes[j-1]; foundSsidsHashes[j-1] = hash;
     }
+  }
+  for (int i=0; i<FOUND_SSIDS_HASH_SIZE; i++) foundSsidsHashSet[i] = -1;
+}
+
+void showFoundSsids() {
+  startWaitForSelection = millis();
 
-    clearOledArray(); oledText[10] = MSG_SSIDS_FOUND;
+  for (int i=0; i<foundSsidsCount; i++) {
+    debug_print(foundSsids[i]); debug_print(" ch:"); debug_println(foundSsidsChannels[i]);
+  }
 
-    writeOledFoundSSids("");
+  clearOledArray(); oledText[10] = getText(TEXT_MSG_SSIDS_FOUND);
 
-    // oledText[5] = menu_select_ssids_from_found;
-    setMenuTextForOled(menu_select_ssids_from_found);
-    writeOledArray(false, false);
+  writeOledFoundSSids("");
+  if (foundSsidsCount == 0) {  // left on the screen, as before. The configured SSIDs can still be picked (9)
+    debug_println("Couldn't get a wifi connection");
+    oledText[1] = getText(TEXT_MSG_NO_SSIDS_FOUND);
+  }
 
-    keypadUseType = KEYPAD_USE_SELECT_SSID_FROM_FOUND;
-    ssidConnectionState = CONNECTION_STATE_SELECTION_REQUIRED;
+  // oledText[5] = menu_select_ssids_from_found;
+  setMenuTextForOled(menu_select_ssids_from_found);
+  writeOledArray(false, false);
 
-    if ((foundSsidsCount>0) && (autoConnectToFirstDefinedServer)) {
-      for (int i=0; i<foundSsidsCount; i++) { 
-        if (foundSsids[i] == ssids[0]) {
-          ssidConnectionState = CONNECTION_STATE_SELECTED;
-          selectedSsid = foundSsids[i];
-          getSsidPasswordAndWitIpForFound();
-        }
+  keypadUseType = KEYPAD_USE_SELECT_SSID_FROM_FOUND;
+  ssidConnectionState = CONNECTION_STATE_SELECTION_REQUIRED;
+
+  if ((foundSsidsCount>0) && (autoConnectToFirstDefinedServer)) {
+    for (int i=0; i<foundSsidsCount; i++) { 
+      if (foundSsids[i] == ssids[0]) {
+        ssidConnectionState = CONNECTION_STATE_SELECTED;
+        selectedSsid = foundSsids[i];
+        getSsidPasswordAndWitIpForFound();
+      }
+    }
+  }
+}
+
+// *********************************************************************************
+// known ssid channels  
+// NVS record: for each of ssids[]  4 byte hash of the ssid, 1 byte channel
+// A record longer than that (e.g. written before ssids[] was shortened) is ignored
+// *********************************************************************************
+
+void readKnownSsidChannels() {
+  if (knownSsidChannelsRead) return;
+  knownSsidChannelsRead = true;
+  for (int i=0; i<maxSsids; i++) knownSsidChannels[i] = 0;
+
+  nvsPrefs.begin("WitController", true); // read mode
+  uint8_t record[maxSsids * 5];
+  int length = nvsPrefs.getBytesLength(NVS_SSID_CHANNELS_KEY);
+  if ( (length > 0) && ((length % 5) == 0) && (length <= (int) sizeof(record)) ) {
+    nvsPrefs.getBytes(NVS_SSID_CHANNELS_KEY, record, length);
+    for (int j=0; j<length; j=j+5) {
+      uint32_t hash = record[j] | (record[j+1] << 8) | (record[j+2] << 16) | ((uint32_t) record[j+3] << 24);
+      for (int i=0; i<maxSsids; i++) {
+        if (fnv1aHash(ssids[i]) == hash) knownSsidChannels[i] = record[j+4];
       }
     }
   }
+  nvsPrefs.end();
+}
+
+void writeKnownSsidChannels() {
+  uint8_t record[maxSsids * 5];
+  for (int i=0; i<maxSsids; i++) {
+    uint32_t hash = fnv1aHash(ssids[i]);
+    record[i*5] = hash & 0xFF; record[i*5+1] = (hash >> 8) & 0xFF; 
+    record[i*5+2] = (hash >> 16) & 0xFF; record[i*5+3] = (hash >> 24) & 0xFF;
+    record[i*5+4] = knownSsidChannels[i];
+  }
+  nvsPrefs.begin("WitController", false); // write mode
+  nvsPrefs.putBytes(NVS_SSID_CHANNELS_KEY, record, sizeof(record));
+  nvsPrefs.end();
+  debug_println("Known ssid channels saved");
+}
+
+// returns true if any of ssids[] were found in the scan
+bool updateKnownSsidChannels() {
+  bool found = false;
+  bool changed = false;
+  for (int i=0; i<maxSsids; i++) {
+    int index = findFoundSsid(ssids[i], fnv1aHash(ssids[i]), NULL);
+    if (index < 0) continue;
+    found = true;
+    if (knownSsidChannels[i] != foundSsidsChannels[index]) {
+      knownSsidChannels[i] = foundSsidsChannels[index];
+      changed = true;
+    }
+  }
+  if (changed) writeKnownSsidChannels();
+  return found;
+}
+
+void rememberSsidChannel(String ssid, uint8_t channel) {
+  readKnownSsidChannels();
+  for (int i=0; i<maxSsids; i++) {
+    if ( (ssids[i] == ssid) && (knownSsidChannels[i] != channel) ) {
+      knownSsidChannels[i] = channel;
+      writeKnownSsidChannels();
+      break;
+    }
+  }
 }
 
 void selectSsidFromFound(int selection) {
@@ -725,14 +1581,14 @@ void showListOfSsids() {  // show the list from the specified values in config_n
   writeOledArray(false, false);
 
   if (maxSsids == 0) {
-    oledText[1] = MSG_NO_SSIDS_FOUND;
+    oledText[1] = getText(TEXT_MSG_NO_SSIDS_FOUND);
     writeOledBattery();
     writeOledArray(false, false, true, true);
     debug_println(oledText[1]);
   
   } else {
-    debug_print(maxSsids);  debug_println(MSG_SSIDS_LISTED);
-    clearOledArray(); oledText[10] = MSG_SSIDS_LISTED;
+    debug_print(maxSsids);  debug_println(getText(TEXT_MSG_SSIDS_LISTED));
+    clearOledArray(); oledText[10] = getText(TEXT_MSG_SSIDS_LISTED);
 
     for (int i = 0; i < maxSsids; ++i) {
       debug_print(i+1); debug_print(": "); debug_println(ssids[i]);
@@ -786,6 +1642,7 @@ void selectSsid(int selection) {
 
 void connectSsid() {
   debug_println("Connecting to ssid...");
+  stopSsidScan();
   clearOledArray(); 
   setAppnameForOled();
   oledText[1] = selectedSsid; oledText[2] + "connecting...";
@@ -802,20 +1659,27 @@ void connectSsid() {
     debug_print("Trying Network "); debug_println(cSsid);
     clearOledArray(); 
     setAppnameForOled(); 
-    for (int i = 0; i < 3; ++i) {  // Try three times
-      oledText[1] = selectedSsid; oledText[2] =  String(MSG_TRYING_TO_CONNECT) + " (" + String(i) + ")";
+    // after roaming the locos are not being controlled, so give up sooner
+    int attempts = (roamingInProgress) ? 2 : 3;
+    unsigned long connectionTimeout = (roamingInProgress) ? ROAMING_CONNECTION_TIMEOUT : SSID_CONNECTION_TIMEOUT;
+    for (int i = 0; i < attempts; ++i) {
+      oledText[1] = selectedSsid; oledText[2] =  String(getText(TEXT_MSG_TRYING_TO_CONNECT)) + " (" + String(i) + ")";
       writeOledBattery();
       writeOledArray(false, false, true, true);
 
       nowTime = startTime;
       debug_print("hostname ");debug_println(WiFi.getHostname());
-      WiFi.begin(cSsid, cPassword); 
+      if ( (fastResumePending) && (i == 0) ) {
+        WiFi.begin(cSsid, cPassword, rtcSnapshotChannel, rtcSnapshotBssid);  // skip the scan for the access point
+      } else {
+        WiFi.begin(cSsid, cPassword); 
+      }
 
       int j = 0;
       int tempTimer = millis();
       debug_print("Trying Network ... Checking status "); debug_print(cSsid); debug_print(" :"); debug_print(cPassword); debug_println(":");
       while ( (WiFi.status() != WL_CONNECTED) 
-            && ((nowTime-startTime) <= SSID_CONNECTION_TIMEOUT) ) { // wait for X seconds to see if the connection worked
+            && ((nowTime-startTime) <= connectionTimeout) ) { // wait for X seconds to see if the connection worked
         if (millis() > tempTimer + 250) {
           oledText[3] = getDots(j);
           writeOledBattery();
@@ -838,8 +1702,10 @@ void connectSsid() {
     debug_println("");
     if (WiFi.status() == WL_CONNECTED) {
       debug_print("Connected. IP address: "); debug_println(WiFi.localIP());
-      oledText[2] = MSG_CONNECTED; 
-      oledText[3] = MSG_ADDRESS_LABEL + String(WiFi.localIP());
+      linkWifiConnectCount++;
+      rememberSsidChannel(selectedSsid, WiFi.channel());
+      oledText[2] = getText(TEXT_MSG_CONNECTED); 
+      oledText[3] = getText(TEXT_MSG_ADDRESS_LABEL) + String(WiFi.localIP());
       writeOledBattery();
       writeOledArray(false, false, true, true);
       // ssidConnected = true;
@@ -849,7 +1715,7 @@ void connectSsid() {
       // setup the bonjour listener
       if (!MDNS.begin("WiTcontroller")) {
         debug_println("Error setting up MDNS responder!");
-        oledText[2] = MSG_BOUNJOUR_SETUP_FAILED;
+        oledText[2] = getText(TEXT_MSG_BOUNJOUR_SETUP_FAILED);
         writeOledBattery();
         writeOledArray(false, false, true, true);
         delay(2000);
@@ -859,8 +1725,8 @@ void connectSsid() {
       }
 
     } else {
-      debug_println(MSG_CONNECTION_FAILED);
-      oledText[2] = MSG_CONNECTION_FAILED;
+      debug_println(getText(TEXT_MSG_CONNECTION_FAILED));
+      oledText[2] = getText(TEXT_MSG_CONNECTION_FAILED);
       writeOledBattery();
       writeOledArray(false, false, true, true);
       delay(2000);
@@ -868,6 +1734,7 @@ void connectSsid() {
       WiFi.disconnect();      
       ssidConnectionState = CONNECTION_STATE_DISCONNECTED;
       ssidSelectionSource = SSID_CONNECTION_SOURCE_LIST;
+      fastResumeCancel();
     }
   }
 }
@@ -905,7 +1772,7 @@ void browseWitService() {
   debug_printf("Browsing for service _%s._%s.local. on %s ... ", service, proto, selectedSsid.c_str());
   clearOledArray(); 
   oledText[0] = appName; oledText[6] = appVersion; 
-  oledText[1] = selectedSsid;   oledText[2] = MSG_BROWSING_FOR_SERVICE;
+  oledText[1] = selectedSsid;   oledText[2] = getText(TEXT_MSG_BROWSING_FOR_SERVICE);
   writeOledBattery();
   writeOledArray(false, false, true, true);
   
@@ -913,8 +1780,8 @@ void browseWitService() {
 
   noOfWitServices = 0;
   if ( (selectedSsid.substring(0,6) == "DCCEX_") && (selectedSsid.length()==12) ) {
-    debug_println(MSG_BYPASS_WIT_SERVER_SEARCH);
-    oledText[1] = MSG_BYPASS_WIT_SERVER_SEARCH;
+    debug_println(getText(TEXT_MSG_BYPASS_WIT_SERVER_SEARCH));
+    oledText[1] = getText(TEXT_MSG_BYPASS_WIT_SERVER_SEARCH);
     writeOledBattery();
     writeOledArray(false, false, true, true);
     delay(500);
@@ -957,12 +1824,12 @@ void browseWitService() {
   if ( (selectedSsid.substring(0,6) == "DCCEX_") && (selectedSsid.length()==12) ) {
     foundWitServersIPs[foundWitServersCount].fromString("192.168.4.1");
     foundWitServersPorts[foundWitServersCount] = 2560;
-    foundWitServersNames[foundWitServersCount] = MSG_GUESSED_EX_CS_WIT_SERVER;
+    foundWitServersNames[foundWitServersCount] = getText(TEXT_MSG_GUESSED_EX_CS_WIT_SERVER);
     foundWitServersCount++;
   }
 
   if (foundWitServersCount == 0) {
-    oledText[1] = MSG_NO_SERVICES_FOUND;
+    oledText[1] = getText(TEXT_MSG_NO_SERVICES_FOUND);
     writeOledBattery();
     writeOledArray(false, false, true, true);
     debug_println(oledText[1]);
@@ -971,8 +1838,8 @@ void browseWitService() {
     witConnectionState = CONNECTION_STATE_ENTRY_REQUIRED;
   
   } else {
-    debug_print(noOfWitServices);  debug_println(MSG_SERVICES_FOUND);
-    clearOledArray(); oledText[3] = MSG_SERVICES_FOUND;
+    debug_print(noOfWitServices);  debug_println(getText(TEXT_MSG_SERVICES_FOUND));
+    clearOledArray(); oledText[3] = getText(TEXT_MSG_SERVICES_FOUND);
 
     for (int i = 0; i < foundWitServersCount; ++i) {
       // Print details for each service found
@@ -1027,15 +1894,15 @@ void connectWitServer() {
   clearOledArray(); 
   setAppnameForOled(); 
   oledText[1] = "        " + selectedWitServerIP.toString() + " : " + String(selectedWitServerPort); 
-  oledText[2] = "        " + selectedWitServerName; oledText[3] + MSG_CONNECTING;
+  oledText[2] = "        " + selectedWitServerName; oledText[3] + getText(TEXT_MSG_CONNECTING);
   writeOledBattery();
   writeOledArray(false, false, true, true);
   
   startWaitForSelection = millis();
 
   if (!client.connect(selectedWitServerIP, selectedWitServerPort)) {
-    debug_println(MSG_CONNECTION_FAILED);
-    oledText[3] = MSG_CONNECTION_FAILED;
+    debug_println(getText(TEXT_MSG_CONNECTION_FAILED));
+    oledText[3] = getText(TEXT_MSG_CONNECTION_FAILED);
     writeOledArray(false, false, true, true);
     delay(5000);
     
@@ -1043,13 +1910,30 @@ void connectWitServer() {
     ssidConnectionState = CONNECTION_STATE_DISCONNECTED;
     ssidSelectionSource = SSID_CONNECTION_SOURCE_LIST;
     witServerIpAndPortChanged = true;
+    fastResumeCancel();
 
   } else {
     debug_print("Connected to server: ");   debug_println(selectedWitServerIP); debug_println(selectedWitServerPort);
 
-    // Pass the communication to WiThrottle. + Set the mimimum period between sent commands
-    wiThrottleProtocol.connect(&client, outboundCmdsMininumDelay);
+    // Pass the communication to WiThrottle. 
+    // The mimimum period between sent commands is handled by the outbound command scheduler, not the library
+    clearOutboundQueue();
+    roamingState = ROAMING_STATE_IDLE;
+    serverType = "";
+    selectThrottleBackend();  // WiThrottle until the server says what it is
+    client.setNoDelay(true);  // writes are already gathered into one per loop
+    witStream.begin(&client);
+    witStream.setLineHandler(witStreamFastParse);
+    witStream.setLineRecorder(sessionRecordLine);
+    invalidateDerivedState(-1);
+    witStreamLastHandledCount = 0; witStreamLastPassthroughCount = 0; 
+    witStreamLastSegmentsSent = 0; witStreamLastBytesSent = 0;
+    wiThrottleProtocol.connect(&witStream, 0);
     debug_println("WiThrottle connected");
+    linkServerConnectCount++;
+    for (int i=0; i<LINK_PROBE_COUNT; i++) {
+      for (int j=0; j<THROTTLE_POOL_SIZE; j++) linkProbeSentTime[i][j] = 0;
+    }
 
     wiThrottleProtocol.setDeviceName(deviceName);  
     wiThrottleProtocol.setDeviceID(String(deviceId));  
@@ -1061,7 +1945,14 @@ void connectWitServer() {
     witConnectionState = CONNECTION_STATE_CONNECTED;
     setLastServerResponseTime(true);
 
-    oledText[3] = MSG_CONNECTED;
+    keypadUseType = KEYPAD_USE_OPERATION;
+
+    if (fastResumePending) {
+      fastResumeRestoreLocos();  // straight back to the throttle
+      return;
+    }
+
+    oledText[3] = getText(TEXT_MSG_CONNECTED);
     if (!hashShowsFunctionsInsteadOfKeyDefs) {
       // oledText[5] = menu_menu;
       setMenuTextForOled(menu_menu);
@@ -1071,9 +1962,7 @@ void connectWitServer() {
     }
     writeOledArray(false, false, true, true);
     writeOledBattery();
-    u8g2.sendBuffer();
-
-    keypadUseType = KEYPAD_USE_OPERATION;
+    oledSendBuffer();
 
     doStartupCommands();
   }
@@ -1085,7 +1974,7 @@ void enterWitServer() {
     debug_println("enterWitServer()");
     clearOledArray(); 
     setAppnameForOled(); 
-    oledText[1] = MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED;
+    oledText[1] = getText(TEXT_MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED);
     oledText[3] = witServerIpAndPortConstructed;
     // oledText[5] = menu_select_wit_entry;
       setMenuTextForOled(menu_select_wit_entry);
@@ -1096,12 +1985,16 @@ void enterWitServer() {
 
 void disconnectWitServer() {
   debug_println("disconnectWitServer()");
+  clearOutboundQueue();
   for (int i=0; i<maxThrottles; i++) {
     releaseAllLocos(i);
   }
+  drainOutbound();  // the releases are queued
   wiThrottleProtocol.disconnect();
+  invalidateDerivedState(-1);
+  flushOutbound();
   debug_println("Disconnected from wiThrottle server\n");
-  clearOledArray(); oledText[0] = MSG_DISCONNECTED;
+  clearOledArray(); oledText[0] = getText(TEXT_MSG_DISCONNECTED);
   writeOledArray(false, false, true, true);
   witConnectionState = CONNECTION_STATE_DISCONNECTED;
   witServerIpAndPortChanged = true;
@@ -1203,6 +2096,7 @@ void readPreferences() {
   if (!RESTORE_ACQUIRED_LOCOS) return;
 
   debug_println("readPreferences(): Reading preferences from non-volitile storage ");
+  unsigned long startTime = micros();
   nvsPrefs.begin("WitController", true); // read mode
   nvsInit = nvsPrefs.isKey("nvsInit");
   if (nvsInit) {
@@ -1210,32 +2104,32 @@ void readPreferences() {
     currentThrottleIndex = 0;
     currentThrottleIndexChar = '0';
 
-    int count = 0;  
-    char key[4];
-    key[3] = 0;
+    if (nvsPrefs.isKey(NVS_LOCO_RECORD_KEY)) {
+      uint8_t record[NVS_LOCO_RECORD_SIZE];
+      int length = nvsPrefs.getBytesLength(NVS_LOCO_RECORD_KEY);
+      if ( (length <= NVS_LOCO_RECORD_SIZE) 
+      && (nvsPrefs.getBytes(NVS_LOCO_RECORD_KEY, record, length) == length)
+      && (applyLocoRecord(record, length)) ) {
+        memcpy(nvsLocoRecordSaved, record, length);
+        nvsLocoRecordSavedLength = length;
+      } else {
+        debug_println("readPreferences(): Loco record is not valid. Ignored");
+      }
 
-    // int currentThrottle = 0;
-    key[0] = 'L';
-    for (int i=0; i<MAX_THROTTLES; i++) {
-      key[1] = '0' + i;
-      for (int j=0; j<10; j++) { // assume a maximum of 10 locos per throttle
-        key[2] = '0' + j;
-        if (nvsPrefs.isKey(key)) {
-          // if ( (currentThrottle != i) && (count>0) ) {
-          //   doOneStartupCommand("5"); //nextThrottle
-          //   currentThrottle = i;
-          // }
-          String loco = nvsPrefs.getString(key);
-          // doOneStartupCommand("*1" + loco + "#");
-
-          loco = getLocoWithLength(loco);
-          debug_print("add Loco: "); debug_println(loco);
-          wiThrottleProtocol.addLocomotive(key[1], loco);
-          wiThrottleProtocol.getDirection(key[1], loco);
-          wiThrottleProtocol.getSpeed(key[1]);
-          count++;
-        } else {
-          debug_print("readPreferences(): Not Found - Key: "); debug_println(key);
+    } else { // older versions used one key per loco
+      char key[4];
+      key[3] = 0;
+
+      key[0] = 'L';
+      for (int i=0; (i<NVS_LEGACY_MAX_THROTTLES) && (i<THROTTLE_POOL_SIZE); i++) {
+        key[1] = '0' + i;
+        for (int j=0; j<10; j++) { // assume a maximum of 10 locos per throttle
+          key[2] = '0' + j;
+          if (nvsPrefs.isKey(key)) {
+            String loco = nvsPrefs.getString(key);
+            queueAcquireLoco(key[1], getLocoWithLength(loco));
+            nvsLegacyLocoKeys = true;
+          }
         }
       }
     }
@@ -1248,56 +2142,641 @@ void readPreferences() {
   }
   preferencesRead = true;
   nvsPrefs.end();
+  nvsLastReadTime = micros() - startTime;
+  debug_print("readPreferences(): took (us) "); debug_println(nvsLastReadTime);
+  // if the old format was found, it is converted once the locos have been acquired.  See acquireLoop()
+}
+
+// the language is kept separately from the locos, so it can be read before connecting
+void readLanguagePreference() {
+  nvsPrefs.begin("WitController", true); // read mode
+  int language = nvsPrefs.getInt("language", DEFAULT_LANGUAGE);
+  nvsPrefs.end();
+  if ( (language>=0) && (language<LANGUAGE_COUNT) ) currentLanguage = language;
+  debug_print("readLanguagePreference(): "); debug_println(currentLanguage);
+}
+
+void writeLanguagePreference() {
+  nvsPrefs.begin("WitController", false); // write mode
+  nvsPrefs.putInt("language", currentLanguage);
+  nvsPrefs.end();
 }
 
 void writePreferences() {
+  if (!nvsInit) {
+    debug_println("writePreferences(): Non-volitile storage not initialised");
+    return;
+  }
+
+  uint8_t record[NVS_LOCO_RECORD_SIZE];
+  int length = buildLocoRecord(record);
+  if ( (!nvsLegacyLocoKeys) && (length == nvsLocoRecordSavedLength) 
+  && (memcmp(record, nvsLocoRecordSaved, length) == 0) ) {
+    nvsWriteSkippedCount++;
+    return;  // nothing has changed
+  }
+
   debug_println("writePreferences(): Writing preferences to non-volitile storage ");
+  unsigned long startTime = micros();
   nvsPrefs.begin("WitController", false); // write mode
+  nvsPrefs.putBool("nvsInit", true);
+  nvsPrefs.putBytes(NVS_LOCO_RECORD_KEY, record, length);
 
-  if (nvsInit) {
-    nvsPrefs.putBool("nvsInit", true);
-
-    int count = 0;  
+  if (nvsLegacyLocoKeys) { // remove the keys from the older format
     char key[4];
-    key[3] = 0;
-
-    key[0] = 'L';
-    for (int i=0; i<maxThrottles; i++) {
+    key[0] = 'L'; key[3] = 0;
+    for (int i=0; i<NVS_LEGACY_MAX_THROTTLES; i++) {
       key[1] = '0' + i;
       for (int j=0; j<10; j++) {
         key[2] = '0' + j;
-        if (j<wiThrottleProtocol.getNumberOfLocomotives(getMultiThrottleChar(i))) {
-          String loco = wiThrottleProtocol.getLocomotiveAtPosition(getMultiThrottleChar(i), j);
-          String locoNumber = loco.substring(1);
-          nvsPrefs.putString(key, locoNumber);
-          debug_print("writePreferences(): Key: "); debug_print(key); debug_print(" - "); debug_println(locoNumber);
-          count++;
-        } else {
-          if (nvsPrefs.isKey(key)) {
-            nvsPrefs.remove(key);
-            debug_print("writePreferences(): Removed Key: "); debug_println(key);
-          }
-        }
+        if (nvsPrefs.isKey(key)) nvsPrefs.remove(key);
       }
     }
-  } else {
-    debug_println("writePreferences(): Non-volitile storage not initialised");
+    nvsLegacyLocoKeys = false;
   }
   nvsPrefs.end();
-}
 
-void clearPreferences() {
-  setupPreferences(true);
+  memcpy(nvsLocoRecordSaved, record, length);
+  nvsLocoRecordSavedLength = length;
+  nvsWriteCount++;
+  nvsLastWriteTime = micros() - startTime;
+  debug_print("writePreferences(): "); debug_print(length); debug_print(" bytes. took (us) "); debug_print(nvsLastWriteTime);
+  debug_print(" writes: "); debug_print(nvsWriteCount); debug_print(" unchanged: "); debug_println(nvsWriteSkippedCount);
 }
 
+// Loco record.  All the acquired locos in one NVS entry
+//   [0] version  [1] number of throttles  [2..3] payload length
+//   payload: for each throttle, the number of locos then each loco as a null terminated string (e.g. "L1234")
+//   [last 2] Fletcher-16 checksum of everything before it
+int buildLocoRecord(uint8_t *record) {
+  int length = 4;
+  record[0] = NVS_LOCO_RECORD_VERSION;
+  record[1] = maxThrottles;
 
-// *********************************************************************************
+  for (int i=0; i<maxThrottles; i++) {
+    char multiThrottle = getMultiThrottleChar(i);
+    int count = wiThrottleProtocol.getNumberOfLocomotives(multiThrottle);
+    if (count > 10) count = 10;
+    int countPosition = length;
+    record[length++] = 0;
+    for (int j=0; j<count; j++) {
+      String loco = wiThrottleProtocol.getLocomotiveAtPosition(multiThrottle, j);
+      if ( (length + (int) loco.length() + 1 + 2) > NVS_LOCO_RECORD_SIZE ) break;  // no room
+      memcpy(record + length, loco.c_str(), loco.length() + 1);
+      length += loco.length() + 1;
+      record[countPosition]++;
+    }
+  }
+  record[2] = (length - 4) & 0xFF;
+  record[3] = (length - 4) >> 8;
+
+  uint16_t checksum = locoRecordChecksum(record, length);
+  record[length++] = checksum & 0xFF;
+  record[length++] = checksum >> 8;
+  return length;
+}
+
+bool applyLocoRecord(const uint8_t *record, int length) {
+  if (length < 6) return false;
+  if (record[0] != NVS_LOCO_RECORD_VERSION) return false;
+  int payloadLength = record[2] | (record[3] << 8);
+  if (payloadLength + 6 != length) return false;
+  uint16_t checksum = record[length-2] | (record[length-1] << 8);
+  if (checksum != locoRecordChecksum(record, length-2)) return false;
+
+  int throttles = record[1];
+  int position = 4;
+  for (int i=0; (i<throttles) && (position<length-2); i++) {
+    int count = record[position++];
+    for (int j=0; j<count; j++) {
+      const char *loco = (const char *) record + position;
+      int locoLength = strnlen(loco, length - 2 - position);
+      if (position + locoLength >= length - 2) return true;  // truncated.  Keep what we have
+      position += locoLength + 1;
+      if (i >= THROTTLE_POOL_SIZE) continue;
+
+      queueAcquireLoco(getMultiThrottleChar(i), String(loco));
+    }
+  }
+  return true;
+}
+
+uint16_t locoRecordChecksum(const uint8_t *data, int length) {
+  uint16_t sum1 = 0;
+  uint16_t sum2 = 0;
+  for (int i=0; i<length; i++) {
+    sum1 = (sum1 + data[i]) % 255;
+    sum2 = (sum2 + sum1) % 255;
+  }
+  return (sum2 << 8) | sum1;
+}
+
+// save the acquired locos whenever they change.  Nothing is written if they are the same as last time
+void autoSaveLocosLoop() {
+  if ( (!AUTO_SAVE_ACQUIRED_LOCOS) || (!nvsInit) || (!preferencesRead) ) return;
+  if ( (acquireQueueCount > 0) || (acquireBatchActive) ) return;  // wait until the locos are all acquired
+  if (millis() - nvsLastAutoSaveCheck < AUTO_SAVE_ACQUIRED_LOCOS_INTERVAL) return;
+  nvsLastAutoSaveCheck = millis();
+  writePreferences();
+}
+
+void clearPreferences() {
+  setupPreferences(true);
+}
+
+// *********************************************************************************
+//   Fast resume from deep sleep
+// *********************************************************************************
+// RTC slow memory survives deep sleep (but not a power off or reset), so the connection, 
+// the acquired locos and the throttle settings are kept there when going to sleep.
+// On wake the Wi-Fi and server browsing and the NVS reads are skipped. 
+// Speeds are not restored.  They are asked for from the server once the locos are acquired again.
+// The Wi-Fi password is in the snapshot, so it is cleared as soon as the snapshot has been used.
+
+bool fastResumeAvailable() {
+  if (!USE_FAST_RESUME) return false;
+  if (rtcSnapshotMagic != FAST_RESUME_MAGIC) return false;
+  return (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0);
+}
+
+void fastResumeWriteSnapshot() {
+  rtcSnapshotMagic = 0;
+  if (!USE_FAST_RESUME) return;
+  writeSessionSnapshot();
+}
+
+// the network, server, locos etc.  Needed to reconnect to the same session
+void writeSessionSnapshot() {
+  rtcSnapshotMagic = 0;
+  if (witConnectionState != CONNECTION_STATE_CONNECTED) return;
+  debug_println("writeSessionSnapshot()");
+
+  strncpy(rtcSnapshotSsid, selectedSsid.c_str(), sizeof(rtcSnapshotSsid)-1); rtcSnapshotSsid[sizeof(rtcSnapshotSsid)-1] = 0;
+  strncpy(rtcSnapshotPassword, selectedSsidPassword.c_str(), sizeof(rtcSnapshotPassword)-1); rtcSnapshotPassword[sizeof(rtcSnapshotPassword)-1] = 0;
+  uint8_t *bssid = WiFi.BSSID();
+  if (bssid != NULL) memcpy(rtcSnapshotBssid, bssid, 6);
+  rtcSnapshotChannel = WiFi.channel();
+  rtcSnapshotServerIP = (uint32_t) selectedWitServerIP;
+  rtcSnapshotServerPort = selectedWitServerPort;
+  strncpy(rtcSnapshotServerName, selectedWitServerName.c_str(), sizeof(rtcSnapshotServerName)-1); rtcSnapshotServerName[sizeof(rtcSnapshotServerName)-1] = 0;
+
+  rtcSnapshotMaxThrottles = maxThrottles;
+  rtcSnapshotCurrentThrottleIndex = currentThrottleIndex;
+  rtcSnapshotSpeedStepMultiplier = speedStepCurrentMultiplier;
+  rtcSnapshotLanguage = currentLanguage;
+  rtcSnapshotNvsInit = nvsInit;
+  rtcSnapshotTruncated = false;
+
+  for (int i=0; i<THROTTLE_POOL_SIZE; i++) {
+    rtcSnapshotSpeedStep[i] = throttleStates[i].speedStep;
+    rtcSnapshotDirection[i] = (throttleStates[i].direction == Forward) ? 1 : 0;
+    rtcSnapshotFunctions[i] = throttleStates[i].functionStates;
+
+    rtcSnapshotLocoCount[i] = 0;
+    if (i >= maxThrottles) continue;
+    char multiThrottle = getMultiThrottleChar(i);
+    int count = wiThrottleProtocol.getNumberOfLocomotives(multiThrottle);
+    for (int j=0; j<count; j++) {
+      String loco = wiThrottleProtocol.getLocomotiveAtPosition(multiThrottle, j);
+      if ( (j >= MAX_LOCOS) || (loco.length() >= sizeof(rtcSnapshotLocos[i][j])) ) {
+        debug_print("writeSessionSnapshot(): loco not kept: "); debug_println(loco);
+        rtcSnapshotTruncated = true;
+        continue;
+      }
+      strcpy(rtcSnapshotLocos[i][rtcSnapshotLocoCount[i]], loco.c_str());
+      rtcSnapshotLocoCount[i]++;
+    }
+  }
+  rtcSnapshotMagic = FAST_RESUME_MAGIC;
+}
+
+// called from setup() after the defaults are set
+void fastResumeStart() {
+  debug_println("fastResumeStart(): resuming from the snapshot");
+  currentLanguage = ( (rtcSnapshotLanguage>=0) && (rtcSnapshotLanguage<LANGUAGE_COUNT) ) ? rtcSnapshotLanguage : DEFAULT_LANGUAGE;
+
+  selectedSsid = rtcSnapshotSsid;
+  selectedSsidPassword = rtcSnapshotPassword;
+  fastResumeClearPassword();
+  ssidConnectionState = CONNECTION_STATE_SELECTED;
+
+  selectedWitServerIP = IPAddress(rtcSnapshotServerIP);
+  selectedWitServerPort = rtcSnapshotServerPort;
+  selectedWitServerName = rtcSnapshotServerName;
+  witConnectionState = CONNECTION_STATE_SELECTED;
+
+  maxThrottles = ( (rtcSnapshotMaxThrottles>=1) && (rtcSnapshotMaxThrottles<=THROTTLE_POOL_SIZE) ) ? rtcSnapshotMaxThrottles : MAX_THROTTLES;
+  currentThrottleIndex = ( (rtcSnapshotCurrentThrottleIndex>=0) && (rtcSnapshotCurrentThrottleIndex<maxThrottles) ) ? rtcSnapshotCurrentThrottleIndex : 0;
+  currentThrottleIndexChar = getMultiThrottleChar(currentThrottleIndex);
+  speedStepCurrentMultiplier = rtcSnapshotSpeedStepMultiplier;
+  for (int i=0; i<THROTTLE_POOL_SIZE; i++) {
+    throttleStates[i].speedStep = rtcSnapshotSpeedStep[i];
+    throttleStates[i].direction = (rtcSnapshotDirection[i]) ? Forward : Reverse;
+    throttleStates[i].functionStates = rtcSnapshotFunctions[i];
+  }
+
+  nvsInit = rtcSnapshotNvsInit;
+  preferencesRead = !rtcSnapshotTruncated;   // the locos come from the snapshot, not NVS, unless some did not fit
+}
+
+// called once the server is connected
+void fastResumeRestoreLocos() {
+  debug_println("fastResumeRestoreLocos()");
+  if (rtcSnapshotTruncated) {  // readPreferences() acquires them all once the roster has arrived
+    debug_println("fastResumeRestoreLocos(): snapshot incomplete. Using the saved locos");
+    preferencesRead = false;
+  } else {
+    for (int i=0; i<maxThrottles; i++) {
+      for (int j=0; j<rtcSnapshotLocoCount[i]; j++) {
+        queueAcquireLoco(getMultiThrottleChar(i), String(rtcSnapshotLocos[i][j]));
+      }
+    }
+  }
+  fastResumePending = false;
+  rtcSnapshotMagic = 0;
+  fastResumeClearPassword();
+  writeOledSpeed();
+}
+
+// the snapshot could not be used.  Carry on as for a normal start
+void fastResumeCancel() {
+  if (!fastResumePending) return;
+  debug_println("fastResumeCancel()");
+  fastResumePending = false;
+  rtcSnapshotMagic = 0;
+  fastResumeClearPassword();
+  roamingInProgress = false;
+  witConnectionState = CONNECTION_STATE_DISCONNECTED;
+  preferencesRead = false;
+}
+
+void fastResumeClearPassword() {
+  memset(rtcSnapshotPassword, 0, sizeof(rtcSnapshotPassword));
+}
+
+
+// *********************************************************************************
+//   Roaming
+// *********************************************************************************
+
+// called while connected to the server
+void roamingLoop() {
+  if (!roamingEnabled) return;
+  if (roamingState != ROAMING_STATE_IDLE) {
+    roamingMoveLoop();
+    return;
+  }
+  if (roamingScanRunning) roamingScanLoop();
+
+  if ((millis() - roamingLastSampleTime) < ROAMING_SAMPLE_INTERVAL) return;
+  roamingLastSampleTime = millis();
+
+  int rssi = (roamingSimulatedRssi != 0) ? roamingSimulatedRssi : WiFi.RSSI();
+  if (rssi == 0) return;  // not associated
+  sessionRecordInput('W', '0', rssi);
+  roamingAverageRssi = roamingSmoothRssi(roamingAverageRssi, rssi);
+
+  if ( (roamCount > 0) && ((millis() - roamingLastRoamTime) < ROAMING_HOLD_OFF) ) return;
+
+  if (roamingSimulatedCandidateRssi != 0) {  // testing. No scan. Moves to the same access point
+    uint8_t *bssid = WiFi.BSSID();
+    if (bssid != NULL) {
+      memcpy(roamingCandidateBssid, bssid, 6);
+      roamingCandidateChannel = WiFi.channel();
+      roamingCandidateRssi = roamingSimulatedCandidateRssi;
+      roamingCandidateTime = millis();
+    }
+  } else if ( (roamingAverageRssi < ROAMING_PRESCAN_RSSI) && (!roamingScanRunning) 
+  && ( (!roamingScanDone) || ((millis() - roamingLastScanTime) >= ROAMING_SCAN_INTERVAL) ) ) {
+    roamingStartScan();
+  }
+
+  if ( (roamingCandidateChannel == 0) || ((millis() - roamingCandidateTime) > ROAMING_CANDIDATE_MAX_AGE) ) return;
+  bool linkSilent = (millis() - witStream.getLastReceiveTime()) > ROAMING_SILENT_TIME;
+  if (roamingShouldRoam(roamingAverageRssi, roamingCandidateRssi, linkSilent)) {
+    roamToCandidate();
+  }
+}
+
+// average of the recent samples, so one weak reading does not cause a move
+int roamingSmoothRssi(int average, int sample) {
+  if (average == 0) return sample;
+  return average + (sample - average) / 4;
+}
+
+bool roamingShouldRoam(int averageRssi, int candidateRssi, bool linkSilent) {
+  if (candidateRssi < averageRssi + ROAMING_RSSI_MARGIN) return false;
+  return (averageRssi < ROAMING_RSSI_THRESHOLD) || ( (linkSilent) && (averageRssi < ROAMING_PRESCAN_RSSI) );
+}
+
+void roamingStartScan() {
+  debug_print("roamingStartScan() average RSSI: "); debug_println(roamingAverageRssi);
+  WiFi.scanNetworks(true, false, false, ROAMING_SCAN_TIME_PER_CHANNEL, 0, selectedSsid.c_str());
+  roamingScanRunning = true;
+  roamingLastScanTime = millis();
+}
+
+void roamingScanLoop() {
+  int numSsids = WiFi.scanComplete();
+  if (numSsids == WIFI_SCAN_RUNNING) {
+    if ((millis() - roamingLastScanTime) <= SSID_SCAN_TIMEOUT) return;
+    esp_wifi_scan_stop();
+    numSsids = 0;
+  }
+  roamingScanRunning = false;
+  roamingScanDone = true;
+
+  uint8_t *currentBssid = WiFi.BSSID();
+  roamingCandidateChannel = 0;
+  for (int i=0; i<numSsids; i++) {
+    if (!WiFi.SSID(i).equals(selectedSsid)) continue;
+    uint8_t *bssid = WiFi.BSSID(i);
+    if ( (bssid == NULL) || ((currentBssid != NULL) && (memcmp(bssid, currentBssid, 6) == 0)) ) continue;
+    if ( (roamingCandidateChannel == 0) || (WiFi.RSSI(i) > roamingCandidateRssi) ) {
+      memcpy(roamingCandidateBssid, bssid, 6);
+      roamingCandidateChannel = WiFi.channel(i);
+      roamingCandidateRssi = WiFi.RSSI(i);
+      roamingCandidateTime = millis();
+    }
+  }
+  WiFi.scanDelete();
+  if (roamingCandidateChannel > 0) {
+    debug_print("roaming candidate ch:"); debug_print(roamingCandidateChannel); debug_print(" RSSI: "); debug_println(roamingCandidateRssi);
+  }
+}
+
+// move to the new access point, keeping the connection to the server, so the session and its locos are kept.
+// The move is driven by roamingMoveLoop(), so the loop carries on while it happens.
+// If the IP address changes, or the connection to the server is lost, it falls back to roamingReconnect()
+void roamToCandidate() {
+  debug_print("roamToCandidate() average RSSI: "); debug_print(roamingAverageRssi);
+  debug_print(" to ch:"); debug_print(roamingCandidateChannel); debug_print(" RSSI: "); debug_println(roamingCandidateRssi);
+  roamCount++;
+  roamingLastRoamTime = millis();
+  for (int i=0; i<maxThrottles; i++) {  // in case it has to fall back to reconnecting
+    roamingRestoreSpeed[i] = throttleStates[i].speed;
+    roamingRestoreDirection[i] = throttleStates[i].direction;
+  }
+
+  writeSessionSnapshot();
+  memcpy(rtcSnapshotBssid, roamingCandidateBssid, 6);
+  rtcSnapshotChannel = roamingCandidateChannel;
+  roamingCandidateChannel = 0;
+  roamingAverageRssi = 0;
+  roamingScanDone = false;
+  roamingLocalIp = (uint32_t) WiFi.localIP();
+
+  // leave the old access point first, so the status is not the old connection's
+  WiFi.disconnect();
+  roamingState = ROAMING_STATE_LEAVING;
+  roamingStateTime = millis();
+}
+
+// called from roamingLoop() while moving
+void roamingMoveLoop() {
+  if (roamingState == ROAMING_STATE_LEAVING) {
+    if ( (WiFi.status() == WL_CONNECTED) && ((millis() - roamingStateTime) < ROAMING_DISCONNECT_TIMEOUT) ) return;
+    WiFi.begin(selectedSsid.c_str(), selectedSsidPassword.c_str(), rtcSnapshotChannel, rtcSnapshotBssid);
+    roamingState = ROAMING_STATE_JOINING;
+    roamingStateTime = millis();
+    return;
+  }
+
+  if (WiFi.status() != WL_CONNECTED) {
+    if ((millis() - roamingStateTime) < ROAMING_CONNECTION_TIMEOUT) return;
+    debug_println("roamingMoveLoop(): the new access point could not be joined");
+    roamingReconnect();
+    return;
+  }
+
+  roamingState = ROAMING_STATE_IDLE;
+  linkWifiConnectCount++;
+  rememberSsidChannel(selectedSsid, WiFi.channel());
+  if ( ((uint32_t) WiFi.localIP() != roamingLocalIp) || (!client.connected()) ) {
+    debug_println("roamingMoveLoop(): the address changed or the server connection was lost");
+    roamingReconnect();
+    return;
+  }
+  debug_print("roamingMoveLoop(): moved. IP address: "); debug_println(WiFi.localIP());
+  rtcSnapshotMagic = 0;   // the session carries on, the snapshot is not needed
+  fastResumeClearPassword();
+}
+
+// drop the connection without sending the release commands, then reconnect to the new
+// access point and server the same way as a fast resume, which acquires the locos again.
+// Closing the connection ends the session on the server, which releases the locos (and DCC-EX stops them),
+// so once they are acquired again their speeds and directions are sent again. See roamingRestoreThrottles()
+void roamingReconnect() {
+  debug_println("roamingReconnect()");
+  roamingState = ROAMING_STATE_IDLE;
+  roamingInProgress = true;
+
+  clearOutboundQueue();
+  witStream.begin(NULL);   // nothing more is sent on the old connection
+  for (int i=0; i<maxThrottles; i++) {
+    wiThrottleProtocol.releaseLocomotive(getMultiThrottleChar(i), "*");  // only forgets them locally now
+  }
+  invalidateDerivedState(-1);
+  client.stop();
+  MDNS.end();
+  WiFi.disconnect();
+
+  fastResumePending = true;
+  witConnectionState = CONNECTION_STATE_SELECTED;
+  ssidConnectionState = CONNECTION_STATE_SELECTED;
+}
+
+// the locos are acquired again after a move.  Send the speeds and directions they had before it
+void roamingRestoreThrottles() {
+  if (!roamingInProgress) return;
+  roamingInProgress = false;
+  for (int i=0; i<maxThrottles; i++) {
+    if (wiThrottleProtocol.getNumberOfLocomotives(getMultiThrottleChar(i)) == 0) continue;
+    debug_print("roamingRestoreThrottles(): "); debug_print(i); 
+    debug_print(" speed: "); debug_println(roamingRestoreSpeed[i]);
+    changeDirection(i, roamingRestoreDirection[i]);
+    speedSetNow(i, roamingRestoreSpeed[i]);
+    throttleStates[i].momentumTargetSpeed = roamingRestoreSpeed[i];
+    throttleStates[i].momentumSpeedFixed = ((long) roamingRestoreSpeed[i]) << 8;
+  }
+}
+
+// '<dBm> [<candidate dBm>]' or 'OFF'.  With a candidate, the current access point is offered as 
+// one to move to, so the whole move can be tried with a single access point
+void roamingSimulate(const char* values) {
+  char *end;
+  roamingSimulatedRssi = strtol(values, &end, 10);
+  roamingSimulatedCandidateRssi = strtol(end, NULL, 10);
+  if (roamingSimulatedCandidateRssi == 0) roamingCandidateChannel = 0;
+}
+
+// *********************************************************************************
+//   Link telemetry
+// *********************************************************************************
+// Each speed, direction or function command sent starts a probe for its throttle, which ends when
+// the server echoes that property back.  Only the oldest unanswered probe of each kind is timed.
+// The WiThrottle heartbeat has no reply, so it can't be timed.
+
+void linkProbeSent(int probeType, char multiThrottle) {
+  int multiThrottleIndex = getMultiThrottleIndex(multiThrottle);
+  if (linkProbeSentTime[probeType][multiThrottleIndex] == 0) {
+    linkProbeSentTime[probeType][multiThrottleIndex] = millis() | 1;  // never 0
+  }
+}
+
+// called with every line received, before the library sees it
+void linkInboundLine(const char* line, int length) {
+  if ( (length > 3) && (line[0] == '<') && (line[1] == 'l') && (line[2] == ' ') ) {  // DCC-EX loco broadcast
+    for (int i=0; i<THROTTLE_POOL_SIZE; i++) {
+      linkProbeAnswered(LINK_PROBE_SPEED, i);
+      linkProbeAnswered(LINK_PROBE_DIRECTION, i);
+    }
+    return;
+  }
+  if ( (length < 4) || (line[0] != 'M') || (line[2] != 'A') ) return;
+  int separator = sliceIndexOf(line, length, WIT_PROPERTY_SEPARATOR, 3);
+  if ( (separator < 0) || (separator+3 >= length) ) return;
+  int multiThrottleIndex = getMultiThrottleIndex(line[1]);
+  switch (line[separator+3]) {
+    case 'V': linkProbeAnswered(LINK_PROBE_SPEED, multiThrottleIndex); break;
+    case 'R': linkProbeAnswered(LINK_PROBE_DIRECTION, multiThrottleIndex); break;
+    case 'F': linkProbeAnswered(LINK_PROBE_FUNCTION, multiThrottleIndex); break;
+  }
+}
+
+void linkProbeAnswered(int probeType, int multiThrottleIndex) {
+  unsigned long sentTime = linkProbeSentTime[probeType][multiThrottleIndex];
+  if (sentTime == 0) return;
+  linkProbeSentTime[probeType][multiThrottleIndex] = 0;
+
+  unsigned long rtt = millis() - sentTime;
+  linkRttSamples[linkRttSampleNext] = (rtt > 65535) ? 65535 : rtt;
+  linkRttSampleNext = (linkRttSampleNext + 1) % LINK_RTT_SAMPLES;
+  if (linkRttSampleCount < LINK_RTT_SAMPLES) linkRttSampleCount++;
+  linkProbesAnswered++;
+
+  uint16_t sorted[LINK_RTT_SAMPLES];
+  int n = linkRttSampleCount;
+  for (int i=0; i<n; i++) {
+    int j = i;
+    for (; (j>0) && (sorted[j-1] > linkRttSamples[i]); j--) sorted[j] = sorted[j-1];
+    sorted[j] = linkRttSamples[i];
+  }
+  linkRttP50 = sorted[(n-1) * 50 / 100];
+  linkRttP90 = sorted[(n-1) * 90 / 100];
+  linkRttP99 = sorted[(n-1) * 99 / 100];
+}
+
+// called while connected to the server
+void linkTelemetryLoop() {
+  if ((millis() - linkLastTelemetryTime) < LINK_TELEMETRY_INTERVAL) return;
+  linkLastTelemetryTime = millis();
+
+  for (int i=0; i<LINK_PROBE_COUNT; i++) {
+    for (int j=0; j<THROTTLE_POOL_SIZE; j++) {
+      if ( (linkProbeSentTime[i][j] != 0) && ((millis() - linkProbeSentTime[i][j]) > LINK_PROBE_TIMEOUT) ) {
+        linkProbeSentTime[i][j] = 0;
+        linkProbesLost++;
+      }
+    }
+  }
+
+  linkRssi = (roamingSimulatedRssi != 0) ? roamingSimulatedRssi : WiFi.RSSI();
+  if (linkRssi != 0) {
+    linkRssiAverage = (linkRssiAverage == 0) ? linkRssi : linkRssiAverage + (linkRssi - linkRssiAverage) / 8;
+    if ( (linkRssiMin == 0) || (linkRssi < linkRssiMin) ) linkRssiMin = linkRssi;
+  }
+
+  if (lastOledScreen == last_oled_screen_diagnostics) {
+    writeOledDiagnostics();
+  } else if ( (SHOW_LINK_INDICATOR) && (lastOledScreen == last_oled_screen_speed) && (!menuIsShowing) 
+  && (keypadUseType == KEYPAD_USE_OPERATION) && (!acquireBatchActive) ) {
+    String indicator = String(linkRssiBars(linkRssi)) + ((linkIndicatorShowsRtt) ? String(linkRttP50) : "");
+    if (!indicator.equals(linkLastIndicatorText)) writeOledSpeed();  // only when it would look different
+  }
+}
+
+int linkRssiBars(int rssi) {
+  if (rssi == 0) return 0;
+  if (rssi > -55) return 4;
+  if (rssi > -65) return 3;
+  if (rssi > -75) return 2;
+  if (rssi > -85) return 1;
+  return 0;
+}
+
+// signal bars and the median round trip time (ms), under the direction.
+// The time is left out while the next throttle is shown, as its speed is drawn in the same place
+void writeOledLinkIndicator(bool showRtt) {
+  if (!SHOW_LINK_INDICATOR) return;
+  int bars = linkRssiBars(linkRssi);
+  linkIndicatorShowsRtt = showRtt;
+  linkLastIndicatorText = String(bars) + ((showRtt) ? String(linkRttP50) : "");
+
+  for (int i=0; i<4; i++) {
+    if (i < bars) {
+      u8g2.drawBox(79 + i*2, 48 - (i+1)*2, 1, (i+1)*2);
+    } else {
+      u8g2.drawBox(79 + i*2, 47, 1, 1);
+    }
+  }
+  if ( (showRtt) && (linkRttP50 >= 0) ) {
+    u8g2.setFont(FONT_FUNCTION_INDICATORS);
+    u8g2.drawStr(88, 48, (linkRttP50 > 999) ? "1s+" : String(linkRttP50).c_str());
+  }
+}
+
+void writeOledDiagnostics() {
+  lastOledScreen = last_oled_screen_diagnostics;
+  menuIsShowing = true;  // so updates from the server don't replace it
+
+  clearOledArray();
+  oledText[0] = getText(TEXT_MENU_ITEM_TEXT_TITLE_DIAGNOSTICS);
+  if (linkRttP50 >= 0) {
+    oledText[1] = "RTT " + String(linkRttP50) + "/" + String(linkRttP90) + "/" + String(linkRttP99);
+  } else {
+    oledText[1] = "RTT -";
+  }
+  oledText[2] = "n " + String(linkProbesAnswered) + " lost " + String(linkProbesLost);
+  oledText[3] = "RSSI " + String(linkRssi) + " ~" + String(linkRssiAverage);
+  oledText[4] = "min " + String(linkRssiMin);
+  oledText[5] = getText(TEXT_MENU_ITEM_TEXT_MENU_HEARTBEAT);
+  oledText[6] = "WiFi conn " + String(linkWifiConnectCount);
+  oledText[7] = "WiT conn " + String(linkServerConnectCount);
+  oledText[8] = "Roams " + String(roamCount);
+  oledText[9] = "Ch " + String(WiFi.channel());
+  writeOledArray(false, false);
+}
+
+// *********************************************************************************
 //   Rotary Encoder
 // *********************************************************************************
 
 AiEsp32RotaryEncoder rotaryEncoder = AiEsp32RotaryEncoder(ROTARY_ENCODER_A_PIN, ROTARY_ENCODER_B_PIN, ROTARY_ENCODER_BUTTON_PIN, ROTARY_ENCODER_VCC_PIN, ROTARY_ENCODER_STEPS);
+
+// quadrature transitions. index = (previous BA << 2) | current BA, B in the high bit.  Same as the encoder library
+static const int8_t DRAM_ATTR encoderQuadratureTable[16] = {0, -1, 1, 0, 1, 0, 0, -1, -1, 0, 0, 1, 0, 1, -1, 0};
+
+// every detent is timestamped and queued, so none are lost however long the loop takes
 void IRAM_ATTR readEncoderISR(void) {
-  rotaryEncoder.readEncoder_ISR();
+  uint8_t ab = (digitalRead(ROTARY_ENCODER_B_PIN) ? 2 : 0) | (digitalRead(ROTARY_ENCODER_A_PIN) ? 1 : 0);
+  encoderQuadratureState = ((encoderQuadratureState << 2) | ab) & 0x0F;
+  encoderQuadratureCount += encoderQuadratureTable[encoderQuadratureState];
+  if ( (encoderQuadratureCount < ROTARY_ENCODER_STEPS) && (encoderQuadratureCount > -ROTARY_ENCODER_STEPS) ) return;
+
+  int8_t direction = (encoderQuadratureCount > 0) ? 1 : -1;
+  encoderQuadratureCount = 0;
+  uint8_t head = encoderRingHead;
+  uint8_t next = (head + 1) & (ENCODER_RING_SIZE - 1);
+  if (next == encoderRingTail) { // full
+    portENTER_CRITICAL_ISR(&encoderRingMux);
+    encoderRingOverflow += direction;
+    portEXIT_CRITICAL_ISR(&encoderRingMux);
+    return;
+  }
+  encoderRingDirection[head] = direction;
+  encoderRingTime[head] = micros();
+  encoderRingHead = next;   // publish after the entry is written
 }
 
 void rotary_onButtonClick() {
@@ -1315,16 +2794,16 @@ void rotary_onButtonClick() {
 
       // if (encoderButtonAction == SPEED_STOP_THEN_TOGGLE_DIRECTION) {
       //   if (wiThrottleProtocol.getNumberOfLocomotives(currentThrottleIndexChar)>0) {
-      //     if (currentSpeed[currentThrottleIndex] != 0) {
+      //     if (throttleStates[currentThrottleIndex].speed != 0) {
       //       // wiThrottleProtocol.setSpeed(currentThrottleIndexChar, 0);
       //       speedSet(currentThrottleIndex,0);
       //     } else {
       //       if (toggleDirectionOnEncoderButtonPressWhenStationary) toggleDirection(currentThrottleIndex);
       //     }
-      //     currentSpeed[currentThrottleIndex] = 0;
+      //     throttleStates[currentThrottleIndex].speed = 0;
       //   }
       // } else {
-        doDirectAction(encoderButtonAction);
+        encoderButtonHandler();
       // }
       debug_println("encoder button pressed");
       writeOledSpeed();
@@ -1341,76 +2820,84 @@ void rotary_onButtonClick() {
 }
 
 void rotary_loop() {
-  if (rotaryEncoder.encoderChanged()) {   //don't print anything unless value changed
-    
-    encoderValue = rotaryEncoder.readEncoder();
-    debug_print("Encoder From: "); debug_print(lastEncoderValue);  debug_print(" to: "); debug_println(encoderValue);
+  int detents = 0;   // net, in this loop
+  int steps = 0;     // net, with the fast multiplier applied to detents that came quickly enough
+  bool debouncing = ( (millis() - rotaryEncoderButtonLastTimePressed) < rotaryEncoderButtonEncoderDebounceTime );
+
+  while (encoderRingTail != encoderRingHead) {
+    uint8_t tail = encoderRingTail;
+    int8_t direction = encoderRingDirection[tail];
+    unsigned long time = encoderRingTime[tail];
+    encoderRingTail = (tail + 1) & (ENCODER_RING_SIZE - 1);
+
+    unsigned long interval = time - encoderLastDetentTime;
+    bool fast = (direction == encoderLastDetentDirection) 
+                && (interval < (1000000UL / ENCODER_FAST_DETENTS_PER_SECOND));
+    encoderLastDetentTime = time;
+    encoderLastDetentDirection = direction;
+    if (debouncing) continue;   //ignore the encoder change if the button was pressed recently
+
+    detents += direction;
+    steps += (fast) ? direction * speedStepMultiplier : direction;
+  }
 
-    if ( (millis() - rotaryEncoderButtonLastTimePressed) < rotaryEncoderButtonEncoderDebounceTime) {   //ignore the encoder change if the button was pressed recently
-      debug_println("encoder button debounce - in Rotary_loop()");
-      return;
-    // } else {
-    //   debug_print("encoder button debounce - time since last press: ");
-    //   debug_println(millis() - rotaryEncoderButtonLastTimePressed);
+  if (encoderRingOverflow != 0) {
+    portENTER_CRITICAL(&encoderRingMux);
+    int overflow = encoderRingOverflow;
+    encoderRingOverflow = 0;
+    portEXIT_CRITICAL(&encoderRingMux);
+    if (!debouncing) {
+      detents += overflow;
+      steps += overflow;  // their times were not kept, so they are not known to be fast
     }
+  }
 
-    if (abs(encoderValue-lastEncoderValue) > 800) { // must have passed through zero
-      if (encoderValue > 800) {
-        lastEncoderValue = 1001; 
-      } else {
-        lastEncoderValue = 0; 
-      }
-      debug_print("Corrected Encoder From: "); debug_print(lastEncoderValue); debug_print(" to: "); debug_println(encoderValue);
-    }
+  if (detents != 0) encoderDetents(detents, steps);
+
+  if (rotaryEncoder.isEncoderButtonClicked()) {
+    sessionRecordInput('C', '0', 0);
+    rotary_onButtonClick();
+  }
+}
+
+// detents turned (+ clockwise), and the speed steps they are worth (more if turned fast)
+void encoderDetents(int detents, int steps) {
+  latencyMarkInput();
+  debug_print("Encoder detents: "); debug_print(detents); debug_print(" steps: "); debug_println(steps);
  
-    if (encoderUseType == ENCODER_USE_OPERATION) {
-      if (wiThrottleProtocol.getNumberOfLocomotives(currentThrottleIndexChar)>0) {
-        if (encoderValue > lastEncoderValue) {
-          if (abs(encoderValue-lastEncoderValue)<50) {
-            encoderSpeedChange(true, currentSpeedStep[currentThrottleIndex]);
-          } else {
-            encoderSpeedChange(true, currentSpeedStep[currentThrottleIndex]*speedStepMultiplier);
-          }
+  if (encoderUseType == ENCODER_USE_OPERATION) {
+    if ( (wiThrottleProtocol.getNumberOfLocomotives(currentThrottleIndexChar)>0) && (steps != 0) ) {
+      encoderSpeedChange( (steps > 0), abs(steps) * throttleStates[currentThrottleIndex].speedStep);
+    }
+  } else { // (encoderUseType == ENCODER_USE_SSID_PASSWORD) 
+    for (int i=0; i<abs(detents); i++) {
+      if (detents > 0) {
+        if (ssidPasswordCurrentChar==ssidPasswordBlankChar) {
+          ssidPasswordCurrentChar = 66; // 'B'
         } else {
-          if (abs(encoderValue-lastEncoderValue)<50) {
-            encoderSpeedChange(false, currentSpeedStep[currentThrottleIndex]);
-          } else {
-            encoderSpeedChange(false, currentSpeedStep[currentThrottleIndex]*speedStepMultiplier);
-          }
-        } 
-      }
-    } else { // (encoderUseType == ENCODER_USE_SSID_PASSWORD) 
-        if (encoderValue > lastEncoderValue) {
-          if (ssidPasswordCurrentChar==ssidPasswordBlankChar) {
-            ssidPasswordCurrentChar = 66; // 'B'
-          } else {
-            ssidPasswordCurrentChar = ssidPasswordCurrentChar - 1;
-            if ((ssidPasswordCurrentChar < 32) ||(ssidPasswordCurrentChar > 126) ) {
-              ssidPasswordCurrentChar = 126;  // '~'
-            }
+          ssidPasswordCurrentChar = ssidPasswordCurrentChar - 1;
+          if ((ssidPasswordCurrentChar < 32) ||(ssidPasswordCurrentChar > 126) ) {
+            ssidPasswordCurrentChar = 126;  // '~'
           }
+        }
+      } else {
+        if (ssidPasswordCurrentChar==ssidPasswordBlankChar) {
+          ssidPasswordCurrentChar = 64; // '@'
         } else {
-          if (ssidPasswordCurrentChar==ssidPasswordBlankChar) {
-            ssidPasswordCurrentChar = 64; // '@'
-          } else {
-            ssidPasswordCurrentChar = ssidPasswordCurrentChar + 1;
-            if (ssidPasswordCurrentChar > 126) {
-              ssidPasswordCurrentChar = 32; // ' ' space
-            }
+          ssidPasswordCurrentChar = ssidPasswordCurrentChar + 1;
+          if (ssidPasswordCurrentChar > 126) {
+            ssidPasswordCurrentChar = 32; // ' ' space
           }
         }
-        ssidPasswordChanged = true;
-        writeOledEnterPassword();
+      }
     }
-    lastEncoderValue = encoderValue;
-  }
-  
-  if (rotaryEncoder.isEncoderButtonClicked()) {
-    rotary_onButtonClick();
+    ssidPasswordChanged = true;
+    writeOledEnterPassword();
   }
 }
 
 void encoderSpeedChange(bool rotationIsClockwise, int speedChange) {
+  sessionRecordInput('E', (rotationIsClockwise) ? '1' : '0', speedChange);
   if (encoderRotationClockwiseIsIncreaseSpeed) {
     if (rotationIsClockwise) {
       speedUp(currentThrottleIndex, speedChange);
@@ -1446,7 +2933,7 @@ void throttlePot_loop(bool forceRead) {
   int currentThrottlePotNotch = throttlePotNotch;
   int potValue = analogRead(throttlePotPin);  //Reads the analog value on the throttle pin.
   // potValue = analogRead(throttlePotPin);
-  debug_println("Pot Value: "); debug_println(potValue);
+  debug_log(LOG_LEVEL_INPUT, DEBUG_LEVEL_EXTREME, "Pot Value: ", potValue);
 
   // average out the last x values from the pot
   int noElements = sizeof(lastThrottlePotValues) / sizeof(lastThrottlePotValues[0]);
@@ -1475,7 +2962,7 @@ void throttlePot_loop(bool forceRead) {
   || (forceRead) )  { 
    
     lastThrottlePotValue = avgPotValue;
-    debug_print("Avg Pot Value: "); debug_println(avgPotValue);
+    debug_log(LOG_LEVEL_INPUT, DEBUG_LEVEL_VERBOSE, "Avg Pot Value: ", avgPotValue);
 
     if (throttlePotUseNotches) { // use notches
       throttlePotNotch = 0;
@@ -1497,7 +2984,7 @@ void throttlePot_loop(bool forceRead) {
       if (newSpeed<0) { newSpeed = 0; }
       else if (newSpeed>127) { newSpeed = 127; }
       int iSpeed = newSpeed;
-      debug_print("newSpeed: "); debug_print(newSpeed); debug_print(" iSpeed: "); debug_println(iSpeed);
+      debug_log(LOG_LEVEL_INPUT, DEBUG_LEVEL_VERBOSE, "newSpeed: ", newSpeed, " iSpeed: ", iSpeed);
       speedSet(currentThrottleIndex, iSpeed);
     }  
   }
@@ -1542,10 +3029,13 @@ void keypadEvent(KeypadEvent key) {
   debug_print("keypadEvent((): "); debug_println(key); 
   switch (keypad.getState()){
   case PRESSED:
+    latencyMarkInput();
+    sessionRecordInput('K', key, 1);
     debug_print("Button "); debug_print(String(key - '0')); debug_println(" pushed.");
     doKeyPress(key, true);
     break;
   case RELEASED:
+    sessionRecordInput('K', key, 0);
     doKeyPress(key, false);
     debug_print("Button "); debug_print(String(key - '0')); debug_println(" released.");
     break;
@@ -1568,6 +3058,9 @@ void keypadEvent(KeypadEvent key) {
 void initialiseAdditionalButtons() {
 
   for (int i = 0; i < maxAdditionalButtons; i++) { 
+    #if USE_NEW_ADDITIONAL_BUTTONS_FORMAT && (NEW_MAX_ADDITIONAL_BUTTONS>0)
+      additionalButtonHandlers[i] = getActionHandler(additionalButtonActions[i]);  // the list format can't be resolved when compiling
+    #endif
     if (additionalButtonActions[i] != FUNCTION_NULL) { 
       debug_print("Additional Button: "); debug_print(i); debug_print(" pin:"); debug_println(additionalButtonPin[i]);
 
@@ -1591,11 +3084,13 @@ void additionalButtonLoop() {
 
       if (additionalButtonLastRead[i] != buttonRead) { // on process on a change
         if ((millis() - lastAdditionalButtonDebounceTime[i]) > additionalButtonDebounceDelay) {   // only process if there is sufficent delay since the last read
+          latencyMarkInput();
           lastAdditionalButtonDebounceTime[i] = millis();
           additionalButtonRead[i] = buttonRead;
 
           if ( ((additionalButtonType[i] == INPUT_PULLUP) && (additionalButtonRead[i] == LOW)) 
               || ((additionalButtonType[i] == INPUT) && (additionalButtonRead[i] == HIGH)) ) {
+            sessionRecordInput('B', '0' + i, 1);
             debug_print("Additional Button Pressed: "); debug_print(i); debug_print(" pin:"); debug_print(additionalButtonPin[i]); debug_print(" action:"); debug_println(additionalButtonActions[i]); 
             if (wiThrottleProtocol.getNumberOfLocomotives(currentThrottleIndexChar) > 0) { // only process if there are locos aquired
               doDirectAdditionalButtonCommand(i,true);
@@ -1606,6 +3101,7 @@ void additionalButtonLoop() {
               }
             }
           } else {
+            sessionRecordInput('B', '0' + i, 0);
             debug_print("Additional Button Released: "); debug_print(i); debug_print(" pin:"); debug_print(additionalButtonPin[i]); debug_print(" action:"); debug_println(additionalButtonActions[i]); 
             if (wiThrottleProtocol.getNumberOfLocomotives(currentThrottleIndexChar) > 0) { // only process if there are locos aquired
               doDirectAdditionalButtonCommand(i,false);
@@ -1625,33 +3121,1071 @@ void additionalButtonLoop() {
   }
 }
 
+// *********************************************************************************
+//  Outbound command scheduler
+// *********************************************************************************
+// Commands for the server are queued by priority class and sent one at a time, 
+// no closer together than outboundCmdsMininumDelay. The highest priority non-empty class always goes first.
+// E Stops are never queued. They are sent immediately and any pending speed commands are dropped.
+// Release and steal are called on the protocol library straight away, as it needs to track them, 
+// but what it writes is captured and queued as OUTBOUND_CMD_RAW so it is paced like everything else.
+
+int getOutboundClass(int type) {
+  switch (type) {
+    case OUTBOUND_CMD_SPEED:
+    case OUTBOUND_CMD_DIRECTION:
+    case OUTBOUND_CMD_DIRECTION_CONSIST:
+    case OUTBOUND_CMD_POWER:
+    case OUTBOUND_CMD_RAW:  // keeps its order with the speed commands for the same throttle
+      return OUTBOUND_CLASS_SPEED_DIRECTION;
+    case OUTBOUND_CMD_FUNCTION:
+      return OUTBOUND_CLASS_FUNCTION;
+    default:
+      return OUTBOUND_CLASS_OTHER;
+  }
+}
+
+void queueOutboundCommand(int type, char multiThrottleChar, int value) {
+  queueOutboundCommand(type, multiThrottleChar, value, "", false, false);
+}
+void queueOutboundCommand(int type, char multiThrottleChar, int value, String text) {
+  queueOutboundCommand(type, multiThrottleChar, value, text, false, false);
+}
+void queueOutboundCommand(int type, char multiThrottleChar, int value, String text, bool state, bool force) {
+  int outboundClass = getOutboundClass(type);
+  int count = outboundQueueCount[outboundClass];
+
+  if (type == OUTBOUND_CMD_SPEED) {  
+    // replace a pending speed for the same throttle, but only if nothing else for that throttle is queued after it
+    for (int i=count-1; i>=0; i--) {
+      if (outboundQueueThrottle[outboundClass][i] == multiThrottleChar) {
+        if (outboundQueueType[outboundClass][i] == OUTBOUND_CMD_SPEED) {
+          outboundQueueValue[outboundClass][i] = value;
+          if (latencyTagCommand()) outboundQueueLatencyTag[outboundClass][i] = true;
+          return;
+        }
+        break;
+      }
+    }
+  }
+
+  if (count >= OUTBOUND_QUEUE_SIZE) {  // make room by dropping the oldest. Sending it now would break the pacing
+    debug_print("outbound queue full - dropped oldest - class: "); debug_println(outboundClass);
+    int oldest = 0;
+    for (int i=0; i<count; i++) {  // the library has already tracked a raw command, so keep those if possible
+      if (outboundQueueType[outboundClass][i] != OUTBOUND_CMD_RAW) { oldest = i; break; }
+    }
+    removeOutboundCommand(outboundClass, oldest);
+    outboundDroppedCount[outboundClass]++;
+    count = outboundQueueCount[outboundClass];
+  }
+
+  outboundQueueType[outboundClass][count] = type;
+  outboundQueueThrottle[outboundClass][count] = multiThrottleChar;
+  outboundQueueValue[outboundClass][count] = value;
+  outboundQueueText[outboundClass][count] = text;
+  outboundQueueState[outboundClass][count] = state;
+  outboundQueueForce[outboundClass][count] = force;
+  outboundQueueTime[outboundClass][count] = millis();
+  outboundQueueLatencyTag[outboundClass][count] = latencyTagCommand();
+  outboundQueueCount[outboundClass] = count + 1;
+
+  outboundCommandsLoop();  // send straight away if the minimum spacing has already passed
+}
+
+void outboundCommandsLoop() {
+  if (millis() - outboundLastSentTime < (unsigned long) outboundCmdsMininumDelay) return;
+  if (roamingState != ROAMING_STATE_IDLE) return;  // held until the new access point has been joined
+
+  for (int outboundClass=0; outboundClass<OUTBOUND_CLASS_COUNT; outboundClass++) {
+    if ( (outboundClass == OUTBOUND_CLASS_OTHER) && (acquireSendNext()) ) {  // acquisitions go before turnouts, routes etc.
+      outboundLastSentTime = millis();
+      return;
+    }
+    if (outboundQueueCount[outboundClass] > 0) {
+      sendNextOutboundCommand(outboundClass);
+      return;
+    }
+  }
+}
+
+void sendNextOutboundCommand(int outboundClass) {
+  int type = outboundQueueType[outboundClass][0];
+  char multiThrottleChar = outboundQueueThrottle[outboundClass][0];
+  int value = outboundQueueValue[outboundClass][0];
+  String text = outboundQueueText[outboundClass][0];
+  bool state = outboundQueueState[outboundClass][0];
+  bool force = outboundQueueForce[outboundClass][0];
+  unsigned long queuedTime = outboundQueueTime[outboundClass][0];
+  if (outboundQueueLatencyTag[outboundClass][0]) latencyCommandSent();
+
+  removeOutboundCommand(outboundClass, 0);
+
+  switch (type) {
+    case OUTBOUND_CMD_SPEED:
+      throttleBackend->setSpeed(multiThrottleChar, value);
+      linkProbeSent(LINK_PROBE_SPEED, multiThrottleChar);
+      break;
+    case OUTBOUND_CMD_DIRECTION:
+      throttleBackend->setDirection(multiThrottleChar, text, (Direction) value, force);
+      linkProbeSent(LINK_PROBE_DIRECTION, multiThrottleChar);
+      break;
+    case OUTBOUND_CMD_DIRECTION_CONSIST:
+      sendConsistDirection(getMultiThrottleIndex(multiThrottleChar), (Direction) value);
+      linkProbeSent(LINK_PROBE_DIRECTION, multiThrottleChar);
+      break;
+    case OUTBOUND_CMD_POWER:
+      throttleBackend->setTrackPower((TrackPower) value);
+      break;
+    case OUTBOUND_CMD_FUNCTION:
+      throttleBackend->setFunction(multiThrottleChar, text, value, state, force);
+      if (throttleBackend != &dccExBackend) linkProbeSent(LINK_PROBE_FUNCTION, multiThrottleChar);  // DCC-EX does not echo functions
+      break;
+    case OUTBOUND_CMD_TURNOUT:
+      throttleBackend->setTurnout(text, (TurnoutAction) value);
+      break;
+    case OUTBOUND_CMD_ROUTE:
+      throttleBackend->setRoute(text);
+      break;
+    case OUTBOUND_CMD_QUERY_DIRECTION:
+      wiThrottleProtocol.getDirection(multiThrottleChar, text);
+      break;
+    case OUTBOUND_CMD_QUERY_SPEED:
+      wiThrottleProtocol.getSpeed(multiThrottleChar);
+      break;
+    case OUTBOUND_CMD_CUSTOM:
+      wiThrottleProtocol.sendCommand(text);
+      break;
+    case OUTBOUND_CMD_RAW:
+      witStream.write((const uint8_t *) text.c_str(), text.length());
+      break;
+  }
+  outboundLastSentTime = millis();
+  recordOutboundWait(outboundClass, outboundLastSentTime - queuedTime);
+}
+
+void removeOutboundCommand(int outboundClass, int index) {
+  int count = outboundQueueCount[outboundClass];
+  for (int i=index; i<count-1; i++) {
+    outboundQueueType[outboundClass][i] = outboundQueueType[outboundClass][i+1];
+    outboundQueueThrottle[outboundClass][i] = outboundQueueThrottle[outboundClass][i+1];
+    outboundQueueValue[outboundClass][i] = outboundQueueValue[outboundClass][i+1];
+    outboundQueueText[outboundClass][i] = outboundQueueText[outboundClass][i+1];
+    outboundQueueState[outboundClass][i] = outboundQueueState[outboundClass][i+1];
+    outboundQueueForce[outboundClass][i] = outboundQueueForce[outboundClass][i+1];
+    outboundQueueTime[outboundClass][i] = outboundQueueTime[outboundClass][i+1];
+    outboundQueueLatencyTag[outboundClass][i] = outboundQueueLatencyTag[outboundClass][i+1];
+  }
+  outboundQueueText[outboundClass][count-1] = "";
+  outboundQueueCount[outboundClass] = count - 1;
+}
+
+// capture what the protocol library writes, instead of sending it
+void outboundCaptureStart() {
+  outboundCapture = "";
+  witStream.capture(&outboundCapture);
+}
+
+// stop capturing and queue whatever was written
+void outboundCaptureQueue(char multiThrottleChar) {
+  witStream.capture(NULL);
+  if (outboundCapture.length() > 0) queueOutboundCommand(OUTBOUND_CMD_RAW, multiThrottleChar, 0, outboundCapture);
+  outboundCapture = "";
+}
+
+// the library forgets the loco straight away, the release itself is paced
+void queueReleaseLoco(char multiThrottleChar, String loco) {
+  outboundCaptureStart();
+  wiThrottleProtocol.releaseLocomotive(multiThrottleChar, loco);
+  outboundCaptureQueue(multiThrottleChar);
+}
+
+void recordOutboundWait(int outboundClass, unsigned long wait) {
+  outboundSentCount[outboundClass]++;
+  if (wait > outboundMaxWait[outboundClass]) {
+    outboundMaxWait[outboundClass] = wait;
+    debug_print("outbound: worst wait class "); debug_print(outboundClass); 
+    debug_print(": "); debug_print(wait); debug_println("ms");
+  }
+}
+
+// multiThrottleChar '*' = all throttles
+void sendOutboundEstop(char multiThrottleChar) {
+  unsigned long startTime = millis();
+  dropOutboundSpeedCommands(multiThrottleChar);
+  throttleBackend->emergencyStop(multiThrottleChar);
+  if (latencyTagCommand()) latencyCommandSent();
+  flushOutbound();  // don't wait for the end of the loop
+  outboundLastSentTime = millis();
+  recordOutboundWait(OUTBOUND_CLASS_ESTOP, outboundLastSentTime - startTime);
+}
+
+// multiThrottleChar '*' = all throttles
+void dropOutboundSpeedCommands(char multiThrottleChar) {
+  int speedClass = getOutboundClass(OUTBOUND_CMD_SPEED);
+  for (int i=outboundQueueCount[speedClass]-1; i>=0; i--) {
+    if ( (outboundQueueType[speedClass][i] == OUTBOUND_CMD_SPEED)
+    && ( (multiThrottleChar == '*') || (outboundQueueThrottle[speedClass][i] == multiThrottleChar) ) ) {
+      removeOutboundCommand(speedClass, i);
+    }
+  }
+}
+
+// send everything the protocol has written since the last flush in one write
+void flushOutbound() {
+  if (witStream.flushWrites() > 0) {
+    latencyMarkWire();
+  }
+}
+
+// send everything still queued, still paced, e.g. before disconnecting
+void drainOutbound() {
+  for (int outboundClass=0; outboundClass<OUTBOUND_CLASS_COUNT; outboundClass++) {
+    while (outboundQueueCount[outboundClass] > 0) {
+      outboundCommandsLoop();
+      flushOutbound();
+      delay(1);
+    }
+  }
+}
+
+void clearOutboundQueue() {
+  for (int outboundClass=0; outboundClass<OUTBOUND_CLASS_COUNT; outboundClass++) {
+    while (outboundQueueCount[outboundClass] > 0) {
+      removeOutboundCommand(outboundClass, outboundQueueCount[outboundClass]-1);
+    }
+  }
+  clearAcquireQueue();
+}
+
+
+// *********************************************************************************
+//  Loco acquisition pipeline
+// *********************************************************************************
+// Acquisitions (from the menu, the roster or restoring saved locos) are queued, and sent by the
+// outbound command scheduler, after any speed, direction and function commands but before the rest.
+// Each loco takes two paced commands: the acquire, then the query for its direction 
+// (and the throttle's speed, for the first loco of each throttle).
+// The redraws for the replies are held back until the batch has settled, then drawn once.  It has settled 
+// when every loco's direction reply has arrived, or the server has gone quiet, or ACQUIRE_SETTLE_MAX ms 
+// after the last was sent at most.
+
+void queueAcquireLoco(char multiThrottleChar, String loco) {
+  if (acquireQueueCount >= ACQUIRE_QUEUE_SIZE) {  // more than all the throttles can hold
+    debug_print("queueAcquireLoco(): queue full - dropped: "); debug_println(loco);
+    return;
+  }
+  if (!acquireBatchActive) {
+    acquireBatchActive = true;
+    acquireBatchStartTime = millis();
+    acquireBatchLastReplyTime = acquireBatchStartTime;
+    acquireBatchLocoCount = 0;
+    acquireBatchRepliesPending = 0;
+    acquireBatchThrottles = 0;
+  }
+  acquireQueueThrottle[acquireQueueCount] = multiThrottleChar;
+  acquireQueueLoco[acquireQueueCount] = loco;
+  acquireQueueAdded[acquireQueueCount] = false;
+  acquireQueueCount++;
+}
+
+// called by the outbound command scheduler when it is time to send.  false if there is nothing to send
+bool acquireSendNext() {
+  if (acquireQueueCount == 0) return false;
+
+  char multiThrottleChar = acquireQueueThrottle[0];
+  int multiThrottleIndex = getMultiThrottleIndex(multiThrottleChar);
+  bool firstForThrottle = !(acquireBatchThrottles & (1 << multiThrottleIndex));
+
+  if (!acquireQueueAdded[0]) {
+    debug_print("add Loco: "); debug_println(acquireQueueLoco[0]);
+    if (wiThrottleProtocol.getNumberOfLocomotives(multiThrottleChar) == 0) throttleReleased(multiThrottleIndex);
+    if (firstForThrottle) resetFunctionStates(multiThrottleIndex);
+    wiThrottleProtocol.addLocomotive(multiThrottleChar, acquireQueueLoco[0]);
+    invalidateDerivedState(multiThrottleIndex);
+    acquireQueueAdded[0] = true;
+    acquireBatchLocoCount++;
+    acquireBatchRepliesPending++;
+
+  } else {
+    wiThrottleProtocol.getDirection(multiThrottleChar, acquireQueueLoco[0]);
+    if (firstForThrottle) wiThrottleProtocol.getSpeed(multiThrottleChar);
+    acquireBatchThrottles |= (1 << multiThrottleIndex);
+    removeAcquireLoco(0);
+    if (acquireQueueCount == 0) writeOledSpeed();   // once for the whole batch
+  }
+  acquireLastSendTime = millis();
+  return true;
+}
+
+void removeAcquireLoco(int index) {
+  for (int i=index; i<acquireQueueCount-1; i++) {
+    acquireQueueThrottle[i] = acquireQueueThrottle[i+1];
+    acquireQueueLoco[i] = acquireQueueLoco[i+1];
+    acquireQueueAdded[i] = acquireQueueAdded[i+1];
+  }
+  acquireQueueCount--;
+  acquireQueueLoco[acquireQueueCount] = "";
+}
+
+// forget the locos not yet sent for a throttle, e.g. when it is released
+void dropAcquireLocos(char multiThrottleChar) {
+  for (int i=acquireQueueCount-1; i>=0; i--) {
+    if ( (acquireQueueThrottle[i] == multiThrottleChar) && (!acquireQueueAdded[i]) ) removeAcquireLoco(i);
+  }
+}
+
+// works out when the batch has settled
+void acquireLoop() {
+  if (!acquireBatchActive) return;
+  unsigned long now = millis();
+  if (acquireQueueCount > 0) return;  // still being sent
+  if ((now - acquireLastSendTime) < ACQUIRE_SETTLE_MAX) {
+    if ( (acquireBatchRepliesPending > 0) 
+    && ((now - witStream.getLastReceiveTime()) < ACQUIRE_SETTLE_TIME) ) return;
+  } else {
+    debug_println("acquireLoop(): not all the replies arrived in time");
+  }
+
+  acquireBatchActive = false;
+  acquireBatchRepliesPending = 0;
+  unsigned long elapsed = ( (long) (acquireBatchLastReplyTime - acquireBatchStartTime) > 0 ) ? (acquireBatchLastReplyTime - acquireBatchStartTime) : 1;
+  acquireLastBatchLocoCount = acquireBatchLocoCount;
+  acquireLastBatchTime = elapsed;
+  debug_print("acquireLoop(): acquired "); debug_print(acquireBatchLocoCount); 
+  debug_print(" locos in "); debug_print(elapsed); debug_print("ms. locos/s: "); 
+  debug_println( (acquireBatchLocoCount * 1000.0) / elapsed );
+
+  if (nvsLegacyLocoKeys) {
+    debug_println("acquireLoop(): Converting the saved locos to a single record");
+    writePreferences();
+  }
+  roamingRestoreThrottles();
+  displayUpdateFromWit(currentThrottleIndex);
+}
+
+void acquireReplyReceived() {
+  if ( (!acquireBatchActive) || (acquireBatchRepliesPending <= 0) ) return;
+  acquireBatchRepliesPending--;
+  acquireBatchLastReplyTime = millis();
+}
+
+void clearAcquireQueue() {
+  for (int i=0; i<acquireQueueCount; i++) acquireQueueLoco[i] = "";
+  acquireQueueCount = 0;
+  acquireBatchThrottles = 0;
+  acquireBatchActive = false;
+  acquireBatchRepliesPending = 0;
+}
+
+// *********************************************************************************
+//  Latency benchmark
+// *********************************************************************************
+// Input (keypad, encoder, additional buttons) is timestamped when it arrives.  
+// The action it triggers names the scenario. The first command queued after that is the scenario's own,
+// and the write that carries it to the server is the 'wire' time. The next oLED buffer transfer is the 'pixel' time.
+// An input that does not start a scenario in the same loop is forgotten.
+// Only enabled with #define LATENCY_BENCHMARK true
+
+void latencyMarkInput() {
+#if LATENCY_BENCHMARK
+  latencyInputTime = micros();
+  latencyInputPending = true;
+#endif
+}
+
+void latencyStartScenario(int scenario) {
+#if LATENCY_BENCHMARK
+  // the first action for an input owns it.  Give up on one that never completed after a second
+  if ( (latencyScenario != LATENCY_SCENARIO_NONE) 
+  && (micros() - latencyScenarioStartTime < 1000000) ) return;
+  latencyScenarioStartTime = (latencyInputPending) ? latencyInputTime : micros();
+  latencyInputPending = false;
+  latencyScenario = scenario;
+  latencyWirePending = (scenario != LATENCY_SCENARIO_THROTTLE_SWITCH);  // nothing is sent for a throttle switch
+  latencyWireTagged = false;
+  latencyWireSent = false;
+  latencyPixelPending = true;
+#endif
+}
+
+// called at the end of each loop.  Input that has not started a scenario by now never will
+void latencyEndLoop() {
+#if LATENCY_BENCHMARK
+  latencyInputPending = false;
+#endif
+}
+
+// a command is being queued. Returns true if it is the one the current scenario is waiting for
+bool latencyTagCommand() {
+#if LATENCY_BENCHMARK
+  if ( (latencyScenario == LATENCY_SCENARIO_NONE) || (!latencyWirePending) || (latencyWireTagged) ) return false;
+  latencyWireTagged = true;
+  return true;
+#else
+  return false;
+#endif
+}
+
+// the scenario's command has been written to the socket buffer
+void latencyCommandSent() {
+#if LATENCY_BENCHMARK
+  latencyWireSent = true;
+#endif
+}
+
+void latencyMarkWire() {
+#if LATENCY_BENCHMARK
+  if ( (latencyScenario == LATENCY_SCENARIO_NONE) || (!latencyWirePending) || (!latencyWireSent) ) return;
+  latencyAddSample(latencyWireSamples[latencyScenario], latencyWireSampleCount[latencyScenario], micros() - latencyScenarioStartTime);
+  latencyWirePending = false;
+  latencyWireSent = false;
+  latencyEndScenarioIfComplete();
+#endif
+}
+
+void latencyMarkPixel() {
+#if LATENCY_BENCHMARK
+  if ( (latencyScenario == LATENCY_SCENARIO_NONE) || (!latencyPixelPending) ) return;
+  latencyAddSample(latencyPixelSamples[latencyScenario], latencyPixelSampleCount[latencyScenario], micros() - latencyScenarioStartTime);
+  latencyPixelPending = false;
+  latencyEndScenarioIfComplete();
+#endif
+}
+
+#if LATENCY_BENCHMARK
+void latencyEndScenarioIfComplete() {
+  if ( (!latencyWirePending) && (!latencyPixelPending) ) {
+    latencyScenario = LATENCY_SCENARIO_NONE;
+  }
+}
+
+void latencyAddSample(unsigned long *samples, int &count, unsigned long sample) {
+  samples[count % LATENCY_BENCHMARK_SAMPLES] = sample;  // oldest samples are overwritten
+  count++;
+  latencyNewSamples = true;
+}
+
+int compareLatencies(const void *a, const void *b) {
+  unsigned long la = *(const unsigned long *)a;
+  unsigned long lb = *(const unsigned long *)b;
+  return (la > lb) - (la < lb);
+}
+
+void latencyPrintPercentiles(String label, unsigned long *samples, int count) {
+  int n = (count < LATENCY_BENCHMARK_SAMPLES) ? count : LATENCY_BENCHMARK_SAMPLES;
+  Serial.print(label);
+  if (n == 0) {
+    Serial.print(" -");
+    return;
+  }
+  unsigned long sorted[LATENCY_BENCHMARK_SAMPLES];
+  memcpy(sorted, samples, n * sizeof(unsigned long));
+  qsort(sorted, n, sizeof(unsigned long), compareLatencies);
+  Serial.print(" n:"); Serial.print(n);
+  Serial.print(" p50:"); Serial.print(sorted[(n-1) * 50 / 100]);
+  Serial.print(" p99:"); Serial.print(sorted[(n-1) * 99 / 100]);
+}
+#endif
+
+void latencyReportLoop() {
+#if LATENCY_BENCHMARK
+  if ( (!latencyNewSamples) || (millis() - latencyLastReportTime < LATENCY_BENCHMARK_REPORT_INTERVAL) ) return;
+  latencyLastReportTime = millis();
+  latencyNewSamples = false;
+
+  const String scenarioNames[LATENCY_SCENARIO_COUNT] = {"speed up", "e stop", "function", "consist reverse", "throttle switch"};
+  Serial.println("Latency (us) - input to wire / input to pixel");
+  for (int i=0; i<LATENCY_SCENARIO_COUNT; i++) {
+    Serial.print("  "); Serial.print(scenarioNames[i]); Serial.print(": ");
+    latencyPrintPercentiles("wire", latencyWireSamples[i], latencyWireSampleCount[i]);
+    latencyPrintPercentiles(" | pixel", latencyPixelSamples[i], latencyPixelSampleCount[i]);
+    Serial.println("");
+  }
+  Serial.print("  oLED frames: "); Serial.print(oledFramesSent);
+  Serial.print(useAsyncDisplay ? " async" : " sync");
+  Serial.print(" blocked per frame avg:"); Serial.print( (oledFramesSent>0) ? (oledBlockedTimeTotal / oledFramesSent) : 0 );
+  Serial.print(" max:"); Serial.print(oledBlockedTimeMax);
+  Serial.print(" dropped:"); Serial.println(oledFramesDropped);
+  Serial.print("  consist rebuilds: "); Serial.println(derivedStateRebuildCount);
+#endif
+}
+
+// *********************************************************************************
+//  Session recorder and replay
+// *********************************************************************************
+// Records the session to the serial console, one event per line:
+//   #REC <millis> I <line received from the server>
+//   #REC <millis> K <key> <1=pressed 0=released>
+//   #REC <millis> E <1=clockwise 0=anticlockwise> <speed change>     encoder rotation
+//   #REC <millis> C 0 0                                              encoder button click
+//   #REC <millis> B <'0'+button index> <1=pressed 0=released>         additional buttons
+// Commands typed/sent on the serial console:
+//   #RECORD ON | #RECORD OFF
+//   #REPLAY <speed>   then the #REC lines, one at a time after each #NEXT, then #END
+// A replay feeds the lines received through the normal inbound path (and so the delegate) and 
+// the input through the same functions as the real input, at the original timing divided by 
+// the speed (0 = as fast as possible).  Without a server connection the replay runs offline.
+// At the end the loop stage timings for the replay are printed.
+// See tools/session_replay.py.  Only enabled with #define SESSION_RECORDER true
+
+bool sessionRecordLine(const char* line, int length) {
+#if SESSION_RECORDER
+  if ( (!sessionRecording) || (sessionReplaying) ) return false;
+  Serial.print("#REC "); Serial.print(millis()); Serial.print(" I ");
+  Serial.write((const uint8_t *) line, length);
+  Serial.println("");
+#endif
+  return false;
+}
+
+void sessionRecordInput(char type, char key, int value) {
+#if SESSION_RECORDER
+  if ( (!sessionRecording) || (sessionReplaying) ) return;
+  Serial.print("#REC "); Serial.print(millis()); Serial.print(" "); Serial.print(type); 
+  Serial.print(" "); Serial.print(key); Serial.print(" "); Serial.println(value);
+#endif
+}
+
+void sessionLoop() {
+#if SESSION_RECORDER
+  if (sessionReplayEventPending) {
+    unsigned long due = sessionReplayStartTime;
+    if (sessionReplaySpeed > 0) due += (unsigned long) ((sessionReplayEventTime - sessionReplayFirstEventTime) / sessionReplaySpeed);
+    if ((long) (millis() - due) < 0) return;
+    sessionReplayEvent();
+  }
+
+  if ( (sessionReplaying) && (sessionReplayOffline) ) {
+    wiThrottleProtocol.check();  // there is no connected loop to do it
+    derivedStateLibraryChecked();
+  }
+#endif
+}
+
+// reads the commands for the recorder and the serial API, one line at a time
+void serialCommandLoop() {
+#if SESSION_RECORDER || SERIAL_API
+  while (Serial.available() > 0) {
+#if SESSION_RECORDER
+    if (sessionReplayEventPending) return;  // leave the rest until it is due
+#endif
+    char c = Serial.read();
+    if ( (c == '\n') || (c == '\r') ) {
+      if ( (serialLineLength > 0) && (!serialLineOverflow) ) {
+        serialLine[serialLineLength] = 0;
+        serialLineLength = 0;
+#if SERIAL_API
+        if (serialApiCommand()) continue;
+#endif
+#if SESSION_RECORDER
+        sessionSerialCommand();
+#endif
+      }
+      serialLineLength = 0;
+      serialLineOverflow = false;
+    } else if (serialLineLength < SESSION_REPLAY_LINE_SIZE - 1) {
+      serialLine[serialLineLength++] = c;
+    } else {
+      serialLineOverflow = true;  // too long. Ignore it
+    }
+  }
+#endif
+}
+
+#if SESSION_RECORDER
+void sessionSerialCommand() {
+  if (strncmp(serialLine, "#REC ", 5) == 0) {
+    if (!sessionReplaying) return;
+    char *end;
+    sessionReplayEventTime = strtoul(serialLine + 5, &end, 10);
+    if ( (*end != ' ') || (end[1] == 0) ) return;  // not valid
+    if (sessionReplayFirstEvent) {
+      sessionReplayFirstEventTime = sessionReplayEventTime;
+      sessionReplayStartTime = millis();
+      sessionReplayFirstEvent = false;
+    }
+    memmove(serialLine, end + 1, strlen(end + 1) + 1);   // keep '<type> <data>'
+    sessionReplayEventPending = true;
+
+  } else if (strncmp(serialLine, "#REPLAY", 7) == 0) {
+    sessionReplaySpeed = (serialLine[7] == ' ') ? atof(serialLine + 8) : 1.0;
+    if (sessionReplaySpeed < 0) sessionReplaySpeed = 0;
+    sessionReplaying = true;
+    sessionReplayFirstEvent = true;
+    sessionReplayEventCount = 0;
+    sessionReplayOffline = (witConnectionState != CONNECTION_STATE_CONNECTED);
+    if (sessionReplayOffline) {  // nothing is sent anywhere
+      wiThrottleProtocol.setDelegate(&myDelegate);
+      witStream.begin(NULL);
+      witStream.setLineHandler(witStreamFastParse);
+      wiThrottleProtocol.connect(&witStream, 0);
+      invalidateDerivedState(-1);
+      keypadUseType = KEYPAD_USE_OPERATION;
+    }
+    loopStageReset();
+    Serial.print("#REPLAY speed: "); Serial.print(sessionReplaySpeed); 
+    Serial.println( (sessionReplayOffline) ? " offline" : " connected" );
+    Serial.println("#NEXT");
+
+  } else if (strcmp(serialLine, "#END") == 0) {
+    if (!sessionReplaying) return;
+    sessionReplaying = false;
+    roamingSimulatedRssi = 0;
+    sessionReplayReport();
+
+  } else if (strcmp(serialLine, "#RECORD ON") == 0) {
+    sessionRecording = true;
+    loopStageReset();
+  } else if (strcmp(serialLine, "#RECORD OFF") == 0) {
+    sessionRecording = false;
+
+  } else if (strncmp(serialLine, "#RSSI ", 6) == 0) {  // e.g. '#RSSI -80'.  '#RSSI OFF' to use the measured RSSI again
+    roamingSimulate(serialLine + 6);
+    Serial.print("#RSSI "); Serial.println(roamingSimulatedRssi);
+  }
+}
+
+// the pending event is in serialLine as '<type> <data>'
+void sessionReplayEvent() {
+  sessionReplayEventPending = false;
+  sessionReplayEventCount++;
+  char type = serialLine[0];
+  char *data = serialLine + 2;
+
+  if (type == 'I') {
+    if (!witStream.inject(data, strlen(data))) {
+      Serial.println("#REPLAY line dropped");
+    }
+  } else if (strlen(data) >= 3) {
+    char key = data[0];
+    int value = atoi(data + 2);
+    switch (type) {
+      case 'K':
+        latencyMarkInput();
+        doKeyPress(key, value == 1);
+        break;
+      case 'E':
+        latencyMarkInput();
+        encoderSpeedChange(key == '1', value);
+        break;
+      case 'C':
+        latencyMarkInput();
+        rotary_onButtonClick();
+        break;
+      case 'W':
+        roamingSimulatedRssi = value;
+        break;
+      case 'B':
+        if ( (key - '0' >= 0) && (key - '0' < maxAdditionalButtons) ) {
+          latencyMarkInput();
+          doDirectAdditionalButtonCommand(key - '0', value == 1);
+        }
+        break;
+    }
+  }
+  Serial.println("#NEXT");
+}
+
+void sessionReplayReport() {
+  unsigned long elapsed = millis() - sessionReplayStartTime;
+  Serial.print("#REPORT events: "); Serial.print(sessionReplayEventCount);
+  Serial.print(" elapsed (ms): "); Serial.print(elapsed);
+  Serial.print(" loops: "); Serial.println(loopStageLoopCount);
+  loopStageReport();
+  Serial.println("#REPORT END");
+}
+#endif
+
+// *********************************************************************************
+//  Serial API
+// *********************************************************************************
+// Drives the WiTcontroller from the serial console, e.g. for automated tests and benchmarks.
+// One command per line.  Each is answered with any result lines, then '#OK' or '#ERR <reason>'
+//   #ACTION <code> [1|0]      any action or function code from actions.h. Pressed and released if no state
+//   #KEY <key> [1|0]          keypad key. Pressed and released if no state
+//   #KEYS <keys>              each key pressed and released in turn.  Anything not on the keypad is an error
+//   #MENU <command>           the same as the keys '*' <command> '#'
+//   #ENC <detents>            encoder turned. + = clockwise
+//   #CLICK                    encoder button
+//   #BUTTON <index> [1|0]     additional button. Pressed and released if no state
+//   #GET STATE                #STATE connection:<n> keypad:<n> encoder:<n> screen:<n> menu:<0|1> throttle:<index> throttles:<n>
+//   #GET THROTTLES            #THROTTLE <index> locos:<n> speed:<n> direction:<F|R> functions:<hex>   for each throttle
+//   #GET LOCOS [index]        #LOCO <index> <position> <loco>   for each loco on the throttle (default: current)
+//   #GET METRICS              #METRIC <name> <value>   for each
+//   #RSSI <dBm> [<dBm>]       use this RSSI for roaming instead of the measured one. 'OFF' to stop.
+//                             With a second value the current access point is offered to move to at that RSSI
+// The input goes through the same functions as the real keypad, encoder and buttons.
+// Only enabled with #define SERIAL_API true
+
+#if SERIAL_API
+// returns false if it isn't a serial API command
+bool serialApiCommand() {
+  const char* line = serialLine;
+  bool ok = true;
+
+  if (strncmp(line, "#ACTION ", 8) == 0) {
+    char *end;
+    int action = strtol(line + 8, &end, 10);
+    if ( (action>=FUNCTION_0) && (action<=FUNCTION_31) ) {
+      serialApiInput('F', action, (*end == ' ') ? atoi(end + 1) : -1);
+    } else {
+      ActionHandler handler = getActionHandler(action);
+      if (handler != nullptr) {
+        latencyMarkInput();
+        handler();
+      } else {
+        ok = false;
+      }
+    }
+
+  } else if ( (strncmp(line, "#KEY ", 5) == 0) && (line[5] != 0) ) {
+    if ( (serialApiIsKey(line[5])) && ((line[6] == 0) || (line[6] == ' ')) ) {
+      serialApiInput('K', line[5], (line[6] == ' ') ? atoi(line + 7) : -1);
+    } else {
+      ok = false;
+    }
+
+  } else if (strncmp(line, "#KEYS ", 6) == 0) {
+    if (serialApiAreKeys(line + 6)) {
+      for (int i=6; line[i] != 0; i++) serialApiInput('K', line[i], -1);
+    } else {
+      ok = false;
+    }
+
+  } else if (strncmp(line, "#MENU ", 6) == 0) {
+    if (serialApiAreKeys(line + 6)) {
+      serialApiInput('K', '*', -1);
+      for (int i=6; line[i] != 0; i++) serialApiInput('K', line[i], -1);
+      serialApiInput('K', '#', -1);
+    } else {
+      ok = false;
+    }
+
+  } else if (strncmp(line, "#ENC ", 5) == 0) {
+    int detents = atoi(line + 5);
+    if (detents != 0) encoderDetents(detents, detents);
+
+  } else if (strcmp(line, "#CLICK") == 0) {
+    latencyMarkInput();
+    rotary_onButtonClick();
+
+  } else if (strncmp(line, "#BUTTON ", 8) == 0) {
+    char *end;
+    int buttonIndex = strtol(line + 8, &end, 10);
+    if ( (buttonIndex >= 0) && (buttonIndex < maxAdditionalButtons) ) {
+      serialApiInput('B', buttonIndex, (*end == ' ') ? atoi(end + 1) : -1);
+    } else {
+      ok = false;
+    }
+
+  } else if (strcmp(line, "#GET STATE") == 0) {
+    serialApiReportState();
+
+  } else if (strcmp(line, "#GET THROTTLES") == 0) {
+    for (int i=0; i<maxThrottles; i++) serialApiReportThrottle(i);
+
+  } else if (strncmp(line, "#GET LOCOS", 10) == 0) {
+    int multiThrottleIndex = (line[10] == ' ') ? atoi(line + 11) : currentThrottleIndex;
+    if ( (multiThrottleIndex >= 0) && (multiThrottleIndex < maxThrottles) ) {
+      char multiThrottleChar = getMultiThrottleChar(multiThrottleIndex);
+      for (int i=0; i<wiThrottleProtocol.getNumberOfLocomotives(multiThrottleChar); i++) {
+        Serial.print("#LOCO "); Serial.print(multiThrottleIndex); Serial.print(" "); Serial.print(i);
+        Serial.print(" "); Serial.println(wiThrottleProtocol.getLocomotiveAtPosition(multiThrottleChar, i));
+      }
+    } else {
+      ok = false;
+    }
+
+  } else if (strcmp(line, "#GET METRICS") == 0) {
+    serialApiReportMetrics();
+
+  } else if (strncmp(line, "#RSSI ", 6) == 0) {
+    roamingSimulate(line + 6);
+
+  } else {
+    return false;  // maybe a recorder command
+  }
+
+  Serial.println( (ok) ? "#OK" : "#ERR invalid" );
+  return true;
+}
+
+// only the keys on this keypad (see KEYPAD_KEYS)
+bool serialApiIsKey(char key) {
+  for (int row=0; row<ROW_NUM; row++) {
+    for (int column=0; column<COLUMN_NUM; column++) {
+      if (keys[row][column] == key) return true;
+    }
+  }
+  return false;
+}
+
+// all of them keys, and at least one.  Checked before any are pressed
+bool serialApiAreKeys(const char* text) {
+  if (*text == 0) return false;
+  for (; *text != 0; text++) {
+    if (!serialApiIsKey(*text)) return false;
+  }
+  return true;
+}
+
+// type 'K' keypad, 'B' additional button, 'F' function.  state -1 = pressed then released
+void serialApiInput(char type, int key, int state) {
+  for (int pass=0; pass<2; pass++) {
+    bool pressed = (state < 0) ? (pass == 0) : (state == 1);
+    if (pressed) latencyMarkInput();
+    switch (type) {
+      case 'K': doKeyPress(key, pressed); break;
+      case 'B': doDirectAdditionalButtonCommand(key, pressed); break;
+      case 'F': doDirectFunction(currentThrottleIndex, key, pressed); break;
+    }
+    if (state >= 0) break;
+  }
+}
+
+void serialApiReportState() {
+  Serial.print("#STATE connection:"); Serial.print(witConnectionState);
+  Serial.print(" keypad:"); Serial.print(keypadUseType);
+  Serial.print(" encoder:"); Serial.print(encoderUseType);
+  Serial.print(" screen:"); Serial.print(lastOledScreen);
+  Serial.print(" menu:"); Serial.print( (menuIsShowing) ? 1 : 0 );
+  Serial.print(" throttle:"); Serial.print(currentThrottleIndex);
+  Serial.print(" throttles:"); Serial.println(maxThrottles);
+}
+
+void serialApiReportThrottle(int multiThrottleIndex) {
+  char functions[9];
+  snprintf(functions, sizeof(functions), "%08lx", (unsigned long) throttleStates[multiThrottleIndex].functionStates);
+  Serial.print("#THROTTLE "); Serial.print(multiThrottleIndex);
+  Serial.print(" locos:"); Serial.print(wiThrottleProtocol.getNumberOfLocomotives(getMultiThrottleChar(multiThrottleIndex)));
+  Serial.print(" speed:"); Serial.print(throttleStates[multiThrottleIndex].speed);
+  Serial.print(" direction:"); Serial.print( (throttleStates[multiThrottleIndex].direction == Forward) ? "F" : "R" );
+  Serial.print(" functions:"); Serial.println(functions);
+}
+
+void serialApiReportMetrics() {
+  const char* names[] = {"uptime_ms", "rtt_p50_ms", "rtt_p90_ms", "rtt_p99_ms", "rtt_answered", "rtt_lost", 
+                         "rssi", "rssi_avg", "rssi_min", "wifi_connects", "server_connects", "roams", 
+                         "lines_handled", "lines_passthrough", "bytes_received", "segments_sent", "bytes_sent",
+                         "consist_rebuilds", "nvs_writes", "nvs_writes_skipped", "oled_frames", "oled_frames_dropped", 
+                         "acquire_locos", "acquire_ms", "heap_free"};
+  long values[] = {(long) millis(), linkRttP50, linkRttP90, linkRttP99, (long) linkProbesAnswered, (long) linkProbesLost,
+                   linkRssi, linkRssiAverage, linkRssiMin, linkWifiConnectCount, linkServerConnectCount, roamCount,
+                   (long) witStream.getHandledLineCount(), (long) witStream.getPassthroughLineCount(), (long) witStream.getBytesReceived(), 
+                   (long) witStream.getSegmentsSent(), (long) witStream.getBytesSent(),
+                   (long) derivedStateRebuildCount, (long) nvsWriteCount, (long) nvsWriteSkippedCount, (long) oledFramesSent, (long) oledFramesDropped,
+                   (long) acquireLastBatchLocoCount, (long) acquireLastBatchTime, (long) ESP.getFreeHeap()};
+  for (unsigned int i=0; i<sizeof(values)/sizeof(values[0]); i++) {
+    Serial.print("#METRIC "); Serial.print(names[i]); Serial.print(" "); Serial.println(values[i]);
+  }
+}
+#endif
+
+// *********************************************************************************
+//  Metrics
+// *********************************************************************************
+// With METRICS_UDP, a datagram is sent every METRICS_UDP_INTERVAL ms while the WiFi is connected.
+// All values little endian. The loop timings cover the time since the last datagram.  See tools/metrics_collector.py
+//   'W' 'T' 'M' <version>   mac[6]   sequence:u32   uptime ms:u32   period ms:u32
+//   loops:u32   loop max us:u32   stage count:u8   then for each stage (see LOOP_STAGE_*): avg us:u32  max us:u32
+//   heap free:u32   heap min free:u32   heap max alloc:u32
+//   rtt p50 ms:u16   rtt p90:u16   rtt p99:u16  (0xFFFF = none)   rtt answered:u32   rtt lost:u32
+//   rssi:i8   rssi avg:i8   rssi min:i8   battery %:i8 (-1 = none)
+//   wifi connects:u16   server connects:u16   roams:u16   ssid state:u8   server state:u8
+//   commands sent:u32   lines received:u32   bytes sent:u32   bytes received:u32   (since connecting to the server)
+//   name length:u8   name
+
+#if METRICS_UDP
+template <typename T> void metricsPut(T value) {
+  if (metricsDatagramLength + (int) sizeof(T) > METRICS_DATAGRAM_SIZE) return;
+  memcpy(metricsDatagram + metricsDatagramLength, &value, sizeof(T));   // the ESP32 is little endian
+  metricsDatagramLength += sizeof(T);
+}
+
+uint16_t metricsRtt(int rtt) {
+  return (rtt < 0) ? 0xFFFF : ((rtt > 0xFFFE) ? 0xFFFE : rtt);
+}
+#endif
+
+void metricsLoop() {
+#if METRICS_UDP
+  unsigned long now = millis();
+  if ((now - metricsLastSendTime) < METRICS_UDP_INTERVAL) return;
+  if (WiFi.status() == WL_CONNECTED) metricsSend();
+  metricsReset();
+#endif
+}
+
+void metricsSend() {
+#if METRICS_UDP
+  unsigned long period = millis() - metricsLastSendTime;
+  uint8_t mac[6];
+  WiFi.macAddress(mac);
+
+  metricsDatagramLength = 0;
+  metricsPut<uint8_t>('W'); metricsPut<uint8_t>('T'); metricsPut<uint8_t>('M'); 
+  metricsPut<uint8_t>(METRICS_DATAGRAM_VERSION);
+  for (int i=0; i<6; i++) metricsPut<uint8_t>(mac[i]);
+  metricsPut<uint32_t>(metricsSequence++);
+  metricsPut<uint32_t>(millis());
+  metricsPut<uint32_t>(period);
+
+  metricsPut<uint32_t>(metricsLoopCount);
+  metricsPut<uint32_t>(metricsLoopMax);
+  metricsPut<uint8_t>(LOOP_STAGE_COUNT);
+  for (int i=0; i<LOOP_STAGE_COUNT; i++) {
+    metricsPut<uint32_t>( (metricsLoopCount > 0) ? (metricsStageTotal[i] / metricsLoopCount) : 0 );
+    metricsPut<uint32_t>(metricsStageMax[i]);
+  }
+
+  metricsPut<uint32_t>(ESP.getFreeHeap());
+  metricsPut<uint32_t>(ESP.getMinFreeHeap());
+  metricsPut<uint32_t>(ESP.getMaxAllocHeap());
+
+  metricsPut<uint16_t>(metricsRtt(linkRttP50));
+  metricsPut<uint16_t>(metricsRtt(linkRttP90));
+  metricsPut<uint16_t>(metricsRtt(linkRttP99));
+  metricsPut<uint32_t>(linkProbesAnswered);
+  metricsPut<uint32_t>(linkProbesLost);
+
+  metricsPut<int8_t>(constrain(linkRssi, -128, 0));
+  metricsPut<int8_t>(constrain(linkRssiAverage, -128, 0));
+  metricsPut<int8_t>(constrain(linkRssiMin, -128, 0));
+  metricsPut<int8_t>( (useBatteryTest) ? lastBatteryTestValue : -1 );
+
+  metricsPut<uint16_t>(linkWifiConnectCount);
+  metricsPut<uint16_t>(linkServerConnectCount);
+  metricsPut<uint16_t>(roamCount);
+  metricsPut<uint8_t>(ssidConnectionState);
+  metricsPut<uint8_t>(witConnectionState);
+
+  uint32_t commandsSent = 0;
+  for (int i=0; i<OUTBOUND_CLASS_COUNT; i++) commandsSent += outboundSentCount[i];
+  metricsPut<uint32_t>(commandsSent);
+  metricsPut<uint32_t>(witStream.getHandledLineCount() + witStream.getPassthroughLineCount());
+  metricsPut<uint32_t>(witStream.getBytesSent());
+  metricsPut<uint32_t>(witStream.getBytesReceived());
+
+  int nameLength = strlen(deviceName);
+  if (nameLength > 32) nameLength = 32;
+  metricsPut<uint8_t>(nameLength);
+  for (int i=0; i<nameLength; i++) metricsPut<uint8_t>(deviceName[i]);
+
+  IPAddress host;
+  if ( (strlen(METRICS_UDP_HOST) == 0) || (!host.fromString(METRICS_UDP_HOST)) ) host = WiFi.broadcastIP();
+  if (metricsUdp.beginPacket(host, METRICS_UDP_PORT)) {
+    metricsUdp.write(metricsDatagram, metricsDatagramLength);
+    metricsUdp.endPacket();
+  }
+#endif
+}
+
+void metricsReset() {
+#if METRICS_UDP
+  metricsLastSendTime = millis();
+  for (int i=0; i<LOOP_STAGE_COUNT; i++) {
+    metricsStageTotal[i] = 0;
+    metricsStageMax[i] = 0;
+  }
+  metricsLoopCount = 0;
+  metricsLoopMax = 0;
+#endif
+}
+
+// loop stage timings (microseconds), while recording or replaying
+
+void loopStageStart() {
+#if SESSION_RECORDER || METRICS_UDP
+  loopStageLastMark = micros();
+#endif
+#if METRICS_UDP
+  metricsLoopStartTime = loopStageLastMark;
+#endif
+}
+
+void loopStageMark(int stage) {
+#if SESSION_RECORDER || METRICS_UDP
+  unsigned long now = micros();
+  unsigned long elapsed = now - loopStageLastMark;
+  loopStageLastMark = now;
+#endif
+#if SESSION_RECORDER
+  loopStageTotal[stage] += elapsed;
+  if (elapsed > loopStageMax[stage]) loopStageMax[stage] = elapsed;
+#endif
+#if METRICS_UDP
+  metricsStageTotal[stage] += elapsed;
+  if (elapsed > metricsStageMax[stage]) metricsStageMax[stage] = elapsed;
+#endif
+}
+
+void loopStageEnd() {
+#if SESSION_RECORDER
+  loopStageLoopCount++;
+#endif
+#if METRICS_UDP
+  metricsLoopCount++;
+  unsigned long elapsed = micros() - metricsLoopStartTime;
+  if (elapsed > metricsLoopMax) metricsLoopMax = elapsed;
+#endif
+}
+
+void loopStageReset() {
+#if SESSION_RECORDER
+  for (int i=0; i<LOOP_STAGE_COUNT; i++) {
+    loopStageTotal[i] = 0;
+    loopStageMax[i] = 0;
+  }
+  loopStageLoopCount = 0;
+#endif
+}
+
+void loopStageReport() {
+#if SESSION_RECORDER
+  const char* stageNames[LOOP_STAGE_COUNT] = {"network", "scheduler", "input", "replay", "other", "flush"};
+  for (int i=0; i<LOOP_STAGE_COUNT; i++) {
+    Serial.print("#REPORT stage "); Serial.print(stageNames[i]);
+    Serial.print(" total (us): "); Serial.print(loopStageTotal[i]);
+    Serial.print(" avg: "); Serial.print( (loopStageLoopCount>0) ? (loopStageTotal[i] / loopStageLoopCount) : 0 );
+    Serial.print(" max: "); Serial.println(loopStageMax[i]);
+  }
+#endif
+}
+
 // *********************************************************************************
 //  Setup and Loop
 // *********************************************************************************
 
 void setup() {
   Serial.begin(115200);
+#if WITCONTROLLER_DEBUG == 0
+  witLog.begin(&Serial, ASYNC_LOG);
+  witLog.startTask(0);
+#endif
   // u8g2.setI2CAddress(0x3C * 2);
   // u8g2.setBusClock(100000);
   u8g2.begin();
   u8g2.firstPage();
+  oledStartSendTask();
 
-  delay(1000);
+  fastResumePending = fastResumeAvailable();
+  if (!fastResumePending) delay(1000);
   debug_println("Start"); 
   debug_print("WiTcontroller - Version: "); debug_println(appVersion);
 
   batteryTest_loop();  // do the battery check once to start
 
-  clearOledArray(); oledText[0] = appName; oledText[6] = appVersion; oledText[2] = MSG_START;
-  writeOledBattery();
-  writeOledArray(false, false, true, true);
+  if (!fastResumePending) {
+    readLanguagePreference();
+    clearOledArray(); oledText[0] = appName; oledText[6] = appVersion; oledText[2] = getText(TEXT_MSG_START);
+    writeOledBattery();
+    writeOledArray(false, false, true, true);
+  }
 
   rotaryEncoder.begin();  //initialize rotary encoder
   rotaryEncoder.setup(readEncoderISR);
-  //set boundaries and if values should cycle or not 
-  rotaryEncoder.setBoundaries(0, 1000, circleValues); //minValue, maxValue, circleValues true|false (when max go to min and vice versa)
-  //rotaryEncoder.disableAcceleration(); //acceleration is now enabled by default - disable if you don't need it
-  rotaryEncoder.setAcceleration(100); //or set the value - larger number = more acceleration; 0 or 1 means disabled acceleration
+  // the detents are decoded in readEncoderISR, so the library's position, boundaries and acceleration are not used
 
   //if EC11 is used in hardware build WITHOUT physical pullup resistore, then make then enable GPIO pullups on EC11 A and B inputs
   if (EC11_PULLUPS_REQUIRED) {
@@ -1675,48 +4209,84 @@ void setup() {
   resetAllFunctionLabels();
   resetAllFunctionFollow();
 
-  for (int i=0; i< 6; i++) {
-    currentSpeed[i] = 0;
-    currentDirection[i] = Forward;
-    currentSpeedStep[i] = speedStep;
+  for (int i=0; i<THROTTLE_POOL_SIZE; i++) {
+    throttleStates[i].speed = 0;
+    momentumCancel(i);
+    throttleStates[i].direction = Forward;
+    throttleStates[i].speedStep = speedStep;
+    buildFunctionListLabels(i);  // including the throttles not in use yet
   }
+  if (fastResumePending) fastResumeStart();
   
   WiFi.setHostname(DEVICE_NAME);
   #if USE_COUNTRY_CODE
     esp_wifi_set_country_code("01", false);
   #endif
+
+  parseStartupCommands();
+  benchmarkActionDispatch();
 }
 
 void loop() {
+  loopStageStart();
   
+  // each stage is marked once per pass, so its max is the longest pass
   if (ssidConnectionState != CONNECTION_STATE_CONNECTED) {
     // connectNetwork();
     ssidsLoop();
     checkForShutdownOnNoResponse();
+    loopStageMark(LOOP_STAGE_NETWORK);
   } else {  
     if (witConnectionState != CONNECTION_STATE_CONNECTED) {
       witServiceLoop();
       checkForShutdownOnNoResponse();
+      loopStageMark(LOOP_STAGE_NETWORK);
     } else {
-      wiThrottleProtocol.check();    // parse incoming messages
+      witStream.poll();              // read the incoming messages. The frequent ones are dealt with here
+      wiThrottleProtocol.check();    // parse the remaining incoming messages
+      derivedStateLibraryChecked();
+      loopStageMark(LOOP_STAGE_NETWORK);
+      witStreamStatsLoop();
+      roamingLoop();
+      linkTelemetryLoop();
+      autoSaveLocosLoop();
+      acquireLoop();                 // draw once the acquisitions have settled
+      momentumLoop();                // move the speeds towards their targets
+      outboundCommandsLoop();        // send the next queued command if it is due
 
       setLastServerResponseTime(false);
 
       if ( (lastServerResponseTime+(heartBeatPeriod*4) < millis()/1000) 
-      && (heartbeatCheckEnabled) ) {
+      && (heartbeatCheckEnabled) && (roamingState == ROAMING_STATE_IDLE) ) {
         debug_print("Disconnected - Last:");  debug_print(lastServerResponseTime); debug_print(" Current:");  debug_println(millis()/1000);
         reconnect();
       }
+      loopStageMark(LOOP_STAGE_SCHEDULER);
     }
   }
+
   // char key = keypad.getKey();
   keypad.getKey(); 
   if (useRotaryEncoderForThrottle) { rotary_loop(); }
   else { throttlePot_loop(); }
   additionalButtonLoop(); 
+  loopStageMark(LOOP_STAGE_INPUT);
+
+  sessionLoop();  // replay
+  serialCommandLoop();  // recorder and serial API commands
+  loopStageMark(LOOP_STAGE_REPLAY);
 
   if (useBatteryTest) { batteryTest_loop(); }
 
+  latencyReportLoop();
+  metricsLoop();
+  loopStageMark(LOOP_STAGE_OTHER);
+
+  flushOutbound();  // send everything written during this loop as one write
+  loopStageMark(LOOP_STAGE_FLUSH);
+  loopStageEnd();
+  latencyEndLoop();
+
 	// debug_println("loop:" );
 }
 
@@ -1891,9 +4461,11 @@ void doKeyPress(char key, bool pressed) {
             selectSsid(key - '0');
             break;
           case '#': // show found SSIds
+            stopSsidScan();
             ssidConnectionState = CONNECTION_STATE_DISCONNECTED;
             keypadUseType = KEYPAD_USE_SELECT_SSID_FROM_FOUND;
             ssidSelectionSource = SSID_CONNECTION_SOURCE_BROWSE;
+            ssidScanFullRequested = true;
             // browseSsids();
             break;
           default:  // do nothing 
@@ -2082,20 +4654,23 @@ void doKeyPress(char key, bool pressed) {
 
 void doDirectCommand(char key, bool pressed) {
   debug_print("doDirectCommand(): key: "); debug_println(key);
-  int buttonAction = 0 ;
-  if (key<=57) {
-    buttonAction = buttonActions[(key - '0')];
+#if COLUMN_NUM == 4
+  int index = (key<=57) ? (key - '0') : (key - 55); // A, B, C, D
+#else
+  int index = key - '0';
+#endif
+  if ( (index<0) || (index>=keypadActionCount) ) return;
+
+  ActionHandler handler = keypadActionHandlers[index];
+  if (handler != nullptr) {
+    if (pressed) { // only process these on the key press, not the release
+      handler();
+    }
   } else {
-    buttonAction = buttonActions[(key - 55)]; // A, B, C, D
-  }
-  debug_print("doDirectCommand(): Action: "); debug_println(buttonAction);
-  if (buttonAction!=FUNCTION_NULL) {
+    int buttonAction = buttonActions[index];
+    debug_print("doDirectCommand(): Action: "); debug_println(buttonAction);
     if ( (buttonAction>=FUNCTION_0) && (buttonAction<=FUNCTION_31) ) {
       doDirectFunction(currentThrottleIndex, buttonAction, pressed);
-  } else {
-      if (pressed) { // only process these on the key press, not the release
-        doDirectAction(buttonAction);
-      }
     }
   }
   // debug_println("doDirectCommand(): end"); 
@@ -2110,7 +4685,7 @@ void doDirectAdditionalButtonCommand (int buttonIndex, bool pressed) {
 
       if (additionalButtonOverrideDefaultLatching) {
         bool latch = additionalButtonLatching[buttonIndex];
-        bool currentlyOn = functionStates[currentThrottleIndex][buttonAction];
+        bool currentlyOn = getFunctionState(currentThrottleIndex, buttonAction);
 
         if (!latch) {
           doDirectFunction(currentThrottleIndex, buttonAction, pressed, true);
@@ -2125,151 +4700,121 @@ void doDirectAdditionalButtonCommand (int buttonIndex, bool pressed) {
         doDirectFunction(currentThrottleIndex, buttonAction, pressed, false);
       }
     } else { // not a function
-      if (pressed) { // only process these on the key press, not the release
-        doDirectAction(buttonAction);
+      if ( (pressed) && (additionalButtonHandlers[buttonIndex] != nullptr) ) { // only process these on the key press, not the release
+        additionalButtonHandlers[buttonIndex]();
       }
     }
   }
   // debug_println("doDirectAdditionalButtonCommand(): end ");
 }
 
-void doDirectAction(int buttonAction) {
-  debug_println("doDirectAction(): ");
-  switch (buttonAction) {
-      case DIRECTION_FORWARD: {
-        changeDirection(currentThrottleIndex, Forward);
-        break; 
-      }
-      case DIRECTION_REVERSE: {
-        changeDirection(currentThrottleIndex, Reverse);
-        break; 
-      }
-      case DIRECTION_TOGGLE: {
-        toggleDirection(currentThrottleIndex);
-        break; 
-      }
-      case SPEED_STOP: {
-        speedSet(currentThrottleIndex, 0);
-        break; 
-      }
-      case SPEED_UP: {
-        speedUp(currentThrottleIndex, currentSpeedStep[currentThrottleIndex]);
-        break; 
-      }
-      case SPEED_DOWN: {
-        speedDown(currentThrottleIndex, currentSpeedStep[currentThrottleIndex]);
-        break; 
-      }
-      case SPEED_UP_FAST: {
-        speedUp(currentThrottleIndex, currentSpeedStep[currentThrottleIndex]*speedStepMultiplier);
-        break; 
-      }
-      case SPEED_DOWN_FAST: {
-        speedDown(currentThrottleIndex, currentSpeedStep[currentThrottleIndex]*speedStepMultiplier);
-        break; 
-      }
-      case SPEED_MULTIPLIER: {
-        toggleAdditionalMultiplier();
-        break; 
-      }
-      case E_STOP: {
-        speedEstop();
-        break; 
-      }
-      case E_STOP_CURRENT_LOCO: {
-        speedEstopCurrentLoco();
-        break; 
-      }
-      case POWER_ON: {
-        powerOnOff(PowerOn);
-        break; 
-      }
-      case POWER_OFF: {
-        powerOnOff(PowerOff);
-        break; 
-      }
-      case POWER_TOGGLE: {
-        powerToggle();
-        break; 
-      }
-      case SHOW_HIDE_BATTERY: {
-        batteryShowToggle();
-        break; 
-      }
-      case SLEEP: {
-        deepSleepStart();
-        break; 
-      }
-      case NEXT_THROTTLE: {
-        nextThrottle();
-        break; 
-      }
-      case THROTTLE_1: {
-        throttle(0);
-        break; 
-      }
-      case THROTTLE_2: {
-        throttle(1);
-        break; 
-      }
-      case THROTTLE_3: {
-        throttle(2);
-        break; 
-      }
-      case THROTTLE_4: {
-        throttle(3);
-        break; 
-      }
-      case THROTTLE_5: {
-        throttle(4);
-        break; 
-      }
-      case THROTTLE_6: {
-        throttle(5);
-        break; 
-      }
-      case SPEED_STOP_THEN_TOGGLE_DIRECTION: {
-        stopThenToggleDirection();
-        break; 
-      }
-      case MAX_THROTTLE_INCREASE: {
-        changeNumberOfThrottles(true);
-        break; 
-      }
-      case MAX_THROTTLE_DECREASE: {
-        changeNumberOfThrottles(false);
-        break; 
-      }
-      case CUSTOM_1: {
-        wiThrottleProtocol.sendCommand(CUSTOM_COMMAND_1);
-        break; 
-      }
-      case CUSTOM_2: {
-        wiThrottleProtocol.sendCommand(CUSTOM_COMMAND_2);
-        break; 
-      }
-      case CUSTOM_3: {
-        wiThrottleProtocol.sendCommand(CUSTOM_COMMAND_3);
-        break; 
-      }
-      case CUSTOM_4: {
-        wiThrottleProtocol.sendCommand(CUSTOM_COMMAND_4);
-        break; 
-      }
-      case CUSTOM_5: {
-        wiThrottleProtocol.sendCommand(CUSTOM_COMMAND_5);
-        break; 
-      }
-      case CUSTOM_6: {
-        wiThrottleProtocol.sendCommand(CUSTOM_COMMAND_6);
-        break; 
-      }
-      case CUSTOM_7: {
-        wiThrottleProtocol.sendCommand(CUSTOM_COMMAND_7);
-        break; 
-      }
+// *********************************************************************************
+//  Action handlers.  See getActionHandler() in WiTcontroller.h
+// *********************************************************************************
+
+void actionDirectionForward() { changeDirection(currentThrottleIndex, Forward); }
+void actionDirectionReverse() { changeDirection(currentThrottleIndex, Reverse); }
+void actionDirectionToggle() { toggleDirection(currentThrottleIndex); }
+void actionSpeedStop() { speedSet(currentThrottleIndex, 0); }
+void actionSpeedUp() { speedUp(currentThrottleIndex, throttleStates[currentThrottleIndex].speedStep); }
+void actionSpeedDown() { speedDown(currentThrottleIndex, throttleStates[currentThrottleIndex].speedStep); }
+void actionSpeedUpFast() { speedUp(currentThrottleIndex, throttleStates[currentThrottleIndex].speedStep*speedStepMultiplier); }
+void actionSpeedDownFast() { speedDown(currentThrottleIndex, throttleStates[currentThrottleIndex].speedStep*speedStepMultiplier); }
+void actionSleep() { deepSleepStart(); }
+void actionNone() { }
+void actionDiagnostics() { writeOledDiagnostics(); }
+void actionPowerOn() { powerOnOff(PowerOn); }
+void actionPowerOff() { powerOnOff(PowerOff); }
+void actionThrottle1() { throttle(0); }
+void actionThrottle2() { throttle(1); }
+void actionThrottle3() { throttle(2); }
+void actionThrottle4() { throttle(3); }
+void actionThrottle5() { throttle(4); }
+void actionThrottle6() { throttle(5); }
+void actionMaxThrottleIncrease() { changeNumberOfThrottles(true); }
+void actionMaxThrottleDecrease() { changeNumberOfThrottles(false); }
+void actionCustom1() { queueOutboundCommand(OUTBOUND_CMD_CUSTOM, '*', 0, CUSTOM_COMMAND_1); }
+void actionCustom2() { queueOutboundCommand(OUTBOUND_CMD_CUSTOM, '*', 0, CUSTOM_COMMAND_2); }
+void actionCustom3() { queueOutboundCommand(OUTBOUND_CMD_CUSTOM, '*', 0, CUSTOM_COMMAND_3); }
+void actionCustom4() { queueOutboundCommand(OUTBOUND_CMD_CUSTOM, '*', 0, CUSTOM_COMMAND_4); }
+void actionCustom5() { queueOutboundCommand(OUTBOUND_CMD_CUSTOM, '*', 0, CUSTOM_COMMAND_5); }
+void actionCustom6() { queueOutboundCommand(OUTBOUND_CMD_CUSTOM, '*', 0, CUSTOM_COMMAND_6); }
+void actionCustom7() { queueOutboundCommand(OUTBOUND_CMD_CUSTOM, '*', 0, CUSTOM_COMMAND_7); }
+
+#if LATENCY_BENCHMARK
+  volatile int benchmarkDispatchSink = 0;
+  void __attribute__((noinline)) benchmarkDispatchHit(int handler) { benchmarkDispatchSink += handler; }
+
+  // the decisions the old doDirectCommand() / doDirectAction() made for a key, with each action replaced by a call that does nothing
+  void __attribute__((noinline)) benchmarkSwitchDispatch(int index) {
+    int buttonAction = buttonActions[index];
+    if ( (buttonAction>=FUNCTION_0) && (buttonAction<=FUNCTION_31) ) {
+      benchmarkDispatchHit(-1);
+      return;
+    }
+    switch (buttonAction) {
+      case DIRECTION_FORWARD: benchmarkDispatchHit(1); break;
+      case DIRECTION_REVERSE: benchmarkDispatchHit(2); break;
+      case DIRECTION_TOGGLE: benchmarkDispatchHit(3); break;
+      case SPEED_STOP: benchmarkDispatchHit(4); break;
+      case SPEED_UP: benchmarkDispatchHit(5); break;
+      case SPEED_DOWN: benchmarkDispatchHit(6); break;
+      case SPEED_UP_FAST: benchmarkDispatchHit(7); break;
+      case SPEED_DOWN_FAST: benchmarkDispatchHit(8); break;
+      case SPEED_MULTIPLIER: benchmarkDispatchHit(9); break;
+      case E_STOP: benchmarkDispatchHit(10); break;
+      case E_STOP_CURRENT_LOCO: benchmarkDispatchHit(11); break;
+      case POWER_ON: benchmarkDispatchHit(12); break;
+      case POWER_OFF: benchmarkDispatchHit(13); break;
+      case POWER_TOGGLE: benchmarkDispatchHit(14); break;
+      case SHOW_HIDE_BATTERY: benchmarkDispatchHit(15); break;
+      case SLEEP: benchmarkDispatchHit(16); break;
+      case NEXT_THROTTLE: benchmarkDispatchHit(17); break;
+      case THROTTLE_1: benchmarkDispatchHit(18); break;
+      case THROTTLE_2: benchmarkDispatchHit(19); break;
+      case THROTTLE_3: benchmarkDispatchHit(20); break;
+      case THROTTLE_4: benchmarkDispatchHit(21); break;
+      case THROTTLE_5: benchmarkDispatchHit(22); break;
+      case THROTTLE_6: benchmarkDispatchHit(23); break;
+      case SPEED_STOP_THEN_TOGGLE_DIRECTION: benchmarkDispatchHit(24); break;
+      case MAX_THROTTLE_INCREASE: benchmarkDispatchHit(25); break;
+      case MAX_THROTTLE_DECREASE: benchmarkDispatchHit(26); break;
+      case CUSTOM_1: benchmarkDispatchHit(27); break;
+      case CUSTOM_2: benchmarkDispatchHit(28); break;
+      case CUSTOM_3: benchmarkDispatchHit(29); break;
+      case CUSTOM_4: benchmarkDispatchHit(30); break;
+      case CUSTOM_5: benchmarkDispatchHit(31); break;
+      case CUSTOM_6: benchmarkDispatchHit(32); break;
+      case CUSTOM_7: benchmarkDispatchHit(33); break;
+    }
+  }
+
+  // the same for the handler table, as doDirectCommand() does it now
+  void __attribute__((noinline)) benchmarkTableDispatch(int index) {
+    if (keypadActionHandlers[index] != nullptr) {
+      benchmarkDispatchHit(index);
+    } else if ( (buttonActions[index]>=FUNCTION_0) && (buttonActions[index]<=FUNCTION_31) ) {
+      benchmarkDispatchHit(-1);
+    }
   }
-  // debug_println("doDirectAction(): end");
+#endif
+
+// compare the handler table against the original switch, for every key in turn
+void benchmarkActionDispatch() {
+  #if LATENCY_BENCHMARK
+    const int iterations = 10000;
+
+    unsigned long start = micros();
+    for (int i=0; i<iterations; i++) benchmarkTableDispatch(i % keypadActionCount);
+    unsigned long tableTime = micros() - start;
+
+    start = micros();
+    for (int i=0; i<iterations; i++) benchmarkSwitchDispatch(i % keypadActionCount);
+    unsigned long switchTime = micros() - start;
+
+    Serial.print("Action dispatch ("); Serial.print(iterations); Serial.print(" keys): table: "); 
+    Serial.print(tableTime); Serial.print("us  original switch: "); Serial.print(switchTime); Serial.println("us");
+  #endif
 }
 
 void doMenu() {
@@ -2312,16 +4857,12 @@ void doMenuCommand(char menuItem) {
     case MENU_ITEM_ADD_LOCO: { // select loco
         if (menuCommand.length()>startAt) {
           if ( (dropBeforeAcquire) && (wiThrottleProtocol.getNumberOfLocomotives(currentThrottleIndexChar)>0) ) {
-            wiThrottleProtocol.releaseLocomotive(currentThrottleIndexChar, "*");
+            queueReleaseLoco(currentThrottleIndexChar, "*");
+            invalidateDerivedState(currentThrottleIndex);
+            throttleReleased(currentThrottleIndex);
           }
           loco = menuCommand.substring(startAt, menuCommand.length());
-          loco = getLocoWithLength(loco);
-          debug_print("add Loco: "); debug_println(loco);
-          wiThrottleProtocol.addLocomotive(currentThrottleIndexChar, loco);
-          wiThrottleProtocol.getDirection(currentThrottleIndexChar, loco);
-          wiThrottleProtocol.getSpeed(currentThrottleIndexChar);
-          resetFunctionStates(currentThrottleIndex);
-          writeOledSpeed();
+          queueAcquireLoco(currentThrottleIndexChar, getLocoWithLength(loco));
         } else {
           page = 0;
           writeOledRoster("");
@@ -2356,7 +4897,7 @@ void doMenuCommand(char menuItem) {
           String turnout = turnoutPrefix + menuCommand.substring(startAt, menuCommand.length());
           // if (!turnout.equals("")) { // a turnout is specified
             debug_print("throw point: "); debug_println(turnout);
-            wiThrottleProtocol.setTurnout(turnout, TurnoutThrow);
+            queueOutboundCommand(OUTBOUND_CMD_TURNOUT, '*', TurnoutThrow, turnout);
           // }
           writeOledSpeed();
         } else {
@@ -2370,7 +4911,7 @@ void doMenuCommand(char menuItem) {
           String turnout = turnoutPrefix + menuCommand.substring(startAt, menuCommand.length());
           // if (!turnout.equals("")) { // a turnout is specified
             debug_print("close point: "); debug_println(turnout);
-            wiThrottleProtocol.setTurnout(turnout, TurnoutClose);
+            queueOutboundCommand(OUTBOUND_CMD_TURNOUT, '*', TurnoutClose, turnout);
           // }
           writeOledSpeed();
         } else {
@@ -2384,7 +4925,7 @@ void doMenuCommand(char menuItem) {
           String route = routePrefix + menuCommand.substring(startAt, menuCommand.length());
           // if (!route.equals("")) { // a loco is specified
             debug_print("route: "); debug_println(route);
-            wiThrottleProtocol.setRoute(route);
+            queueOutboundCommand(OUTBOUND_CMD_ROUTE, '*', 0, route);
           // }
           writeOledSpeed();
         } else {
@@ -2417,6 +4958,13 @@ void doMenuCommand(char menuItem) {
         }
         break;
       } 
+#ifdef MENU_ITEM_LANGUAGE
+    case MENU_ITEM_LANGUAGE: { // change to the next language
+        nextLanguage();
+        writeOledSpeed();
+        break;
+      }
+#endif
     case MENU_ITEM_HEARTBEAT_TOGGLE: { // disable/enable the heartbeat Check
         toggleHeartbeatCheck();
         writeOledSpeed();
@@ -2493,15 +5041,28 @@ void resetMenu() {
 void resetFunctionStates(int multiThrottleIndex) {
   debug_println("resetFunctionStates()");
   for (int i=0; i<MAX_FUNCTIONS; i++) {
-    functionStates[multiThrottleIndex][i] = false;
+    setFunctionState(multiThrottleIndex, i, false);
+  }
+}
+
+bool getFunctionState(int multiThrottleIndex, int functionNumber) {
+  return (throttleStates[multiThrottleIndex].functionStates >> functionNumber) & 1;
+}
+
+void setFunctionState(int multiThrottleIndex, int functionNumber, bool state) {
+  if (state) {
+    throttleStates[multiThrottleIndex].functionStates |= (1UL << functionNumber);
+  } else {
+    throttleStates[multiThrottleIndex].functionStates &= ~(1UL << functionNumber);
   }
 }
 
 void resetFunctionLabels(int multiThrottleIndex) {
   debug_print("resetFunctionLabels(): "); debug_println(multiThrottleIndex);
   for (int i=0; i<MAX_FUNCTIONS; i++) {
-    functionLabels[multiThrottleIndex][i] = "";
+    throttleStates[multiThrottleIndex].functionLabels[i] = "";
   }
+  buildFunctionListLabels(multiThrottleIndex);
   functionPage = 0;
 }
 
@@ -2511,40 +5072,76 @@ void resetAllFunctionLabels() {
   }
 }
 
+// *********************************************************************************
+//   List labels
+// *********************************************************************************
+// The roster, turnout, route and function list entries are formatted for the screen when they
+// are received, so showing a page of a list only copies them.
+// The number at the start is the key that selects the entry on its page.
+
+// position in the (sorted) roster
+void buildRosterLabel(int position) {
+  int index = rosterSortedIndex[position];
+  if (rosterAddress[index] == 0) {
+    rosterLabels[position][0] = 0;  // not shown
+  } else {
+    snprintf(rosterLabels[position], ROSTER_LABEL_SIZE, "%d: %s (%d)", position % 5, rosterName[index].c_str(), rosterAddress[index]);
+  }
+}
+
+void buildTurnoutOrRouteLabel(char* label, int index, String userName) {
+  if (userName.length() == 0) {
+    label[0] = 0;  // not shown
+  } else {
+    snprintf(label, LIST_LABEL_SIZE, "%d: %.10s", index % 10, userName.c_str());
+  }
+}
+
+void buildFunctionListLabels(int multiThrottleIndex) {
+  for (int k=0; k<MAX_FUNCTIONS; k++) {
+    const char* functionLabel = throttleStates[multiThrottleIndex].functionLabels[k].c_str();
+    if (k<10) {
+      snprintf(throttleStates[multiThrottleIndex].functionListLabels[k], LIST_LABEL_SIZE, "%d: %.10s", k % 10, functionLabel);
+    } else {
+      snprintf(throttleStates[multiThrottleIndex].functionListLabels[k], LIST_LABEL_SIZE, "%d: %d-%.7s", k % 10, k, functionLabel);
+    }
+  }
+}
+
 void resetAllFunctionFollow() {
-  for (int i=0; i<6; i++) {
-    functionFollow[i][0] = CONSIST_FUNCTION_FOLLOW_F0;
-    functionFollow[i][1] = CONSIST_FUNCTION_FOLLOW_F1;
-    functionFollow[i][2] = CONSIST_FUNCTION_FOLLOW_F2;
-    functionFollow[i][3] = CONSIST_FUNCTION_FOLLOW_F3;
-    functionFollow[i][4] = CONSIST_FUNCTION_FOLLOW_F4;
-    functionFollow[i][5] = CONSIST_FUNCTION_FOLLOW_F5;
-    functionFollow[i][6] = CONSIST_FUNCTION_FOLLOW_F6;
-    functionFollow[i][7] = CONSIST_FUNCTION_FOLLOW_F7;
-    functionFollow[i][8] = CONSIST_FUNCTION_FOLLOW_F8;
-    functionFollow[i][9] = CONSIST_FUNCTION_FOLLOW_F9;
-    functionFollow[i][10] = CONSIST_FUNCTION_FOLLOW_F10;
-    functionFollow[i][11] = CONSIST_FUNCTION_FOLLOW_F11;
-    functionFollow[i][12] = CONSIST_FUNCTION_FOLLOW_F12;
-    functionFollow[i][13] = CONSIST_FUNCTION_FOLLOW_F13;
-    functionFollow[i][14] = CONSIST_FUNCTION_FOLLOW_F14;
-    functionFollow[i][15] = CONSIST_FUNCTION_FOLLOW_F15;
-    functionFollow[i][16] = CONSIST_FUNCTION_FOLLOW_F16;
-    functionFollow[i][17] = CONSIST_FUNCTION_FOLLOW_F17;
-    functionFollow[i][18] = CONSIST_FUNCTION_FOLLOW_F18;
-    functionFollow[i][19] = CONSIST_FUNCTION_FOLLOW_F19;
-    functionFollow[i][20] = CONSIST_FUNCTION_FOLLOW_F20;
-    functionFollow[i][21] = CONSIST_FUNCTION_FOLLOW_F21;
-    functionFollow[i][22] = CONSIST_FUNCTION_FOLLOW_F22;
-    functionFollow[i][23] = CONSIST_FUNCTION_FOLLOW_F23;
-    functionFollow[i][24] = CONSIST_FUNCTION_FOLLOW_F24;
-    functionFollow[i][25] = CONSIST_FUNCTION_FOLLOW_F25;
-    functionFollow[i][26] = CONSIST_FUNCTION_FOLLOW_F26;
-    functionFollow[i][27] = CONSIST_FUNCTION_FOLLOW_F27;
-    functionFollow[i][28] = CONSIST_FUNCTION_FOLLOW_F28;
-    functionFollow[i][29] = CONSIST_FUNCTION_FOLLOW_F29;
-    functionFollow[i][30] = CONSIST_FUNCTION_FOLLOW_F30;
-    functionFollow[i][31] = CONSIST_FUNCTION_FOLLOW_F31;
+  for (int i=0; i<THROTTLE_POOL_SIZE; i++) {
+    throttleStates[i].functionFollow[0] = CONSIST_FUNCTION_FOLLOW_F0;
+    throttleStates[i].functionFollow[1] = CONSIST_FUNCTION_FOLLOW_F1;
+    throttleStates[i].functionFollow[2] = CONSIST_FUNCTION_FOLLOW_F2;
+    throttleStates[i].functionFollow[3] = CONSIST_FUNCTION_FOLLOW_F3;
+    throttleStates[i].functionFollow[4] = CONSIST_FUNCTION_FOLLOW_F4;
+    throttleStates[i].functionFollow[5] = CONSIST_FUNCTION_FOLLOW_F5;
+    throttleStates[i].functionFollow[6] = CONSIST_FUNCTION_FOLLOW_F6;
+    throttleStates[i].functionFollow[7] = CONSIST_FUNCTION_FOLLOW_F7;
+    throttleStates[i].functionFollow[8] = CONSIST_FUNCTION_FOLLOW_F8;
+    throttleStates[i].functionFollow[9] = CONSIST_FUNCTION_FOLLOW_F9;
+    throttleStates[i].functionFollow[10] = CONSIST_FUNCTION_FOLLOW_F10;
+    throttleStates[i].functionFollow[11] = CONSIST_FUNCTION_FOLLOW_F11;
+    throttleStates[i].functionFollow[12] = CONSIST_FUNCTION_FOLLOW_F12;
+    throttleStates[i].functionFollow[13] = CONSIST_FUNCTION_FOLLOW_F13;
+    throttleStates[i].functionFollow[14] = CONSIST_FUNCTION_FOLLOW_F14;
+    throttleStates[i].functionFollow[15] = CONSIST_FUNCTION_FOLLOW_F15;
+    throttleStates[i].functionFollow[16] = CONSIST_FUNCTION_FOLLOW_F16;
+    throttleStates[i].functionFollow[17] = CONSIST_FUNCTION_FOLLOW_F17;
+    throttleStates[i].functionFollow[18] = CONSIST_FUNCTION_FOLLOW_F18;
+    throttleStates[i].functionFollow[19] = CONSIST_FUNCTION_FOLLOW_F19;
+    throttleStates[i].functionFollow[20] = CONSIST_FUNCTION_FOLLOW_F20;
+    throttleStates[i].functionFollow[21] = CONSIST_FUNCTION_FOLLOW_F21;
+    throttleStates[i].functionFollow[22] = CONSIST_FUNCTION_FOLLOW_F22;
+    throttleStates[i].functionFollow[23] = CONSIST_FUNCTION_FOLLOW_F23;
+    throttleStates[i].functionFollow[24] = CONSIST_FUNCTION_FOLLOW_F24;
+    throttleStates[i].functionFollow[25] = CONSIST_FUNCTION_FOLLOW_F25;
+    throttleStates[i].functionFollow[26] = CONSIST_FUNCTION_FOLLOW_F26;
+    throttleStates[i].functionFollow[27] = CONSIST_FUNCTION_FOLLOW_F27;
+    throttleStates[i].functionFollow[28] = CONSIST_FUNCTION_FOLLOW_F28;
+    throttleStates[i].functionFollow[29] = CONSIST_FUNCTION_FOLLOW_F29;
+    throttleStates[i].functionFollow[30] = CONSIST_FUNCTION_FOLLOW_F30;
+    throttleStates[i].functionFollow[31] = CONSIST_FUNCTION_FOLLOW_F31;
   }
 }
 
@@ -2563,47 +5160,60 @@ String getLocoWithLength(String loco) {
 
 void speedEstop() {
   debug_println("Speed EStop"); 
-  wiThrottleProtocol.emergencyStop();
+  latencyStartScenario(LATENCY_SCENARIO_ESTOP);
+  sendOutboundEstop('*');
   for (int i=0; i<maxThrottles; i++) {
-    speedSet(getMultiThrottleChar(i),0);
-    currentSpeed[i] = 0;
+    momentumCancel(i);
+    speedSetNow(i,0);
+    throttleStates[i].speed = 0;
   }
   writeOledSpeed();
 }
 
 void speedEstopCurrentLoco() {
   debug_println("Speed EStop Curent Loco"); 
-  wiThrottleProtocol.emergencyStop(currentThrottleIndexChar);
-  speedSet(currentThrottleIndexChar,0);
+  latencyStartScenario(LATENCY_SCENARIO_ESTOP);
+  sendOutboundEstop(currentThrottleIndexChar);
+  momentumCancel(currentThrottleIndex);
+  speedSetNow(currentThrottleIndex,0);
   writeOledSpeed();
 }
 
 void speedDown(int multiThrottleIndex, int amt) {
   if (wiThrottleProtocol.getNumberOfLocomotives(getMultiThrottleChar(multiThrottleIndex)) > 0) {
-    int newSpeed = currentSpeed[multiThrottleIndex] - amt;
-    debug_print("Speed Down: "); debug_println(amt);
+    int newSpeed = ((useMomentum) ? throttleStates[multiThrottleIndex].momentumTargetSpeed : throttleStates[multiThrottleIndex].speed) - amt;
+    debug_log(LOG_LEVEL_THROTTLE, DEBUG_LEVEL_VERBOSE, "Speed Down: ", amt);
     speedSet(multiThrottleIndex, newSpeed);
   }
 }
 
 void speedUp(int multiThrottleIndex, int amt) {
   if (wiThrottleProtocol.getNumberOfLocomotives(getMultiThrottleChar(multiThrottleIndex)) > 0) {
-    int newSpeed = currentSpeed[multiThrottleIndex] + amt;
-    debug_print("Speed Up: "); debug_println(amt);
+    latencyStartScenario(LATENCY_SCENARIO_SPEED_UP);
+    int newSpeed = ((useMomentum) ? throttleStates[multiThrottleIndex].momentumTargetSpeed : throttleStates[multiThrottleIndex].speed) + amt;
+    debug_log(LOG_LEVEL_THROTTLE, DEBUG_LEVEL_VERBOSE, "Speed Up: ", amt);
     speedSet(multiThrottleIndex, newSpeed);
   }
 }
 
 void speedSet(int multiThrottleIndex, int amt) {
-  debug_println("setSpeed()");
+  if (useMomentum) {
+    momentumSetTarget(multiThrottleIndex, amt);
+  } else {
+    speedSetNow(multiThrottleIndex, amt);
+  }
+}
+
+// send the speed straight away, ignoring any momentum
+void speedSetNow(int multiThrottleIndex, int amt) {
   char multiThrottleIndexChar = getMultiThrottleChar(multiThrottleIndex);
   if (wiThrottleProtocol.getNumberOfLocomotives(multiThrottleIndexChar) > 0) {
     int newSpeed = amt;
     if (newSpeed >126) { newSpeed = 126; }
     if (newSpeed <0) { newSpeed = 0; }
-    wiThrottleProtocol.setSpeed(multiThrottleIndexChar, newSpeed);
-    currentSpeed[multiThrottleIndex] = newSpeed;
-    debug_print("Speed Set: "); debug_println(newSpeed);
+    queueOutboundCommand(OUTBOUND_CMD_SPEED, multiThrottleIndexChar, newSpeed);
+    throttleStates[multiThrottleIndex].speed = newSpeed;
+    debug_log(LOG_LEVEL_THROTTLE, DEBUG_LEVEL_VERBOSE, "Speed Set: ", newSpeed);
 
     // used to avoid bounce
     lastSpeedSentTime = millis();
@@ -2618,9 +5228,79 @@ void speedSet(int multiThrottleIndex, int amt) {
   }
 }
 
+// *********************************************************************************
+//  Momentum
+// *********************************************************************************
+
+void momentumSetTarget(int multiThrottleIndex, int speed) {
+  if (wiThrottleProtocol.getNumberOfLocomotives(getMultiThrottleChar(multiThrottleIndex)) > 0) {
+    if (speed >126) { speed = 126; }
+    if (speed <0) { speed = 0; }
+    if (!momentumIsRamping(multiThrottleIndex)) { // start from wherever the speed is now (it may have been changed elsewhere)
+      throttleStates[multiThrottleIndex].momentumSpeedFixed = ((long) throttleStates[multiThrottleIndex].speed) << 8;
+    }
+    throttleStates[multiThrottleIndex].momentumTargetSpeed = speed;
+    debug_log(LOG_LEVEL_THROTTLE, DEBUG_LEVEL_VERBOSE, "Momentum target: ", speed);
+  }
+}
+
+bool momentumIsRamping(int multiThrottleIndex) {
+  if (!useMomentum) return false;
+  return throttleStates[multiThrottleIndex].momentumSpeedFixed != (((long) throttleStates[multiThrottleIndex].momentumTargetSpeed) << 8);
+}
+
+// stop any change in progress, without sending anything
+void momentumCancel(int multiThrottleIndex) {
+  throttleStates[multiThrottleIndex].momentumTargetSpeed = 0;
+  throttleStates[multiThrottleIndex].momentumSpeedFixed = 0;
+}
+
+// the throttle has no locos now.  Forget its speed, any ramp and any queued speed, 
+// so none of them carry over to the next loco acquired on it
+void throttleReleased(int multiThrottleIndex) {
+  momentumCancel(multiThrottleIndex);
+  throttleStates[multiThrottleIndex].speed = 0;
+  dropOutboundSpeedCommands(getMultiThrottleChar(multiThrottleIndex));
+}
+
+void momentumLoop() {
+  if (!useMomentum) return;
+
+  unsigned long now = millis();
+  unsigned long elapsed = now - momentumLastUpdateTime;
+  if (elapsed < 10) return;
+  if (elapsed > 1000) elapsed = 1000;  // e.g. first time through
+  momentumLastUpdateTime = now;
+
+  for (int i=0; i<maxThrottles; i++) {
+    if (!momentumIsRamping(i)) continue;
+
+    long target = ((long) throttleStates[i].momentumTargetSpeed) << 8;
+    long rate = (target > throttleStates[i].momentumSpeedFixed) ? MOMENTUM_ACCELERATION : MOMENTUM_BRAKING;
+    long change = (rate * 256 * (long) elapsed) / 1000;
+    if (change < 1) change = 1;
+
+    if (target > throttleStates[i].momentumSpeedFixed) {
+      throttleStates[i].momentumSpeedFixed += change;
+      if (throttleStates[i].momentumSpeedFixed > target) throttleStates[i].momentumSpeedFixed = target;
+    } else {
+      throttleStates[i].momentumSpeedFixed -= change;
+      if (throttleStates[i].momentumSpeedFixed < target) throttleStates[i].momentumSpeedFixed = target;
+    }
+
+    int speed = throttleStates[i].momentumSpeedFixed >> 8;
+    bool reached = (throttleStates[i].momentumSpeedFixed == target);
+    if ( (speed != throttleStates[i].speed)
+         && ( (reached) || ((now - throttleStates[i].momentumLastSentTime) >= MOMENTUM_COMMAND_INTERVAL) ) ) {
+      throttleStates[i].momentumLastSentTime = now;
+      speedSetNow(i, speed);
+    }
+  }
+}
+
 int getDisplaySpeed(int multiThrottleIndex) {
   if (speedDisplayAsPercent) {
-    float speed = currentSpeed[multiThrottleIndex];
+    float speed = throttleStates[multiThrottleIndex].speed;
     speed = speed / 126 *100;
     int iSpeed = speed;
     if (iSpeed-speed >= 0.5) {
@@ -2629,7 +5309,7 @@ int getDisplaySpeed(int multiThrottleIndex) {
     return iSpeed;
   } else {
     if (speedDisplayAs0to28) {
-      float speed = currentSpeed[multiThrottleIndex];
+      float speed = throttleStates[multiThrottleIndex].speed;
       speed = speed / 126 *28;
       int iSpeed = speed;
       if (iSpeed-speed >= 0.5) {
@@ -2637,13 +5317,15 @@ int getDisplaySpeed(int multiThrottleIndex) {
       }
       return iSpeed;
     } else {
-      return currentSpeed[multiThrottleIndex];
+      return throttleStates[multiThrottleIndex].speed;
     }
   }
 }
 
 void stealLoco(int multiThrottleIndex, String loco) {
+  outboundCaptureStart();
   wiThrottleProtocol.stealLocomotive(multiThrottleIndex, loco);  
+  outboundCaptureQueue(getMultiThrottleChar(multiThrottleIndex));
 }
 
 void toggleLocoFacing(int multiThrottleIndex, String loco) {
@@ -2654,11 +5336,7 @@ void toggleLocoFacing(int multiThrottleIndex, String loco) {
     if (wiThrottleProtocol.getLocomotiveAtPosition(multiThrottleIndexChar, i).equals(loco)) {
       Direction currentDirection = wiThrottleProtocol.getDirection(multiThrottleIndexChar, loco);
       debug_print("toggleLocoFacing(): loco: ");  debug_print(loco);  debug_print(" current direction: "); debug_println(currentDirection);
-      if (wiThrottleProtocol.getDirection(multiThrottleIndexChar, loco) == Forward) {
-        wiThrottleProtocol.setDirection(multiThrottleIndexChar, loco, Reverse, true);
-      } else {
-        wiThrottleProtocol.setDirection(multiThrottleIndexChar, loco, Forward, true);
-      }
+      queueOutboundCommand(OUTBOUND_CMD_DIRECTION, multiThrottleIndexChar, (currentDirection == Forward) ? Reverse : Forward, loco, false, true);
       break;
     }
   } 
@@ -2676,9 +5354,7 @@ int getLocoFacing(int multiThrottleIndex, String loco) {
   return result;
 }
 
-String getDisplayLocoString(int multiThrottleIndex, int index) {
-  char multiThrottleIndexChar = getMultiThrottleChar(multiThrottleIndex);
-  String loco = wiThrottleProtocol.getLocomotiveAtPosition(multiThrottleIndexChar, index);
+String getDisplayLocoName(String loco) {
   String locoNumber = loco.substring(1);
   
   #ifdef DISPLAY_LOCO_NAME
@@ -2691,43 +5367,106 @@ String getDisplayLocoString(int multiThrottleIndex, int index) {
       }
     }
   #endif
-  
-  if (!wiThrottleProtocol.getLocomotiveAtPosition(multiThrottleIndexChar, 0).equals(loco)) { // not the lead loco
-    Direction leadLocoDirection 
-        = wiThrottleProtocol.getDirection(multiThrottleIndexChar, 
-                                          wiThrottleProtocol.getLocomotiveAtPosition(multiThrottleIndexChar, 0));
-    // Direction locoDirection = leadLocoDirection;
-
-    for(int i=0;i<wiThrottleProtocol.getNumberOfLocomotives(multiThrottleIndexChar);i++) {
-      if (wiThrottleProtocol.getLocomotiveAtPosition(multiThrottleIndexChar, i).equals(loco)) {
-        if (wiThrottleProtocol.getDirection(multiThrottleIndexChar, loco) != leadLocoDirection) {
-          locoNumber = locoNumber + DIRECTION_REVERSE_INDICATOR;
-        }
-        break;
-      }
+  return locoNumber;
+}
+
+// *********************************************************************************
+//  Derived throttle state
+// *********************************************************************************
+// The loco count, lead loco, which locos face the other way and the consist as shown on the screen
+// are rebuilt from the library only after an acquire, release or direction change for that throttle,
+// so drawing the throttle screen does not walk the consists each time.
+
+void invalidateDerivedState(int multiThrottleIndex) {  // -1 = all
+  if (multiThrottleIndex < 0) {
+    derivedStateDirty = 0xFFFF;
+  } else {
+    derivedStateDirty |= (1 << multiThrottleIndex);
+  }
+}
+
+// called with every line received, before the library sees it
+void derivedStateInboundLine(const char* line, int length) {
+  if ( (length < 3) || (line[0] != 'M') ) return;
+  bool changesConsist = (line[2] == '+') || (line[2] == '-') || (line[2] == 'S');
+  if ( (!changesConsist) && (line[2] == 'A') ) {
+    int separator = sliceIndexOf(line, length, WIT_PROPERTY_SEPARATOR, 3);
+    changesConsist = (separator > 0) && (separator+3 < length) && (line[separator+3] == 'R');
+  }
+  if (changesConsist) {
+    derivedStatePendingLibrary |= (1 << getMultiThrottleIndex(line[1]));
+  }
+}
+
+// the library has now processed what was received
+void derivedStateLibraryChecked() {
+  derivedStateDirty |= derivedStatePendingLibrary;
+  derivedStatePendingLibrary = 0;
+}
+
+void rebuildDerivedState(int multiThrottleIndex) {
+  char multiThrottleIndexChar = getMultiThrottleChar(multiThrottleIndex);
+  ThrottleState *throttle = &throttleStates[multiThrottleIndex];
+
+  throttle->locoCount = wiThrottleProtocol.getNumberOfLocomotives(multiThrottleIndexChar);
+  throttle->reverseFacing = 0;
+  throttle->displayLocos = "";
+  if (throttle->locoCount > 0) {
+    activeThrottles |= (1 << multiThrottleIndex);
+    throttle->leadLoco = wiThrottleProtocol.getLocomotiveAtPosition(multiThrottleIndexChar, 0);
+  } else {
+    activeThrottles &= ~(1 << multiThrottleIndex);
+    throttle->leadLoco = "";
+    return;
+  }
+
+  Direction leadLocoDirection = wiThrottleProtocol.getDirection(multiThrottleIndexChar, throttle->leadLoco);
+  String sSpaceBetweenLocos = " ";
+  for (int i=0; i<throttle->locoCount; i++) {
+    String loco = (i == 0) ? throttle->leadLoco : wiThrottleProtocol.getLocomotiveAtPosition(multiThrottleIndexChar, i);
+    String locoNumber = getDisplayLocoName(loco);
+    if ( (i > 0) && (wiThrottleProtocol.getDirection(multiThrottleIndexChar, loco) != leadLocoDirection) ) {
+      if (i < 32) throttle->reverseFacing |= (1UL << i);
+      locoNumber = locoNumber + DIRECTION_REVERSE_INDICATOR;
     }
+    throttle->displayLocos = throttle->displayLocos + sSpaceBetweenLocos + locoNumber;
+    sSpaceBetweenLocos = CONSIST_SPACE_BETWEEN_LOCOS;
   }
-  return locoNumber;
+  derivedStateRebuildCount++;
+}
+
+// rebuild anything that has changed.  Call before reading the derived state
+void updateDerivedState() {
+  if (derivedStateDirty == 0) return;
+  for (int i=0; i<THROTTLE_POOL_SIZE; i++) {
+    if (derivedStateDirty & (1 << i)) rebuildDerivedState(i);
+  }
+  derivedStateDirty = 0;
 }
 
 void releaseAllLocos(int multiThrottleIndex) {
   char multiThrottleIndexChar = getMultiThrottleChar(multiThrottleIndex);
   String loco;
+  dropAcquireLocos(multiThrottleIndexChar);
   if (wiThrottleProtocol.getNumberOfLocomotives(multiThrottleIndexChar)>0) {
     for(int index=wiThrottleProtocol.getNumberOfLocomotives(multiThrottleIndexChar)-1;index>=0;index--) {
       loco = wiThrottleProtocol.getLocomotiveAtPosition(multiThrottleIndexChar, index);
-      wiThrottleProtocol.releaseLocomotive(multiThrottleIndexChar, loco);
+      queueReleaseLoco(multiThrottleIndexChar, loco);
+      invalidateDerivedState(multiThrottleIndex);
       writeOledSpeed();  // note the released locos may not be visible
     } 
     resetFunctionLabels(multiThrottleIndex);
   }
+  throttleReleased(multiThrottleIndex);
 }
 
 void releaseOneLoco(int multiThrottleIndex, String loco) {
   debug_print("releaseOneLoco(): "); debug_print(multiThrottleIndex); debug_print(": "); debug_println(loco);
   char multiThrottleIndexChar = getMultiThrottleChar(multiThrottleIndex);
-  wiThrottleProtocol.releaseLocomotive(multiThrottleIndexChar, loco);
+  queueReleaseLoco(multiThrottleIndexChar, loco);
+  invalidateDerivedState(multiThrottleIndex);
   resetFunctionLabels(multiThrottleIndex);
+  if (wiThrottleProtocol.getNumberOfLocomotives(multiThrottleIndexChar) == 0) throttleReleased(multiThrottleIndex);  // the rest of a consist keeps going
   debug_println("releaseOneLoco(): end"); 
 }
 
@@ -2736,8 +5475,10 @@ void releaseOneLocoByIndex(int multiThrottleIndex, int index) {
   char multiThrottleIndexChar = getMultiThrottleChar(multiThrottleIndex);
   if (index <= wiThrottleProtocol.getNumberOfLocomotives(multiThrottleIndexChar)) {
     String loco = wiThrottleProtocol.getLocomotiveAtPosition(multiThrottleIndexChar, index);
-    wiThrottleProtocol.releaseLocomotive(multiThrottleIndexChar, loco);
+    queueReleaseLoco(multiThrottleIndexChar, loco);
+    invalidateDerivedState(multiThrottleIndex);
     resetFunctionLabels(multiThrottleIndex);
+    if (wiThrottleProtocol.getNumberOfLocomotives(multiThrottleIndexChar) == 0) throttleReleased(multiThrottleIndex);  // the rest of a consist keeps going
   }
   debug_println("releaseOneLocoByIndex(): end");
 }
@@ -2761,7 +5502,7 @@ void toggleAdditionalMultiplier() {
   }
 
   for (int i=0; i<maxThrottles; i++) {
-    currentSpeedStep[i] = speedStep * speedStepCurrentMultiplier;
+    throttleStates[i].speedStep = speedStep * speedStepCurrentMultiplier;
   }
   writeOledSpeed();
 }
@@ -2779,6 +5520,15 @@ void toggleHeartbeatCheck() {
   writeHeartbeatCheck();
 }
 
+void nextLanguage() {
+  currentLanguage++;
+  if (currentLanguage >= LANGUAGE_COUNT) currentLanguage = 0;
+  debug_print("Language: "); debug_println(getText(TEXT_LANGUAGE_NAME));
+  writeLanguagePreference();
+  broadcastMessageText = getText(TEXT_LANGUAGE_NAME);
+  broadcastMessageTime = millis();
+}
+
 void toggleDropBeforeAquire() {
   dropBeforeAcquire = !dropBeforeAcquire;
   debug_print("Drop Before Acquire: "); 
@@ -2787,50 +5537,56 @@ void toggleDropBeforeAquire() {
 
 void toggleDirection(int multiThrottleIndex) {
   if (wiThrottleProtocol.getNumberOfLocomotives(getMultiThrottleChar(multiThrottleIndex)) > 0) {
-    changeDirection(multiThrottleIndex, (currentDirection[multiThrottleIndex] == Forward) ? Reverse : Forward );
+    changeDirection(multiThrottleIndex, (throttleStates[multiThrottleIndex].direction == Forward) ? Reverse : Forward );
     writeOledSpeed();
   }
 }
 
+// Change the direction of all the locos on a throttle.
+// If all the locos face the same way as the lead they are all set with a single multi-throttle '*' command.
+// Otherwise each loco gets its own command, all of them in one paced slot (and one write), 
+// so no loco is ever told to drive against the others and the reversal takes no longer than the '*' one.
+// Which locos face the other way comes from the derived state, so the consist is not walked here.
+//
 void changeDirection(int multiThrottleIndex, Direction direction) {
-  String loco; String leadLoco; 
-  Direction leadLocoCurrentDirection;
   char multiThrottleChar = getMultiThrottleChar(multiThrottleIndex);
-  int locoCount = wiThrottleProtocol.getNumberOfLocomotives(multiThrottleChar);
+  updateDerivedState();
+  ThrottleState *throttle = &throttleStates[multiThrottleIndex];
+  unsigned long startTime = micros();
 
-  if (locoCount > 0) {
-    currentDirection[multiThrottleIndex] = direction;
+  if (throttle->locoCount > 0) {
+    latencyStartScenario(LATENCY_SCENARIO_CONSIST_REVERSE);
+    throttle->direction = direction;
     debug_print("changeDirection(): "); debug_println( (direction==Forward) ? "Forward" : "Reverse");
 
-    if (locoCount == 1) {
-      debug_println("changeDirection(): one loco");
-      wiThrottleProtocol.setDirection(multiThrottleChar, direction);  // change all
-
+    if (throttle->reverseFacing == 0) {  // one loco, or all facing the same way as the lead
+      queueOutboundCommand(OUTBOUND_CMD_DIRECTION, multiThrottleChar, direction);  // change all, including the lead
     } else {
-      debug_println("changeDirection(): multiple locos");
-      leadLoco = wiThrottleProtocol.getLeadLocomotive(multiThrottleChar);
-      leadLocoCurrentDirection = wiThrottleProtocol.getDirection(multiThrottleChar, leadLoco);
-
-      for (int i=1; i<locoCount; i++) {
-        loco = wiThrottleProtocol.getLocomotiveAtPosition(multiThrottleChar, i);
-        Direction currentDirection = wiThrottleProtocol.getDirection(multiThrottleChar, loco);
-        if (currentDirection == leadLocoCurrentDirection) {
-          wiThrottleProtocol.setDirection(multiThrottleChar, loco, direction);
-        } else {
-          if (direction == Reverse) {
-            wiThrottleProtocol.setDirection(multiThrottleChar, loco, Forward);
-          } else {
-            wiThrottleProtocol.setDirection(multiThrottleChar, loco, Reverse);
-          }
-        }
-      }
-      wiThrottleProtocol.setDirection(multiThrottleChar, leadLoco, direction);
-    } 
+      debug_println("changeDirection(): locos facing both ways");
+      queueOutboundCommand(OUTBOUND_CMD_DIRECTION_CONSIST, multiThrottleChar, direction);
+    }
   }
+  debug_print("changeDirection(): locos: "); debug_print(throttle->locoCount); 
+  debug_print(" took (us): "); debug_println(micros() - startTime);
   writeOledSpeed();
   // debug_println("changeDirection(): end "); 
 }
 
+// called by the scheduler.  Every loco's direction, lead first, in the same write.
+// The facing is read when sent, so it is right even if the consist changed while this was queued
+void sendConsistDirection(int multiThrottleIndex, Direction direction) {
+  char multiThrottleChar = getMultiThrottleChar(multiThrottleIndex);
+  updateDerivedState();
+  ThrottleState *throttle = &throttleStates[multiThrottleIndex];
+  Direction reverseFacingDirection = (direction == Forward) ? Reverse : Forward;
+  uint32_t reverseFacing = throttle->reverseFacing;
+  for (int i=0; i<throttle->locoCount; i++) {
+    String loco = (i == 0) ? throttle->leadLoco : wiThrottleProtocol.getLocomotiveAtPosition(multiThrottleChar, i);
+    throttleBackend->setDirection(multiThrottleChar, loco, 
+                                  (reverseFacing & (1UL << i)) ? reverseFacingDirection : direction, true);
+  }
+}
+
 void doDirectFunction(int multiThrottleIndex, int functionNumber, bool pressed) {
   doDirectFunction(multiThrottleIndex, functionNumber, pressed, false);
 }
@@ -2838,6 +5594,7 @@ void doDirectFunction(int multiThrottleIndex, int functionNumber, bool pressed,
   char multiThrottleIndexChar = getMultiThrottleChar(multiThrottleIndex);
   debug_println("doDirectFunction(): "); 
   if (wiThrottleProtocol.getNumberOfLocomotives(multiThrottleIndexChar) > 0) {
+    if (pressed) latencyStartScenario(LATENCY_SCENARIO_FUNCTION);
     debug_print("direct fn: "); debug_print(functionNumber); debug_println( pressed ? " Pressed" : " Released");
     doFunctionWhichLocosInConsist(multiThrottleIndex, functionNumber, pressed, force);
     writeOledSpeed(); 
@@ -2854,7 +5611,7 @@ void doFunction(int multiThrottleIndex, int functionNumber, bool pressed, bool f
   if (wiThrottleProtocol.getNumberOfLocomotives(multiThrottleIndexChar)>0) {
     if (force) {
       doFunctionWhichLocosInConsist(multiThrottleIndex, functionNumber, true, force);
-      if (!functionStates[multiThrottleIndex][functionNumber]) {
+      if (!getFunctionState(multiThrottleIndex, functionNumber)) {
         debug_print("fn: "); debug_print(functionNumber); debug_println(" Pressed FORCED");
         // functionStates[functionNumber] = true;
       } else {
@@ -2878,17 +5635,17 @@ void doFunctionWhichLocosInConsist(int multiThrottleIndex, int functionNumber, b
 }
 void doFunctionWhichLocosInConsist(int multiThrottleIndex, int functionNumber, bool pressed, bool force) {
   char multiThrottleIndexChar = getMultiThrottleChar(multiThrottleIndex);
-  if (functionFollow[multiThrottleIndex][functionNumber]==CONSIST_LEAD_LOCO) {
-    wiThrottleProtocol.setFunction(multiThrottleIndexChar, "", functionNumber, pressed, force);
+  if (throttleStates[multiThrottleIndex].functionFollow[functionNumber]==CONSIST_LEAD_LOCO) {
+    queueOutboundCommand(OUTBOUND_CMD_FUNCTION, multiThrottleIndexChar, functionNumber, "", pressed, force);
   } else {  // at the momemnt the only other option in CONSIST_ALL_LOCOS
-    wiThrottleProtocol.setFunction(multiThrottleIndexChar, "*", functionNumber, pressed, force);
+    queueOutboundCommand(OUTBOUND_CMD_FUNCTION, multiThrottleIndexChar, functionNumber, "*", pressed, force);
   }
   debug_print("doFunctionWhichLocosInConsist(): fn: "); debug_print(functionNumber); debug_println(" Released");
 }
 
 void powerOnOff(TrackPower powerState) {
   debug_println("powerOnOff()");
-  wiThrottleProtocol.setTrackPower(powerState);
+  queueOutboundCommand(OUTBOUND_CMD_POWER, '*', powerState);
   trackPower = powerState;
   writeOledSpeed();
 }
@@ -2912,6 +5669,7 @@ void nextThrottle() {
   currentThrottleIndexChar = getMultiThrottleChar(currentThrottleIndex);
 
   if (currentThrottleIndex!=wasThrottle) {
+    latencyStartScenario(LATENCY_SCENARIO_THROTTLE_SWITCH);
     writeOledSpeed();
   }
 }
@@ -2923,6 +5681,7 @@ void throttle(int throttleIndex) {
   currentThrottleIndexChar = getMultiThrottleChar(currentThrottleIndex);
 
   if (currentThrottleIndex!=wasThrottle) {
+    latencyStartScenario(LATENCY_SCENARIO_THROTTLE_SWITCH);
     writeOledSpeed();
   }
 }
@@ -2930,7 +5689,7 @@ void throttle(int throttleIndex) {
 void changeNumberOfThrottles(bool increase) {
   if (increase) {
     maxThrottles++;
-    if (maxThrottles>6) maxThrottles = 6;   /// can't have more than 6
+    if (maxThrottles>THROTTLE_POOL_SIZE) maxThrottles = THROTTLE_POOL_SIZE;   /// can't have more than the pool
   } else {
     maxThrottles--;
     if (maxThrottles<1) {   /// can't have less than 1
@@ -2964,20 +5723,20 @@ void batteryShowToggle() {
 
 void stopThenToggleDirection() {
   if (wiThrottleProtocol.getNumberOfLocomotives(currentThrottleIndexChar)>0) {
-    if (currentSpeed[currentThrottleIndex] != 0) {
+    if ( (throttleStates[currentThrottleIndex].speed != 0) || (momentumIsRamping(currentThrottleIndex)) ) {
       // wiThrottleProtocol.setSpeed(currentThrottleIndexChar, 0);
       speedSet(currentThrottleIndex,0);
     } else {
       if (toggleDirectionOnEncoderButtonPressWhenStationary) toggleDirection(currentThrottleIndex);
     }
-    currentSpeed[currentThrottleIndex] = 0;
+    if (!useMomentum) throttleStates[currentThrottleIndex].speed = 0;
   }
 }
 
 void reconnect() {
   clearOledArray(); 
   oledText[0] = appName; oledText[6] = appVersion; 
-  oledText[2] = MSG_DISCONNECTED;
+  oledText[2] = getText(TEXT_MSG_DISCONNECTED);
   writeOledArray(false, false);
   delay(5000);
   disconnectWitServer();
@@ -2985,7 +5744,7 @@ void reconnect() {
 
 void setLastServerResponseTime(bool force) {
   // debug_print("setLastServerResponseTime "); debug_println((force) ? "True": "False");
-  lastServerResponseTime = wiThrottleProtocol.getLastServerResponseTime();
+  lastServerResponseTime = witStream.getLastReceiveTime() / 1000;  // the library does not see the messages handled by the fast path
   if ( (lastServerResponseTime==0) || (force) ) lastServerResponseTime = millis() /1000;
   // debug_print("setLastServerResponseTime "); debug_println(lastServerResponseTime);
 }
@@ -3012,11 +5771,72 @@ int compareStrings( const void *str1, const void *str2 ) {
     return val;
 }
 
+// work out what each startup command is once, rather than every time it is run
+void parseStartupCommands() {
+  debug_println("parseStartupCommands()");
+  for(int i=0; i<4; i++) {
+    String cmd = startupCommands[i];
+    startupActionType[i] = STARTUP_ACTION_NONE;
+    startupActionText[i] = "";
+    if (cmd.length()==0) continue;
+
+    if (cmd.charAt(0) == '*') {
+      int hashAt = cmd.indexOf('#');
+      if ( (cmd.length() == 1) || (hashAt == 1) ) { // no menu command (e.g. *# shows the direct commands). Leave it to the keys
+        startupActionType[i] = STARTUP_ACTION_KEYS;
+        startupActionText[i] = cmd;
+      } else if (hashAt == (int) cmd.length()-1) {
+        startupActionType[i] = STARTUP_ACTION_MENU;
+        startupActionText[i] = cmd.substring(1, hashAt);
+      } else { // no # (the menu is left open), or something after it (e.g. a list selection)
+        startupActionType[i] = STARTUP_ACTION_KEYS;
+        startupActionText[i] = cmd;
+      }
+    } else {
+      startupActionType[i] = STARTUP_ACTION_DIRECT;
+      startupActionText[i] = cmd;
+      for(int j=0; j<cmd.length(); j++) {
+        char jKey = cmd.charAt(j);
+        if ( !( ((jKey>='0') && (jKey<='9')) || ((jKey>='A') && (jKey<='D')) ) ) {
+          startupActionType[i] = STARTUP_ACTION_KEYS;
+        }
+      }
+    }
+    debug_print("parseStartupCommands(): "); debug_print(cmd); debug_print(" type: "); debug_println(startupActionType[i]);
+  }
+}
+
 void doStartupCommands() {
       debug_println("doStartupCommands()");
+  unsigned long startTime = micros();
+  oledRenderSuppressed = true;  // only draw the result
+
   for(int i=0; i<4; i++) {
-    doOneStartupCommand(startupCommands[i]);
+    switch (startupActionType[i]) {
+      case STARTUP_ACTION_DIRECT: {
+        for(int j=0; j<startupActionText[i].length(); j++) {
+          char jKey = startupActionText[i].charAt(j);
+          doDirectCommand(jKey, true);
+          doDirectCommand(jKey, false);
+        }
+        break;
+      }
+      case STARTUP_ACTION_MENU: {
+        menuCommand = startupActionText[i];
+        menuCommandStarted = true;
+        doMenu();
+        break;
+      }
+      case STARTUP_ACTION_KEYS: {
+        doOneStartupCommand(startupCommands[i]);
+        break;
+      }
+    }
   }
+
+  oledRenderSuppressed = false;
+  refreshOled();
+  debug_print("doStartupCommands(): took "); debug_print(micros()-startTime); debug_println("us");
 }
 
 void doOneStartupCommand(String cmd) {
@@ -3043,18 +5863,15 @@ void selectRoster(int selection) {
 
   if ((selection>=0) && (selection < rosterSize)) {
     if ( (dropBeforeAcquire) && (wiThrottleProtocol.getNumberOfLocomotives(currentThrottleIndexChar)>0) ) {
-      wiThrottleProtocol.releaseLocomotive(currentThrottleIndexChar, "*");
+      queueReleaseLoco(currentThrottleIndexChar, "*");
+      invalidateDerivedState(currentThrottleIndex);
+      throttleReleased(currentThrottleIndex);
     }
     int index = rosterSortedIndex[selection];
     String loco = String(rosterLength[index]) + rosterAddress[index];
     
     // String loco = String(rosterLength[selection]) + rosterAddress[selection];
-    debug_print("add Loco: "); debug_println(loco);
-    wiThrottleProtocol.addLocomotive(currentThrottleIndexChar, loco);
-    wiThrottleProtocol.getDirection(currentThrottleIndexChar, loco);
-    wiThrottleProtocol.getSpeed(currentThrottleIndexChar);
-    resetFunctionStates(currentThrottleIndex);
-    writeOledSpeed();
+    queueAcquireLoco(currentThrottleIndexChar, loco);
     keypadUseType = KEYPAD_USE_OPERATION;
   }
 }
@@ -3065,7 +5882,7 @@ void selectTurnoutList(int selection, TurnoutAction action) {
   if ((selection>=0) && (selection < turnoutListSize)) {
     String turnout = turnoutListSysName[selection];
     debug_print("Turnout Selected: "); debug_println(turnout);
-    wiThrottleProtocol.setTurnout(turnout,action);
+    queueOutboundCommand(OUTBOUND_CMD_TURNOUT, '*', action, turnout);
     writeOledSpeed();
     keypadUseType = KEYPAD_USE_OPERATION;
   }
@@ -3077,7 +5894,7 @@ void selectRouteList(int selection) {
   if ((selection>=0) && (selection < routeListSize)) {
     String route = routeListSysName[selection];
     debug_print("Route Selected: "); debug_println(route);
-    wiThrottleProtocol.setRoute(route);
+    queueOutboundCommand(OUTBOUND_CMD_ROUTE, '*', 0, route);
     writeOledSpeed();
     keypadUseType = KEYPAD_USE_OPERATION;
   }
@@ -3087,7 +5904,7 @@ void selectFunctionList(int selection) {
   debug_print("selectFunctionList() "); debug_println(selection);
 
   if ((selection>=0) && (selection < MAX_FUNCTIONS)) {
-    String function = functionLabels[currentThrottleIndex][selection];
+    String function = throttleStates[currentThrottleIndex].functionLabels[selection];
     debug_print("Function Selected: "); debug_println(function);
     doFunction(currentThrottleIndex, selection, true,false);
     functionHasBeenSelected = true;    
@@ -3121,7 +5938,7 @@ void receivingServerInfoOled(int index, int maxExpected) {
   debug_println(lastReceivingServerDetailsTime);
   if (index < (maxExpected-1) ) {
     if (millis()-lastReceivingServerDetailsTime >= 2000) {  // refresh it every X seconds if needed
-      if (broadcastMessageText == "") broadcastMessageText = MSG_RECEIVING_SERVER_DETAILS;
+      if (broadcastMessageText == "") broadcastMessageText = getText(TEXT_MSG_RECEIVING_SERVER_DETAILS);
       lastReceivingServerDetailsTime = millis();
       broadcastMessageTime = millis();
       setMenuTextForOled(menu_menu);
@@ -3135,10 +5952,23 @@ void receivingServerInfoOled(int index, int maxExpected) {
   }
 }
 
+// text in the current language. See language_tables.h
+const char* getText(int textId) {
+  return languageTexts[currentLanguage][textId];
+}
+
+const char* getMenuText(int menuItem, int part) {
+  #ifndef USER_DEFINED_MENUS
+    return getText(menuText[menuItem][part]);
+  #else
+    return menuText[menuItem][part];
+  #endif
+}
+
 void setMenuTextForOled(int menuTextIndex) {
   debug_print("setMenuTextForOled(): ");
   debug_println(menuTextIndex);
-  oledText[5] = menu_text[menuTextIndex];
+  oledText[5] = getText(menuTextIndex);
   if (broadcastMessageText != "") {
     if (millis()-broadcastMessageTime < 10000) {
       oledText[5] = broadcastMessageText;
@@ -3156,6 +5986,9 @@ void refreshOled() {
     case last_oled_screen_speed:
       writeOledSpeed();
       break;
+    case last_oled_screen_roster:
+      writeOledRoster(lastOledStringParameter);
+      break;
     case last_oled_screen_turnout_list:
       writeOledTurnoutList(lastOledStringParameter, lastOledTurnoutParameter);
       break;
@@ -3180,6 +6013,9 @@ void refreshOled() {
     case last_oled_screen_direct_commands:
       writeOledDirectCommands();
       break;
+    case last_oled_screen_diagnostics:
+      writeOledDiagnostics();
+      break;
   }
 }
 
@@ -3194,7 +6030,7 @@ void writeOledFoundSSids(String soFar) {
         oledText[i] = String(i) + ": " + foundSsids[(page*5)+i] + "   (" + foundSsidRssis[(page*5)+i] + ")" ;
       }
     }
-    oledText[5] = "(" + String(page+1) +  ") " + menu_text[menu_select_ssids_from_found];
+    oledText[5] = "(" + String(page+1) +  ") " + getText(menu_select_ssids_from_found);
     writeOledArray(false, false);
   // } else {
   //   int cmd = menuCommand.substring(0, 1).toInt();
@@ -3210,12 +6046,11 @@ void writeOledRoster(String soFar) {
   if (soFar == "") { // nothing entered yet
     clearOledArray();
     for (int i=0; i<5 && ((page*5)+i<rosterSize); i++) {
-      int index = rosterSortedIndex[(page*5)+i];
-      if (rosterAddress[index] != 0) {
-        oledText[i] = String(i) + ": " + rosterName[index] + " (" + rosterAddress[index] + ")" ;
+      if (rosterLabels[(page*5)+i][0] != 0) {
+        oledText[i] = rosterLabels[(page*5)+i];
       }
     }
-    oledText[5] = "(" + String(page+1) +  ") " + menu_text[menu_roster];
+    oledText[5] = "(" + String(page+1) +  ") " + getText(menu_roster);
     writeOledArray(false, false);
   // } else {
   //   int cmd = menuCommand.substring(0, 1).toInt();
@@ -3238,11 +6073,11 @@ void writeOledTurnoutList(String soFar, TurnoutAction action) {
     int j = 0;
     for (int i=0; i<10 && i<turnoutListSize; i++) {
       j = (i<5) ? i : i+1;
-      if (turnoutListUserName[(page*10)+i].length()>0) {
-        oledText[j] = String(turnoutListIndex[i]) + ": " + turnoutListUserName[(page*10)+i].substring(0,10);
+      if (turnoutListLabels[(page*10)+i][0] != 0) {
+        oledText[j] = turnoutListLabels[(page*10)+i];
       }
     }
-    oledText[5] = "(" + String(page+1) +  ") " + menu_text[menu_turnout_list];
+    oledText[5] = "(" + String(page+1) +  ") " + getText(menu_turnout_list);
     writeOledArray(false, false);
   // } else {
   //   int cmd = menuCommand.substring(0, 1).toInt();
@@ -3260,11 +6095,11 @@ void writeOledRouteList(String soFar) {
     int j = 0;
     for (int i=0; i<10 && i<routeListSize; i++) {
       j = (i<5) ? i : i+1;
-      if (routeListUserName[(page*10)+i].length()>0) {
-        oledText[j] = String(routeListIndex[i]) + ": " + routeListUserName[(page*10)+i].substring(0,10);
+      if (routeListLabels[(page*10)+i][0] != 0) {
+        oledText[j] = routeListLabels[(page*10)+i];
       }
     }
-    oledText[5] =  "(" + String(page+1) +  ") " + menu_text[menu_route_list];
+    oledText[5] =  "(" + String(page+1) +  ") " + getText(menu_route_list);
     writeOledArray(false, false);
   // } else {
   //   int cmd = menuCommand.substring(0, 1).toInt();
@@ -3287,20 +6122,18 @@ void writeOledFunctionList(String soFar) {
         k = (functionPage*10) + i;
         if (k < MAX_FUNCTIONS) {
           j = (i<5) ? i : i+1;
-            oledText[j] = String(i) + ": " 
-            + ((k<10) ? functionLabels[currentThrottleIndex][k].substring(0,10) : String(k) 
-            + "-" + functionLabels[currentThrottleIndex][k].substring(0,7)) ;
+            oledText[j] = throttleStates[currentThrottleIndex].functionListLabels[k];
             
-            if (functionStates[currentThrottleIndex][k]) {
+            if (getFunctionState(currentThrottleIndex, k)) {
               oledTextInvert[j] = true;
             }
         }
       }
-      oledText[5] = "(" + String(functionPage) +  ") " + menu_text[menu_function_list];
+      oledText[5] = "(" + String(functionPage) +  ") " + getText(menu_function_list);
     } else {
-      oledText[0] = MSG_NO_FUNCTIONS;
-      oledText[2] = MSG_THROTTLE_NUMBER + String(currentThrottleIndex+1);
-      oledText[3] = MSG_NO_LOCO_SELECTED;
+      oledText[0] = getText(TEXT_MSG_NO_FUNCTIONS);
+      oledText[2] = getText(TEXT_MSG_THROTTLE_NUMBER) + String(currentThrottleIndex+1);
+      oledText[3] = getText(TEXT_MSG_NO_LOCO_SELECTED);
       // oledText[5] = menu_cancel;
       setMenuTextForOled(menu_cancel);
     }
@@ -3321,7 +6154,7 @@ void writeOledEnterPassword() {
   } else {
     tempSsidPasswordEntered = " "+tempSsidPasswordEntered;
   }
-  oledText[0] = MSG_ENTER_PASSWORD;
+  oledText[0] = getText(TEXT_MSG_ENTER_PASSWORD);
   oledText[2] = tempSsidPasswordEntered;
   // oledText[5] = menu_enter_ssid_password;
   setMenuTextForOled(menu_enter_ssid_password);
@@ -3347,9 +6180,9 @@ void writeOledMenu(String soFar, bool primeMenu) {
     int j = 0;
     for (int i=1+offset; i<10+offset; i++) {
       j = (i<6+offset) ? i-offset : i+1-offset;
-      oledText[j-1] = String(i-offset) + ": " + menuText[i][0];
+      oledText[j-1] = String(i-offset) + ": " + getMenuText(i,0);
     }
-    oledText[10] = "0: " + menuText[0+offset][0];
+    oledText[10] = String("0: ") + getMenuText(0+offset,0);
     // oledText[5] = menu_cancel;
     setMenuTextForOled(menu_cancel);
     writeOledArray(false, false);
@@ -3358,8 +6191,8 @@ void writeOledMenu(String soFar, bool primeMenu) {
 
     clearOledArray();
 
-    oledText[0] = ">> " + menuText[cmd][0] +":"; oledText[6] =  menuCommand.substring(1, menuCommand.length());
-    oledText[5] = menuText[cmd+offset][1];
+    oledText[0] = String(">> ") + getMenuText(cmd,0) +":"; oledText[6] =  menuCommand.substring(1, menuCommand.length());
+    oledText[5] = getMenuText(cmd+offset,1);
 
     switch (soFar.charAt(0)) {
       case MENU_ITEM_DROP_LOCO: {
@@ -3371,8 +6204,8 @@ void writeOledMenu(String soFar, bool primeMenu) {
       case MENU_ITEM_FUNCTION:
       case MENU_ITEM_TOGGLE_DIRECTION: {
           if (wiThrottleProtocol.getNumberOfLocomotives(currentThrottleIndexChar) <= 0 ) {
-            oledText[2] = MSG_THROTTLE_NUMBER + String(currentThrottleIndex+1);
-            oledText[3] = MSG_NO_LOCO_SELECTED;
+            oledText[2] = getText(TEXT_MSG_THROTTLE_NUMBER) + String(currentThrottleIndex+1);
+            oledText[3] = getText(TEXT_MSG_NO_LOCO_SELECTED);
             // oledText[5] = menu_cancel;
             setMenuTextForOled(menu_cancel);
           } 
@@ -3415,21 +6248,21 @@ void writeOledEditConsist() {
   debug_println("writeOledEditConsist(): ");
   keypadUseType = KEYPAD_USE_EDIT_CONSIST;
   writeOledAllLocos(true);
-  oledText[0] = MENU_ITEM_TEXT_TITLE_EDIT_CONSIST;
-  oledText[5] = MENU_ITEM_TEXT_MENU_EDIT_CONSIST;
+  oledText[0] = getText(TEXT_MENU_ITEM_TEXT_TITLE_EDIT_CONSIST);
+  oledText[5] = getText(TEXT_MENU_ITEM_TEXT_MENU_EDIT_CONSIST);
   writeOledArray(false, false);
 }
 
 void writeHeartbeatCheck() {
   menuIsShowing = false;
   clearOledArray();
-  oledText[0] = MENU_ITEM_TEXT_TITLE_HEARTBEAT;
+  oledText[0] = getText(TEXT_MENU_ITEM_TEXT_TITLE_HEARTBEAT);
   if (heartbeatCheckEnabled) {
-    oledText[1] = MSG_HEARTBEAT_CHECK_ENABLED; 
+    oledText[1] = getText(TEXT_MSG_HEARTBEAT_CHECK_ENABLED); 
   } else {
-    oledText[1] = MSG_HEARTBEAT_CHECK_DISABLED; 
+    oledText[1] = getText(TEXT_MSG_HEARTBEAT_CHECK_DISABLED); 
   }
-  oledText[5] = MENU_ITEM_TEXT_MENU_HEARTBEAT;
+  oledText[5] = getText(TEXT_MENU_ITEM_TEXT_MENU_HEARTBEAT);
   writeOledArray(false, false);
 }
 
@@ -3439,10 +6272,9 @@ void writeOledSpeed() {
   // debug_println("writeOledSpeed() ");
   
   menuIsShowing = false;
-  String sLocos = "";
+  if (oledRenderSuppressed) return;
   String sSpeed = "";
   String sDirection = "";
-  String sSpaceBetweenLocos = " ";
 
   bool foundNextThrottle = false;
   String sNextThrottleNo = "";
@@ -3452,24 +6284,22 @@ void writeOledSpeed() {
   
   bool drawTopLine = false;
 
-  if (wiThrottleProtocol.getNumberOfLocomotives(currentThrottleIndexChar) > 0 ) {
+  updateDerivedState();
+  bool currentThrottleHasLocos = (activeThrottles & (1 << currentThrottleIndex)) != 0;
+
+  if (currentThrottleHasLocos) {
     // oledText[0] = label_locos; oledText[2] = label_speed;
   
-    for (int i=0; i < wiThrottleProtocol.getNumberOfLocomotives(currentThrottleIndexChar); i++) {
-      // sLocos = sLocos + sSpaceBetweenLocos + wiThrottleProtocol.getLocomotiveAtPosition(currentThrottleIndexChar, i);
-      sLocos = sLocos + sSpaceBetweenLocos + getDisplayLocoString(currentThrottleIndex, i);
-      sSpaceBetweenLocos = CONSIST_SPACE_BETWEEN_LOCOS;
-    }
-    // sSpeed = String(currentSpeed[currentThrottleIndex]);
+    // sSpeed = String(throttleStates[currentThrottleIndex].speed);
     sSpeed = String(getDisplaySpeed(currentThrottleIndex));
-    sDirection = (currentDirection[currentThrottleIndex]==Forward) ? DIRECTION_FORWARD_TEXT : DIRECTION_REVERSE_TEXT;
+    sDirection = getText((throttleStates[currentThrottleIndex].direction==Forward) ? TEXT_DIRECTION_FORWARD_TEXT : TEXT_DIRECTION_REVERSE_TEXT);
 
     //find the next Throttle that has any locos selected - if there is one
     if (maxThrottles > 1) {
       int nextThrottleIndex = currentThrottleIndex + 1;
 
       for (int i = nextThrottleIndex; i<maxThrottles; i++) {
-        if (wiThrottleProtocol.getNumberOfLocomotives(getMultiThrottleChar(i)) > 0 ) {
+        if (activeThrottles & (1 << i)) {
           foundNextThrottle = true;
           nextThrottleIndex = i;
           break;
@@ -3477,7 +6307,7 @@ void writeOledSpeed() {
       }
       if ( (!foundNextThrottle) && (currentThrottleIndex>0) ) {
         for (int i = 0; i<currentThrottleIndex; i++) {
-          if (wiThrottleProtocol.getNumberOfLocomotives(getMultiThrottleChar(i)) > 0 ) {
+          if (activeThrottles & (1 << i)) {
             foundNextThrottle = true;
             nextThrottleIndex = i;
             break;
@@ -3489,27 +6319,27 @@ void writeOledSpeed() {
         int speed = getDisplaySpeed(nextThrottleIndex);
         sNextThrottleSpeedAndDirection = String(speed);
         // if (speed>0) {
-          if (currentDirection[nextThrottleIndex]==Forward) {
+          if (throttleStates[nextThrottleIndex].direction==Forward) {
             sNextThrottleSpeedAndDirection = sNextThrottleSpeedAndDirection + DIRECTION_FORWARD_TEXT_SHORT;
           } else {
             sNextThrottleSpeedAndDirection = DIRECTION_REVERSE_TEXT_SHORT + sNextThrottleSpeedAndDirection;
           }
         // }
-        // + " " + ((currentDirection[nextThrottleIndex]==Forward) ? DIRECTION_FORWARD_TEXT_SHORT : DIRECTION_REVERSE_TEXT_SHORT);
+        // + " " + ((throttleStates[nextThrottleIndex].direction==Forward) ? DIRECTION_FORWARD_TEXT_SHORT : DIRECTION_REVERSE_TEXT_SHORT);
         sNextThrottleSpeedAndDirection = "     " + sNextThrottleSpeedAndDirection ;
         sNextThrottleSpeedAndDirection = sNextThrottleSpeedAndDirection.substring(sNextThrottleSpeedAndDirection.length()-5);
       }
     }
 
-    oledText[0] = "   "  + sLocos; 
+    oledText[0] = "   "  + throttleStates[currentThrottleIndex].displayLocos; 
     //oledText[7] = "     " + sDirection;  // old function state format
 
     drawTopLine = true;
 
   } else {
     setAppnameForOled();
-    oledText[2] = MSG_THROTTLE_NUMBER + String(currentThrottleIndex+1);
-    oledText[3] = MSG_NO_LOCO_SELECTED;
+    oledText[2] = getText(TEXT_MSG_THROTTLE_NUMBER) + String(currentThrottleIndex+1);
+    oledText[3] = getText(TEXT_MSG_NO_LOCO_SELECTED);
     drawTopLine = true;
   }
 
@@ -3523,7 +6353,7 @@ void writeOledSpeed() {
 
   writeOledArray(false, false, false, drawTopLine);
 
-  if (wiThrottleProtocol.getNumberOfLocomotives(currentThrottleIndexChar) > 0 ) {
+  if (currentThrottleHasLocos) {
     writeOledFunctions();
 
      // throttle number
@@ -3575,13 +6405,16 @@ void writeOledSpeed() {
     u8g2.drawStr(85+12,48, sNextThrottleSpeedAndDirection.c_str() );
   }
 
-  u8g2.sendBuffer();
+  writeOledLinkIndicator(!foundNextThrottle);  // the next throttle's speed is drawn where the time would be
+
+  oledSendBuffer();
+  latencyMarkPixel();
 
   // debug_println("writeOledSpeed(): end");
 }
 
 void writeOledSpeedStepMultiplier() {
-  if (speedStep != currentSpeedStep[currentThrottleIndex]) {
+  if (speedStep != throttleStates[currentThrottleIndex].speedStep) {
     // oledText[3] = "X " + String(speedStepCurrentMultiplier);
     u8g2.setDrawColor(1);
     u8g2.setFont(FONT_GLYPHS);
@@ -3631,7 +6464,7 @@ void writeOledFunctions() {
   //  int x = 99;
   // bool anyFunctionsActive = false;
    for (int i=0; i < MAX_FUNCTIONS; i++) {
-     if (functionStates[currentThrottleIndex][i]) {
+     if (getFunctionState(currentThrottleIndex, i)) {
       // old function state format
   //     //  debug_print("Fn On "); debug_println(i);
   //     if (i < 12) {
@@ -3669,6 +6502,90 @@ void writeOledFunctions() {
   debug_println("writeOledFunctions(): end");
 }
 
+// *********************************************************************************
+//  oLED transfer
+// *********************************************************************************
+// With USE_ASYNC_DISPLAY the finished frame is copied out of the u8g2 buffer and a task 
+// on the other core sends it over I2C, so the loop only pays for the copy.
+// If a newer frame arrives before the task has started on the last one, the older one is dropped.
+
+void oledStartSendTask() {
+  if (!useAsyncDisplay) return;
+  if ( (u8g2.getBufferTileWidth() * u8g2.getBufferTileHeight() * 8) > OLED_FRAME_BUFFER_SIZE ) {
+    debug_println("oledStartSendTask(): display buffer too large. Using sync transfer");
+    useAsyncDisplay = false;
+    return;
+  }
+  xTaskCreatePinnedToCore(oledSendTask, "oledSend", 2048, NULL, 1, &oledSendTaskHandle, 0);
+}
+
+void oledSendBuffer() {
+  unsigned long startTime = micros();
+
+  if ( (!useAsyncDisplay) || (oledSendTaskHandle == NULL) ) {
+    u8g2.sendBuffer();
+  } else {
+    int target;
+    portENTER_CRITICAL(&oledFrameMux);
+    target = (oledFrameSending == 0) ? 1 : 0;   // never the one being sent
+    if (oledFrameWaiting == target) {
+      oledFrameWaiting = -1;
+      oledFramesDropped++;
+    }
+    portEXIT_CRITICAL(&oledFrameMux);
+
+    memcpy(oledFrameBuffers[target], u8g2.getBufferPtr(), u8g2.getBufferTileWidth() * u8g2.getBufferTileHeight() * 8);
+
+    portENTER_CRITICAL(&oledFrameMux);
+    oledFrameWaiting = target;
+    portEXIT_CRITICAL(&oledFrameMux);
+    xTaskNotifyGive(oledSendTaskHandle);
+  }
+
+  unsigned long blockedTime = micros() - startTime;
+  oledFramesSent++;
+  oledBlockedTimeTotal += blockedTime;
+  if (blockedTime > oledBlockedTimeMax) oledBlockedTimeMax = blockedTime;
+}
+
+void oledSendTask(void *parameter) {
+  u8x8_t *u8x8 = u8g2.getU8x8();
+  int tileWidth = u8g2.getBufferTileWidth();
+  int tileHeight = u8g2.getBufferTileHeight();
+
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    for (;;) {
+      int frame;
+      portENTER_CRITICAL(&oledFrameMux);
+      frame = oledFrameWaiting;
+      oledFrameWaiting = -1;
+      oledFrameSending = frame;
+      portEXIT_CRITICAL(&oledFrameMux);
+      if (frame < 0) break;
+
+      for (int row = 0; row < tileHeight; row++) {
+        u8x8_DrawTile(u8x8, 0, row, tileWidth, oledFrameBuffers[frame] + (row * tileWidth * 8));
+      }
+      u8x8_RefreshDisplay(u8x8);
+
+      portENTER_CRITICAL(&oledFrameMux);
+      oledFrameSending = -1;
+      portEXIT_CRITICAL(&oledFrameMux);
+    }
+  }
+}
+
+// wait for anything queued to reach the display.  e.g. before sleeping
+void oledWaitForSend() {
+  if (oledSendTaskHandle == NULL) return;
+  unsigned long startTime = millis();
+  while ( ( (oledFrameWaiting >= 0) || (oledFrameSending >= 0) ) && (millis() - startTime < 500) ) {
+    delay(1);
+  }
+}
+
 void writeOledArray(bool isThreeColums, bool isPassword) {
   writeOledArray(isThreeColums, isPassword, true, false);
 }
@@ -3679,6 +6596,7 @@ void writeOledArray(bool isThreeColums, bool isPassword, bool sendBuffer) {
 
 void writeOledArray(bool isThreeColums, bool isPassword, bool sendBuffer, bool drawTopLine) {
   // debug_println("Start writeOledArray()");
+  if (oledRenderSuppressed) return;
   u8g2.clearBuffer();					// clear the internal memory
 
   u8g2.setFont(FONT_DEFAULT); // small
@@ -3717,7 +6635,10 @@ void writeOledArray(bool isThreeColums, bool isPassword, bool sendBuffer, bool d
   }
   u8g2.drawHLine(0,51,128);
 
-  if (sendBuffer) u8g2.sendBuffer();					// transfer internal memory to the display
+  if (sendBuffer) {
+    oledSendBuffer();					// transfer internal memory to the display
+    latencyMarkPixel();
+  }
   // debug_println("writeOledArray(): end ");
 }
 
@@ -3733,7 +6654,7 @@ void writeOledDirectCommands() {
 
   oledDirectCommandsAreBeingDisplayed = true;
   clearOledArray();
-  oledText[0] = DIRECT_COMMAND_LIST;
+  oledText[0] = getText(TEXT_DIRECT_COMMAND_LIST);
   for (int i=0; i < 4; i++) {
     oledText[i+1] = directCommandText[i][0];
   }
@@ -3762,17 +6683,22 @@ void deepSleepStart(int shutdownReason) {
   setAppnameForOled();
   int delayPeriod = 2000;
   if (shutdownReason==SLEEP_REASON_INACTIVITY) {
-    oledText[2] = MSG_AUTO_SLEEP;
+    oledText[2] = getText(TEXT_MSG_AUTO_SLEEP);
     delayPeriod = 10000;
   } else if (shutdownReason==SLEEP_REASON_BATTERY) {
-    oledText[2] = MSG_BATTERY_SLEEP;
+    oledText[2] = getText(TEXT_MSG_BATTERY_SLEEP);
     delayPeriod = 10000;
   }
-  oledText[3] = MSG_START_SLEEP;
+  oledText[3] = getText(TEXT_MSG_START_SLEEP);
   writeOledBattery();
   writeOledArray(false, false, true, true);
+  fastResumeWriteSnapshot();
   delay(delayPeriod);
 
+  oledWaitForSend();
   u8g2.setPowerSave(1);
+#if WITCONTROLLER_DEBUG == 0
+  witLog.flush();
+#endif
   esp_deep_sleep_start();
 }
@@ -0,0 +1,321 @@
+/*
+ *  WitLog
+ *
+ * Console debug messages, without waiting on the serial port.
+ * See WitLog.h
+ */
+
+#include "Arduino.h"
+#include "WitLog.h"
+
+// record types. Each is followed by its value
+#define WIT_LOG_TEXT     1   // length (1 byte), then the characters
+#define WIT_LOG_CHAR     2   // 1 byte
+#define WIT_LOG_INT      3   // base (1 byte), int32
+#define WIT_LOG_UINT     4   // base (1 byte), uint32
+#define WIT_LOG_DOUBLE   5   // digits (1 byte), float
+#define WIT_LOG_IP       6   // 4 bytes
+#define WIT_LOG_END      7   // millis (uint32)
+
+#define WIT_LOG_MAX_RECORD (2 + WIT_LOG_MAX_TEXT)
+
+WitLog::WitLog()
+{
+    _out = NULL;
+    _async = false;
+    _taskHandle = NULL;
+    _mux = portMUX_INITIALIZER_UNLOCKED;
+    _head = 0;
+    _used = 0;
+    _highWater = 0;
+    _draining = false;
+    _lineLength = 0;
+    _recordCount = 0;
+    _droppedCount = 0;
+    _droppedReported = 0;
+}
+
+void WitLog::begin(Print *out, bool async)
+{
+    _out = out;
+    _async = async;
+    if (!_async) drain();
+}
+
+bool WitLog::startTask(int core)
+{
+    if (!_async) return false;
+    if (_taskHandle != NULL) return true;
+    if (xTaskCreatePinnedToCore(_task, "witLog", 3072, this, tskIDLE_PRIORITY + 1, &_taskHandle, core) != pdPASS) {
+        _taskHandle = NULL;
+        _async = false;
+        drain();
+        return false;
+    }
+    return true;
+}
+
+void WitLog::_task(void *parameter)
+{
+    WitLog *log = (WitLog *) parameter;
+    for (;;) {
+        log->drain();
+        vTaskDelay(pdMS_TO_TICKS(WIT_LOG_DRAIN_INTERVAL));
+    }
+}
+
+// *********************************************************************************
+// adding records
+
+void WitLog::_add(const uint8_t *record, int length)
+{
+    portENTER_CRITICAL(&_mux);
+    if ((WIT_LOG_BUFFER_SIZE - _used) < length) {
+        _droppedCount++;
+    } else {
+        int tail = (_head + _used) % WIT_LOG_BUFFER_SIZE;
+        int first = WIT_LOG_BUFFER_SIZE - tail;
+        if (first > length) first = length;
+        memcpy(_buffer + tail, record, first);
+        memcpy(_buffer, record + first, length - first);
+        _used += length;
+        if (_used > _highWater) _highWater = _used;
+        _recordCount++;
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    if (!_async) drain();
+}
+
+void WitLog::_addText(const char *text, int length)
+{
+    uint8_t record[WIT_LOG_MAX_RECORD];
+    if (length > WIT_LOG_MAX_TEXT) length = WIT_LOG_MAX_TEXT;
+    record[0] = WIT_LOG_TEXT;
+    record[1] = length;
+    memcpy(record + 2, text, length);
+    _add(record, length + 2);
+}
+
+void WitLog::_addNumber(uint8_t type, uint8_t format, uint32_t value)
+{
+    uint8_t record[6];
+    record[0] = type;
+    record[1] = format;
+    memcpy(record + 2, &value, 4);
+    _add(record, 6);
+}
+
+void WitLog::print(const char *text)
+{
+    if (text == NULL) return;
+    _addText(text, strlen(text));
+}
+
+void WitLog::print(const String &text)
+{
+    _addText(text.c_str(), text.length());
+}
+
+void WitLog::print(char c)
+{
+    uint8_t record[2] = { WIT_LOG_CHAR, (uint8_t) c };
+    _add(record, 2);
+}
+
+void WitLog::print(signed char value, int base)    { _addNumber(WIT_LOG_INT, base, (int32_t) value); }
+void WitLog::print(unsigned char value, int base)  { _addNumber(WIT_LOG_UINT, base, value); }
+void WitLog::print(short value, int base)          { _addNumber(WIT_LOG_INT, base, (int32_t) value); }
+void WitLog::print(unsigned short value, int base) { _addNumber(WIT_LOG_UINT, base, value); }
+void WitLog::print(int value, int base)            { _addNumber(WIT_LOG_INT, base, (int32_t) value); }
+void WitLog::print(unsigned int value, int base)   { _addNumber(WIT_LOG_UINT, base, value); }
+void WitLog::print(long value, int base)           { _addNumber(WIT_LOG_INT, base, (int32_t) value); }
+void WitLog::print(unsigned long value, int base)  { _addNumber(WIT_LOG_UINT, base, value); }
+
+void WitLog::print(double value, int digits)
+{
+    float f = value;
+    uint32_t bits;
+    memcpy(&bits, &f, 4);
+    _addNumber(WIT_LOG_DOUBLE, digits, bits);
+}
+
+void WitLog::print(const IPAddress &address)
+{
+    uint8_t record[5] = { WIT_LOG_IP, address[0], address[1], address[2], address[3] };
+    _add(record, 5);
+}
+
+void WitLog::endLine()
+{
+    uint32_t now = millis();
+    uint8_t record[5];
+    record[0] = WIT_LOG_END;
+    memcpy(record + 1, &now, 4);
+    _add(record, 5);
+}
+
+void WitLog::printf(const char *format, ...)
+{
+    char text[WIT_LOG_MAX_TEXT + 1];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (length < 0) return;
+    _addText(text, (length > WIT_LOG_MAX_TEXT) ? WIT_LOG_MAX_TEXT : length);
+}
+
+// *********************************************************************************
+// writing them out
+
+// copies the oldest record out of the buffer. returns its length, or 0 if there are none
+int WitLog::_takeRecord(uint8_t *record)
+{
+    int length = 0;
+    portENTER_CRITICAL(&_mux);
+    if (_used > 0) {
+        switch (_buffer[_head]) {
+            case WIT_LOG_TEXT:   length = 2 + _buffer[(_head + 1) % WIT_LOG_BUFFER_SIZE]; break;
+            case WIT_LOG_CHAR:   length = 2; break;
+            case WIT_LOG_IP:
+            case WIT_LOG_END:    length = 5; break;
+            default:             length = 6; break;
+        }
+        for (int i = 0; i < length; i++) {
+            record[i] = _buffer[(_head + i) % WIT_LOG_BUFFER_SIZE];
+        }
+        _head = (_head + length) % WIT_LOG_BUFFER_SIZE;
+        _used -= length;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return length;
+}
+
+void WitLog::drain(bool partial)
+{
+    if (_out == NULL) return;
+
+    portENTER_CRITICAL(&_mux);
+    bool busy = _draining;
+    _draining = true;
+    unsigned long dropped = _droppedCount;
+    portEXIT_CRITICAL(&_mux);
+    if (busy) return;   // only one writer, so the lines are not mixed up
+
+    uint8_t record[WIT_LOG_MAX_RECORD];
+    while (_takeRecord(record) > 0) {
+        _format(record);
+    }
+    if (partial) _writeLine();   // anything printed without a line end yet
+
+    if (dropped != _droppedReported) {   // they were dropped after the ones just written
+        char text[48];
+        int length = snprintf(text, sizeof(text), "\r\n[log] %lu records dropped\r\n", dropped - _droppedReported);
+        _out->write((const uint8_t *) text, length);
+        _droppedReported = dropped;
+    }
+
+    portENTER_CRITICAL(&_mux);
+    _draining = false;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void WitLog::flush(unsigned long timeout)
+{
+    unsigned long startTime = millis();
+    while ((_used > 0) && ((millis() - startTime) < timeout)) {
+        drain(true);
+        if (_used > 0) delay(1);   // the task has it
+    }
+    drain(true);   // a line without its end yet
+    if (_out != NULL) _out->flush();
+}
+
+void WitLog::_format(const uint8_t *record)
+{
+    char text[40];
+    int length = 0;
+    uint32_t value;
+    memcpy(&value, record + 2, 4);
+
+    switch (record[0]) {
+        case WIT_LOG_TEXT:
+            _append((const char *) record + 2, record[1]);
+            return;
+        case WIT_LOG_CHAR:
+            _append((const char *) record + 1, 1);
+            return;
+        case WIT_LOG_INT:
+            if (record[1] == DEC) {
+                length = snprintf(text, sizeof(text), "%ld", (long) (int32_t) value);
+                break;
+            }
+            // other bases show the bits, like Print
+        case WIT_LOG_UINT:
+            if (record[1] == HEX) {
+                length = snprintf(text, sizeof(text), "%lX", (unsigned long) value);
+            } else if (record[1] == OCT) {
+                length = snprintf(text, sizeof(text), "%lo", (unsigned long) value);
+            } else if (record[1] == BIN) {
+                int bits = 32;
+                while ((bits > 1) && ((value & (1UL << (bits - 1))) == 0)) bits--;
+                for (int i = bits - 1; i >= 0; i--) text[length++] = (value & (1UL << i)) ? '1' : '0';
+            } else {
+                length = snprintf(text, sizeof(text), "%lu", (unsigned long) value);
+            }
+            break;
+        case WIT_LOG_DOUBLE: {
+            float f;
+            memcpy(&f, &value, 4);
+            length = snprintf(text, sizeof(text), "%.*f", record[1], f);
+            break;
+        }
+        case WIT_LOG_IP:
+            length = snprintf(text, sizeof(text), "%u.%u.%u.%u", record[1], record[2], record[3], record[4]);
+            break;
+        case WIT_LOG_END:
+            memcpy(&value, record + 1, 4);
+            length = snprintf(text, sizeof(text), " (%lu)\r\n", (unsigned long) value);
+            _append(text, length);
+            _writeLine();
+            return;
+    }
+    if (length > (int) sizeof(text) - 1) length = sizeof(text) - 1;
+    if (length > 0) _append(text, length);
+}
+
+void WitLog::_append(const char *text, int length)
+{
+    while (length > 0) {
+        if (_lineLength == WIT_LOG_LINE_SIZE) _writeLine();
+        int chunk = WIT_LOG_LINE_SIZE - _lineLength;
+        if (chunk > length) chunk = length;
+        memcpy(_line + _lineLength, text, chunk);
+        _lineLength += chunk;
+        text += chunk;
+        length -= chunk;
+    }
+}
+
+void WitLog::_writeLine()
+{
+    if (_lineLength == 0) return;
+    _out->write((const uint8_t *) _line, _lineLength);
+    _lineLength = 0;
+}
+
+unsigned long WitLog::getRecordCount()
+{
+    return _recordCount;
+}
+
+unsigned long WitLog::getDroppedCount()
+{
+    return _droppedCount;
+}
+
+int WitLog::getHighWater()
+{
+    return _highWater;
+}
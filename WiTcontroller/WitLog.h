@@ -0,0 +1,129 @@
+/*
+ *  WitLog
+ *
+ * Console debug messages, without waiting on the serial port.
+ *
+ * Each value printed is stored as a small binary record (type + raw value) in a ring buffer,
+ * and a line end record carries the millis() it was written at.  The records are turned into
+ * text and written to the output later, from a low priority task (or from drain()).
+ * So a debug message in the loop costs a copy of a few bytes, not the time to send it at 115200 baud.
+ *
+ * If the buffer is full the record is dropped and counted. The count is shown with the next output.
+ *
+ * Only whole lines are written (except by flush(), or a line longer than WIT_LOG_LINE_SIZE), 
+ * so the output does not split other lines written straight to the same port, e.g. the serial API's.
+ */
+
+#ifndef WitLog_h
+#define WitLog_h
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+#ifndef WIT_LOG_BUFFER_SIZE
+  #define WIT_LOG_BUFFER_SIZE 4096     // records waiting to be written
+#endif
+#ifndef WIT_LOG_LINE_SIZE
+  #define WIT_LOG_LINE_SIZE 256        // text is written to the output a line at a time (or this much of one)
+#endif
+#ifndef WIT_LOG_DRAIN_INTERVAL
+  #define WIT_LOG_DRAIN_INTERVAL 20    // ms between the task checking for records
+#endif
+
+#define WIT_LOG_MAX_TEXT 255           // longer text is cut short
+
+class WitLog {
+  public:
+    WitLog();
+
+    /*
+     * @param out, where the text goes (normally Serial)
+     * @param async, false = write each record straight away (e.g. to compare the timing)
+     * Records can be added before begin(). They are kept until there is an output
+     */
+    void begin(Print *out, bool async);
+
+    /*
+     * Write the records from a task on the given core, at a low priority
+     * @return false if the task could not be started. Records are then written straight away
+     */
+    bool startTask(int core);
+
+    // one record per value. The same as the Print functions of the same names
+    void print(const char *text);
+    void print(const String &text);
+    void print(char c);
+    void print(signed char value, int base = DEC);
+    void print(unsigned char value, int base = DEC);
+    void print(short value, int base = DEC);
+    void print(unsigned short value, int base = DEC);
+    void print(int value, int base = DEC);
+    void print(unsigned int value, int base = DEC);
+    void print(long value, int base = DEC);
+    void print(unsigned long value, int base = DEC);
+    void print(double value, int digits = 2);
+    void print(const IPAddress &address);
+
+    // ends the line with the time it was written, i.e. " (<millis>)"
+    void endLine();
+
+    template <typename T> void println(const T &value) { print(value); endLine(); }
+    template <typename T> void println(const T &value, int format) { print(value, format); endLine(); }
+
+    // each value, then the line end
+    void line() { endLine(); }
+    template <typename T, typename... Rest> void line(const T &value, const Rest &... rest) {
+      print(value);
+      line(rest...);
+    }
+
+    // formatted now (so the arguments can be anything), but written later as text
+    void printf(const char *format, ...);
+
+    /*
+     * Write out everything waiting.  Called by the task, or from the loop if there isn't one
+     * @param partial, true = also write the part of a line printed so far.  Otherwise it waits for its line end
+     */
+    void drain(bool partial = false);
+
+    /*
+     * Wait (up to timeout ms) until everything waiting has been written, e.g. before deep sleep
+     */
+    void flush(unsigned long timeout = 500);
+
+    // statistics
+    unsigned long getRecordCount();
+    unsigned long getDroppedCount();
+    int getHighWater();        // most bytes ever waiting
+
+  private:
+    Print *_out;
+    bool _async;
+    TaskHandle_t _taskHandle;
+    portMUX_TYPE _mux;
+
+    uint8_t _buffer[WIT_LOG_BUFFER_SIZE];
+    int _head;                 // next to be read
+    volatile int _used;
+    int _highWater;
+    bool _draining;
+
+    char _line[WIT_LOG_LINE_SIZE];
+    int _lineLength;
+
+    unsigned long _recordCount;
+    unsigned long _droppedCount;
+    unsigned long _droppedReported;
+
+    void _add(const uint8_t *record, int length);
+    void _addText(const char *text, int length);
+    void _addNumber(uint8_t type, uint8_t format, uint32_t value);
+    int  _takeRecord(uint8_t *record);
+    void _format(const uint8_t *record);
+    void _append(const char *text, int length);
+    void _writeLine();
+
+    static void _task(void *parameter);
+};
+
+#endif
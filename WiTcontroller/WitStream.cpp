@@ -0,0 +1,272 @@
+/*
+ *  WitStream
+ *
+ * A Stream that sits between the WiThrottleProtocol library and the WiFiClient.
+ * See WitStream.h
+ */
+
+#include "Arduino.h"
+#include "WitStream.h"
+
+WitStream::WitStream()
+{
+    _client = NULL;
+    _capture = NULL;
+    _lineHandler = NULL;
+    _lineRecorder = NULL;
+    _rxLength = 0;
+    _rxOverflow = false;
+    _passHead = 0;
+    _passCount = 0;
+    _lastReceiveTime = 0;
+    _handledLineCount = 0;
+    _passthroughLineCount = 0;
+    _bytesReceived = 0;
+    _txLength = 0;
+    _segmentsSent = 0;
+    _bytesSent = 0;
+}
+
+void WitStream::begin(Stream *client)
+{
+    _client = client;
+    _rxLength = 0;
+    _rxOverflow = false;
+    _passHead = 0;
+    _passCount = 0;
+    _lastReceiveTime = 0;
+    _handledLineCount = 0;
+    _passthroughLineCount = 0;
+    _bytesReceived = 0;
+    _txLength = 0;
+    _segmentsSent = 0;
+    _bytesSent = 0;
+}
+
+void WitStream::setLineHandler(WitStreamLineHandler lineHandler)
+{
+    _lineHandler = lineHandler;
+}
+
+void WitStream::setLineRecorder(WitStreamLineHandler lineRecorder)
+{
+    _lineRecorder = lineRecorder;
+}
+
+bool WitStream::inject(const char *line, int length)
+{
+    if ((_rxLength + length + 1) > WIT_STREAM_RX_BUFFER_SIZE) _processLines();
+    if ((_rxLength + length + 1) > WIT_STREAM_RX_BUFFER_SIZE) return false;
+
+    memcpy(_rxBuffer + _rxLength, line, length);
+    _rxBuffer[_rxLength + length] = '\n';
+    _rxLength += length + 1;
+    _lastReceiveTime = millis();
+    _processLines();
+    return true;
+}
+
+void WitStream::poll()
+{
+    if (_client == NULL) return;
+
+    if (_rxLength > 0) _processLines();   // anything left over from last time, now that the library has read its lines
+
+    int waiting = _client->available();
+    while (waiting > 0) {
+        int space = WIT_STREAM_RX_BUFFER_SIZE - _rxLength;
+        if (space <= 0) break;   // the library has not caught up yet
+
+        int toRead = (waiting < space) ? waiting : space;
+        int received = _client->readBytes(_rxBuffer + _rxLength, toRead);
+        if (received <= 0) break;
+
+        _rxLength += received;
+        _bytesReceived += received;
+        _lastReceiveTime = millis();
+
+        _processLines();
+        waiting = _client->available();
+    }
+}
+
+// returns the number of bytes removed from the receive buffer
+int WitStream::_processLines()
+{
+    int start = 0;
+    bool stalled = false;
+
+    for (int i = 0; i < _rxLength; i++) {
+        char c = _rxBuffer[i];
+        if ((c != '\n') && (c != '\r')) continue;
+
+        int length = i - start;
+        if (_rxOverflow) {                  // end of a line that was too long for the buffer
+            if (!_passthrough(_rxBuffer + start, length + 1)) {
+                int free = _passthroughFree();  // pass on what we can of it now
+                _passthrough(_rxBuffer + start, free);
+                start += free;
+                stalled = true; 
+                break; 
+            }
+            _rxOverflow = false;
+            _passthroughLineCount++;
+
+        } else if (length > 0) {
+            // only handle lines directly if the library has nothing older still waiting, so the order is kept
+            if ((_lineHandler != NULL) && (_passCount == 0) && (_lineHandler(_rxBuffer + start, length))) {
+                _handledLineCount++;
+            } else {
+                if (!_passthrough(_rxBuffer + start, length + 1)) { stalled = true; break; }  // include the line end
+                _passthroughLineCount++;
+            }
+            if (_lineRecorder != NULL) _lineRecorder(_rxBuffer + start, length);
+        }
+        start = i + 1;
+    }
+
+    if (!stalled && (_rxOverflow || ((start == 0) && (_rxLength == WIT_STREAM_RX_BUFFER_SIZE)))) {
+        // no line end in the buffer and it is full (or already overflowing). Pass on what we can
+        int free = _passthroughFree();
+        int toPass = ((_rxLength - start) < free) ? (_rxLength - start) : free;
+        if (toPass > 0) {
+            _passthrough(_rxBuffer + start, toPass);
+            start += toPass;
+            _rxOverflow = true;
+        }
+    }
+
+    if (start > 0) {
+        memmove(_rxBuffer, _rxBuffer + start, _rxLength - start);
+        _rxLength -= start;
+    }
+    return start;
+}
+
+bool WitStream::_passthrough(const char *data, int length)
+{
+    if (length > _passthroughFree()) return false;
+
+    int tail = (_passHead + _passCount) % WIT_STREAM_PASSTHROUGH_SIZE;
+    for (int i = 0; i < length; i++) {
+        _passBuffer[tail] = data[i];
+        tail++;
+        if (tail == WIT_STREAM_PASSTHROUGH_SIZE) tail = 0;
+    }
+    _passCount += length;
+    return true;
+}
+
+int WitStream::_passthroughFree()
+{
+    return WIT_STREAM_PASSTHROUGH_SIZE - _passCount;
+}
+
+unsigned long WitStream::getLastReceiveTime()
+{
+    return _lastReceiveTime;
+}
+
+unsigned long WitStream::getHandledLineCount()
+{
+    return _handledLineCount;
+}
+
+unsigned long WitStream::getPassthroughLineCount()
+{
+    return _passthroughLineCount;
+}
+
+unsigned long WitStream::getBytesReceived()
+{
+    return _bytesReceived;
+}
+
+unsigned long WitStream::getSegmentsSent()
+{
+    return _segmentsSent;
+}
+
+unsigned long WitStream::getBytesSent()
+{
+    return _bytesSent;
+}
+
+int WitStream::available()
+{
+    return _passCount;
+}
+
+int WitStream::read()
+{
+    if (_passCount == 0) return -1;
+    unsigned char c = _passBuffer[_passHead];
+    _passHead++;
+    if (_passHead == WIT_STREAM_PASSTHROUGH_SIZE) _passHead = 0;
+    _passCount--;
+    return c;
+}
+
+int WitStream::peek()
+{
+    if (_passCount == 0) return -1;
+    return (unsigned char) _passBuffer[_passHead];
+}
+
+size_t WitStream::write(uint8_t b)
+{
+    if (_capture != NULL) {
+        *_capture += (char) b;
+        return 1;
+    }
+    if (_client == NULL) return 0;
+    if (_txLength >= WIT_STREAM_TX_BUFFER_SIZE) flushWrites();
+    if (_txLength >= WIT_STREAM_TX_BUFFER_SIZE) return 0;   // the client is not taking anything
+    _txBuffer[_txLength] = b;
+    _txLength++;
+    return 1;
+}
+
+size_t WitStream::write(const uint8_t *buffer, size_t size)
+{
+    if (_capture != NULL) {
+        for (size_t i = 0; i < size; i++) *_capture += (char) buffer[i];
+        return size;
+    }
+    if (_client == NULL) return 0;
+    size_t done = 0;
+    while (done < size) {
+        if (_txLength >= WIT_STREAM_TX_BUFFER_SIZE) flushWrites();
+        if (_txLength >= WIT_STREAM_TX_BUFFER_SIZE) return done;   // the client is not taking anything
+        size_t chunk = WIT_STREAM_TX_BUFFER_SIZE - _txLength;
+        if (chunk > (size - done)) chunk = size - done;
+        memcpy(_txBuffer + _txLength, buffer + done, chunk);
+        _txLength += chunk;
+        done += chunk;
+    }
+    return size;
+}
+
+int WitStream::flushWrites()
+{
+    if ((_client == NULL) || (_txLength == 0)) return 0;
+    int sent = _client->write((const uint8_t *) _txBuffer, _txLength);
+    if (sent <= 0) return 0;   // try again next time
+    _segmentsSent++;
+    _bytesSent += sent;
+    if (sent < _txLength) {    // the client could not take it all. Keep the rest for the next flush
+        memmove(_txBuffer, _txBuffer + sent, _txLength - sent);
+    }
+    _txLength -= sent;
+    return sent;
+}
+
+void WitStream::capture(String *into)
+{
+    _capture = into;
+}
+
+void WitStream::flush()
+{
+    flushWrites();
+}
@@ -0,0 +1,125 @@
+/*
+ *  WitStream
+ *
+ * A Stream that sits between the WiThrottleProtocol library and the WiFiClient.
+ *
+ * Inbound data is read from the client in bulk and split into lines.  Each complete line
+ * is offered to a line handler first (e.g. to parse the frequent messages directly, in place).
+ * Lines the handler does not want are queued for the library, which reads them as normal
+ * through available()/read().
+ *
+ * Outbound data is held until flushWrites() is called, so that everything written in one
+ * loop goes to the client in a single write (one TCP segment) instead of one per command.
+ */
+
+#ifndef WitStream_h
+#define WitStream_h
+
+#include "Arduino.h"
+
+#ifndef WIT_STREAM_RX_BUFFER_SIZE
+  #define WIT_STREAM_RX_BUFFER_SIZE 4096     // longest line that can be handled in place
+#endif
+#ifndef WIT_STREAM_PASSTHROUGH_SIZE
+  #define WIT_STREAM_PASSTHROUGH_SIZE 2048   // lines waiting for the library
+#endif
+#ifndef WIT_STREAM_TX_BUFFER_SIZE
+  #define WIT_STREAM_TX_BUFFER_SIZE 1024     // written early if it fills
+#endif
+
+// return true if the line was dealt with, false to pass it on to the library
+// the line is NOT null terminated
+typedef bool (*WitStreamLineHandler)(const char* line, int length);
+
+class WitStream : public Stream {
+  public:
+    WitStream();
+
+    /*
+     * @param client, the connected stream (normally the WiFiClient)
+     */
+    void begin(Stream *client);
+    void setLineHandler(WitStreamLineHandler lineHandler);
+
+    /*
+     * Called with every complete line once it has been dealt with (e.g. to record the session).
+     * The return value is ignored. Lines too long for the receive buffer are not passed on
+     */
+    void setLineRecorder(WitStreamLineHandler lineRecorder);
+
+    /*
+     * Process a line as if it had been received from the client (e.g. replaying a recorded session).
+     * The line end is added. Works without a client.
+     * @return false if there was no room for it
+     */
+    bool inject(const char *line, int length);
+
+    /*
+     * Read whatever is waiting on the client and process any complete lines.
+     * Call once per loop, before the library's check()
+     */
+    void poll();
+
+    /*
+     * Send everything written since the last call to the client in one write.
+     * Call once per loop, and straight away for anything urgent (E Stop)
+     * Anything the client does not take is kept, in order, for the next call
+     * @return the number of bytes sent
+     */
+    int flushWrites();
+
+    /*
+     * While capturing, anything written is added to the string instead of being sent,
+     * e.g. so a command the library formats can be queued and sent later.
+     * @param into, where to add it. NULL to stop capturing
+     */
+    void capture(String *into);
+
+    // time (millis) that anything was last received from the server
+    unsigned long getLastReceiveTime();
+
+    // statistics since begin()
+    unsigned long getHandledLineCount();
+    unsigned long getPassthroughLineCount();
+    unsigned long getBytesReceived();
+    unsigned long getSegmentsSent();
+    unsigned long getBytesSent();
+
+    // Stream
+    int available();
+    int read();
+    int peek();
+    size_t write(uint8_t b);
+    size_t write(const uint8_t *buffer, size_t size);
+    void flush();     // same as flushWrites(). Does NOT discard unread input like WiFiClient::flush()
+
+  private:
+    Stream *_client;
+    WitStreamLineHandler _lineHandler;
+    WitStreamLineHandler _lineRecorder;
+
+    char   _rxBuffer[WIT_STREAM_RX_BUFFER_SIZE];
+    int    _rxLength;
+    bool   _rxOverflow;                // current line is too long, so pass it through as it arrives
+
+    char   _passBuffer[WIT_STREAM_PASSTHROUGH_SIZE];
+    int    _passHead;
+    int    _passCount;
+
+    char   _txBuffer[WIT_STREAM_TX_BUFFER_SIZE];
+    int    _txLength;
+    String *_capture;
+
+    unsigned long _lastReceiveTime;
+    unsigned long _handledLineCount;
+    unsigned long _passthroughLineCount;
+    unsigned long _bytesReceived;
+    unsigned long _segmentsSent;
+    unsigned long _bytesSent;
+
+    int    _processLines();
+    bool   _passthrough(const char *data, int length);
+    int    _passthroughFree();
+};
+
+#endif
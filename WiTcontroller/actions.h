@@ -66,6 +66,8 @@
 
 #define SLEEP 505
 
+#define DIAGNOSTICS 506   // round trip times, signal strength and reconnections
+
 #define NEXT_THROTTLE 510
 #define THROTTLE_1 511
 #define THROTTLE_2 512
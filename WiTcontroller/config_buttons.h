@@ -36,6 +36,11 @@
 // increase if you find the encoder buttons bounce (activate twice) or you get speed changes when you press the encoder button
 #define ROTARY_ENCODER_DEBOUNCE_TIME     200
 
+// Rotary Encoder acceleration
+// detents turned faster than this (per second) change the speed by the 'fast' speed step (SPEED_STEP_MULTIPLIER)
+// decrease it if it is too hard to get the fast steps, increase it if you get them when you don't want them
+// #define ENCODER_FAST_DETENTS_PER_SECOND   25
+
 // If using a bare Rotary Encoder instead of a KY040 encoder module
 // Internal GPIO pullups required if the hardware build utilises a bare EC11 rotary encoder in place of a
 // KY040 encoder module. (The encoder module has physical pullups fitted)
@@ -94,11 +99,15 @@
 // Define the number of throttles that you want.
 // To use multiple throttles, one of the keys or buttons will need to be defined as 
 // NEXT_THROTTLE.  (keypad 5 is by default)
-// Maximum supported by the WiTcontroller is 6
+// Maximum is set by THROTTLE_POOL_SIZE (below)
 
 // uncomment and increase the number if you always need more that two throttles
 // #define MAX_THROTTLES                 2 
 
+// Memory is reserved for this many throttles. '#Throttles +' can't go above it.
+// Default is 6.  Can be 1 to 10.  Reduce it (e.g. 2) to save memory if you never use more throttles
+// #define THROTTLE_POOL_SIZE            6
+
 // *******************************************************************************************************************
 // speed increase for each click of the encoder 
 
@@ -114,6 +123,22 @@
 // The default is 2
 // #define SPEED_STEP_ADDITIONAL_MULTIPLIER 2
 
+// *******************************************************************************************************************
+// momentum
+
+// Uncomment to have the speed change gradually towards the speed set by the encoder, pot or keys,
+// rather than jumping to it straight away.  E Stop always stops immediately.
+// #define USE_MOMENTUM                     true
+
+// How fast the speed increases and decreases, in speed steps (0-126) per second
+// The defaults are 20 and 40
+// #define MOMENTUM_ACCELERATION            20
+// #define MOMENTUM_BRAKING                 40
+
+// Minimum time (milliseconds) between speed commands sent while the speed is changing
+// The default is 100
+// #define MOMENTUM_COMMAND_INTERVAL        100
+
 // by default, the speed will be displayed as the the DCC speed (0-126)
 // IMPORTANT: only one should be enabled.  If DISPLAY_SPEED_AS_PERCENT is enabled it 
 // will take presidence over DISPLAY_SPEED_AS_0_TO_28
@@ -173,6 +198,11 @@
 // This is one of the common 1.3 inch OLED displays
 // #define OLED_TYPE U8G2_SH1106_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, /* reset=*/ U8X8_PIN_NONE, /* clock=*/ 22, /* data=*/ 23);
 
+// Send the display buffer to the oLED from a separate task on the other core, so the main loop does not wait 
+// on the I2C bus (about 25ms per frame at 400kHz). The frame is copied into one of two buffers and handed over.
+// Only for the full frame buffer (_F_) constructors up to 128x64.  Disabled by default
+// #define USE_ASYNC_DISPLAY true
+
 // *******************************************************************************************************************
 // Debugging
 
@@ -189,6 +219,44 @@
 // 0 = errors only 1 = default level 2 = verbose 3 = extreme
 // #define DEBUG_LEVEL    1
 
+// the level can also be set for some parts on their own. They default to DEBUG_LEVEL
+// the messages for every speed step and message received are only included at level 2 (verbose)
+// #define LOG_LEVEL_THROTTLE    1      // speed, direction and momentum
+// #define LOG_LEVEL_SERVER      1      // speed, direction and function messages from the server
+// #define LOG_LEVEL_INPUT       1      // throttle pot, encoder and buttons
+
+// console messages are queued and written by a separate low priority task, so the loop doesn't wait on the serial port
+// to write them straight away instead (e.g. if the WiTcontroller crashes before the message shows), set to false
+// #define ASYNC_LOG    true
+
+// Latency benchmark.  Measures the time from a keypad press, encoder click or additional button press 
+// to the command being written to the server (wire) and to the oLED being updated (pixel).
+// Scenarios are: speed up, E Stop, function, consist reverse, throttle switch.
+// The p50 and p99 (in microseconds) for each scenario are printed to the console every 
+// LATENCY_BENCHMARK_REPORT_INTERVAL milliseconds (default 30 seconds) if there are new samples.
+// Only the most recent LATENCY_BENCHMARK_SAMPLES (default 64) samples for each scenario are kept.
+// Disabled by default
+// #define LATENCY_BENCHMARK true
+// #define LATENCY_BENCHMARK_SAMPLES 64
+// #define LATENCY_BENCHMARK_REPORT_INTERVAL 30000
+
+// Session recorder.  Writes every line received from the server and every keypad, encoder 
+// and additional button input, with its time, to the console as '#REC ...' lines.
+// A recorded session can be sent back to replay it, either while connected or with no server,
+// and the time spent in each part of the loop is reported at the end.
+// Use tools/session_replay.py to record to a file and to replay it.
+// With roaming enabled (see config_network.h) the RSSI samples are recorded too, and replayed in place 
+// of the measured RSSI.  '#RSSI -80' sent on the console also sets it ('#RSSI OFF' to stop).
+// See config_network.h for '#RSSI' with a second value.
+// Disabled by default
+// #define SESSION_RECORDER true
+
+// Serial API.  Commands sent on the console to press keys, turn the encoder, do any action
+// and to read the throttles, locos, speeds, functions and metrics. e.g. '#ACTION 502', '#GET THROTTLES'.
+// The full list is at 'Serial API' in WiTcontroller.ino.  Use tools/serial_scenario.py to run a list of them.
+// Disabled by default
+// #define SERIAL_API true
+
 // *******************************************************************************************************************
 // Default function labels
 
@@ -451,13 +519,20 @@
 // *******************************************************************************************************************
 // Translations
 
-// Uncomment the appropriate line to change the language displayed.
+// All the languages are included, and the language can be changed on the device 
+// from the Extras menu (*9 then 2).  The choice is remembered.
+//
+// Uncomment the appropriate line to change the language used until one is chosen.
+// This also uses that language's labels for the keys and functions.
 // If you wish to override any of the translations you can do so individually here,
-// but, the define(s) must done before the #include of the base langauge file
+// using the DE_... or IT_... names, but, the define(s) must done before the #include 
+// of the base langauge file
 //
 //
 // German - Deutsche
 // #include "language_deutsch.h"
+// Italian - Italiano
+// #include "language_italiano.h"
 
 // *******************************************************************************************************************
 // Startup Commands
@@ -507,6 +582,31 @@
 
 // #define RESTORE_ACQUIRED_LOCOS false
 
+// If this option is enabled the acquired locos are saved automatically whenever they change
+// (checked every AUTO_SAVE_ACQUIRED_LOCOS_INTERVAL milliseconds), instead of only with # -> 9 -> 9.
+// Nothing is written if the locos are the same as what is already saved.
+//
+// disabled by default
+
+// #define AUTO_SAVE_ACQUIRED_LOCOS true
+// #define AUTO_SAVE_ACQUIRED_LOCOS_INTERVAL 2000
+
+// ***************************************************
+// Fast resume from sleep
+
+// When the device goes to sleep while connected, the network, server, acquired locos, 
+// directions, functions, speed step and current throttle are kept in the ESP32's RTC memory.
+// Waking with the encoder button then reconnects to the same network and server and goes straight 
+// back to the throttle screen, without browsing or reading the saved locos.
+// The speeds are not restored, they are read back from the server.
+// The snapshot is lost if the power is removed.
+// Note: the Wi-Fi password is kept in the RTC memory (as plain text) while the device is asleep.
+// It is cleared once the device has woken and reconnected.
+//
+// enabled by default
+
+// #define USE_FAST_RESUME false
+
 // *******************************************************************************************************************
 // Primary Font override (not recommended)
 
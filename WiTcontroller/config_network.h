@@ -44,6 +44,40 @@ const String routePrefixes[maxSsids] = {"IO:AUTO:", "IO:AUTO:", "IO:AUTO:", "IO:
 // If you are having problems connection to you network, try uncommenting the line increasing this
 // #define SSID_CONNECTION_TIMEOUT 10000
 
+// The scan for networks runs in the background.  The channel that each of the SSIDs above was last
+// found on is remembered, and when browsing starts (other than by pressing # on the list of SSIDs) only 
+// those channels are scanned. If none of the SSIDs above are found there, all the channels are scanned.
+// Uncomment to always scan all the channels
+// #define SSID_FAST_SCAN_KNOWN_CHANNELS false
+
+// Time in milliseconds spent listening on each channel when scanning.  Default is 300
+// #define SSID_SCAN_TIME_PER_CHANNEL 300
+
+// ********************************************************************************************
+
+// Roaming.  For layouts with several access points with the same SSID.
+// While connected the signal strength (RSSI) is checked every second.  When it falls below 
+// ROAMING_PRESCAN_RSSI the other access points are scanned for in the background.  If it then falls below 
+// ROAMING_RSSI_THRESHOLD (or nothing has been heard from the server for ROAMING_SILENT_TIME) and another 
+// access point is at least ROAMING_RSSI_MARGIN stronger, the WiTcontroller moves to it, keeping its 
+// connection to the server, so the session and the acquired locos are kept.  Commands are held while it moves.
+// If the new access point can't be joined within ROAMING_CONNECTION_TIMEOUT ms (default 4000), the 
+// IP address changes, or the connection to the server is lost, it reconnects to the server instead, which
+// ends the session there, the same as any throttle disconnecting: the server releases the locos, and some 
+// (e.g. DCC-EX) stop them.  The locos are then acquired again, and the WiTcontroller sends the speeds and 
+// directions they had before the move.  If the access point can't be joined in two more tries of 
+// ROAMING_CONNECTION_TIMEOUT ms the SSID selection is shown again.
+// Disabled by default
+// #define ROAMING_ENABLED true
+// #define ROAMING_RSSI_THRESHOLD -72
+// #define ROAMING_PRESCAN_RSSI -67
+// #define ROAMING_RSSI_MARGIN 8
+// #define ROAMING_SILENT_TIME 5000
+// #define ROAMING_CONNECTION_TIMEOUT 4000
+// The RSSI can be fed in over the serial console for testing, with '#RSSI <dBm>' (see SERIAL_API and 
+// SESSION_RECORDER in config_buttons.h).  '#RSSI -80 -60' also offers the current access point as a 
+// stronger one, so a whole move can be tried with only one access point.
+
 // ********************************************************************************************
 
 // Autoconnect to first SSID in the list above (default, if not specified is false)
@@ -54,13 +88,65 @@ const String routePrefixes[maxSsids] = {"IO:AUTO:", "IO:AUTO:", "IO:AUTO:", "IO:
 
 // ********************************************************************************************
 
-// Minimum time spacing in milliseconds for commands sent.  
+// Minimum time spacing in milliseconds for commands sent, including acquiring and releasing locos.  
 // Default is 50 
 // uncomment and increase this value  if the command station is skipping some commands
 // Probably Not advisable to set to more than 500
 
 // #define OUTBOUND_COMMANDS_MINIMUM_DELAY 200
 
+// Commands waiting for the minimum spacing above are held in a queue for each priority class
+// (E Stop, Speed/Direction, Functions, then Turnouts/Routes/everything else).
+// E Stops are never queued.  Default is 16 commands per class.  If a class is full, its oldest command is dropped.
+// uncomment and increase this value only if you see 'outbound queue full' in the debug output
+
+// #define OUTBOUND_QUEUE_SIZE 16
+
+// Locos being acquired (from the menu, the roster or the saved locos) are sent to the server one command at a time,
+// after any speed, direction and function commands, and the screen is redrawn once the server has answered for every loco, 
+// or has sent nothing for ACQUIRE_SETTLE_TIME milliseconds (default 200),
+// or ACQUIRE_SETTLE_MAX milliseconds (default 3000) after the last was sent, whichever is first.
+// The number of locos and the locos per second are shown in the debug output,
+// and the last batch as acquire_locos and acquire_ms in the serial API's  #GET METRICS
+
+// #define ACQUIRE_SETTLE_TIME 200
+// #define ACQUIRE_SETTLE_MAX 3000
+
+// ********************************************************************************************
+
+// The most frequent messages from the server (speed, function states, roster/turnout/route lists)
+// are read directly by the WiTcontroller rather than by the WiThrottle Protocol library.
+// Uncomment and set to false if you suspect this is causing a problem with your server.
+
+// #define WIT_STREAM_FAST_PARSE false
+
+// ********************************************************************************************
+
+// When connected to a DCC-EX EX-CommandStation, send the throttle commands (speed, direction,
+// functions, power, turnouts, routes) as native DCC-EX commands  e.g. <t 3 50 1>
+// instead of as WiThrottle commands that the command station has to translate.
+// The WiThrottle protocol is still used for everything else (acquiring locos, roster, etc.)
+// Note: the native commands do not say which functions are latching, so each press of a function toggles it,
+// except for momentary functions, which are on while the key is held.  A function is momentary if its label 
+// starts with '*' (as in the DCC-EX roster) or it is in DCC_EX_MOMENTARY_FUNCTIONS (one bit per function. Default is F2, the horn)
+// Disabled by default.  Has no effect on other servers.
+
+// #define USE_DCC_EX_NATIVE_PROTOCOL true
+// #define DCC_EX_MOMENTARY_FUNCTIONS ((1UL<<2) | (1UL<<3))
+
+// ********************************************************************************************
+
+// Metrics.  Sends a small UDP datagram (about 150 bytes) every few seconds with the loop timings, heap, 
+// round trip times, RSSI, battery, reconnections and command counts, so the handsets in use at a session
+// can be watched together.  Use tools/metrics_collector.py on a computer on the same network to see them.
+// Sent to the network broadcast address unless METRICS_UDP_HOST is set to the IP address of the computer.
+// Disabled by default
+
+// #define METRICS_UDP true
+// #define METRICS_UDP_HOST "192.168.1.10"
+// #define METRICS_UDP_PORT 12095
+// #define METRICS_UDP_INTERVAL 5000
+
 // ********************************************************************************************
 
 // For some reason WifiTrax WFD-30 system don't respond unless the commands are preceeded with CR+LF
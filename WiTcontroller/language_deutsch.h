@@ -1,254 +1,283 @@
+//
+// German - Deutsche
+//
+// The menu and message text is compiled into the language tables (language_tables.h) 
+// and the language can be chosen on the device from the Extras menu.
+// Individual texts can be overridden by defining the DE_... name in config_buttons.h
+//
+// The key and function labels at the end are only used if this file is included
+// in config_buttons.h, which also makes this the default language.
 
-#ifndef MENU_TEXT_MENU
-  #define MENU_TEXT_MENU                                "* Menü     # Tastendefinitionen"               // "* Menu # Key Defs"
+#ifndef LANGUAGE_DEUTSCH_H
+#define LANGUAGE_DEUTSCH_H
+
+#ifndef DE_MENU_TEXT_MENU
+  #define DE_MENU_TEXT_MENU                             "* Menü     # Tastendefinitionen"               // "* Menu # Key Defs"
 #endif
-#ifndef MENU_TEXT_MENU_HASH_IS_FUNCTIONS
-  #define MENU_TEXT_MENU_HASH_IS_FUNCTIONS              "* Menü                          # Fn"          // "* Menu # Fn"
+#ifndef DE_MENU_TEXT_MENU_HASH_IS_FUNCTIONS
+  #define DE_MENU_TEXT_MENU_HASH_IS_FUNCTIONS           "* Menü                          # Fn"          // "* Menu # Fn"
 #endif
-#ifndef MENU_TEXT_FINISH
-  #define MENU_TEXT_FINISH                              "                       # Beenden"              // "# Finish"
+#ifndef DE_MENU_TEXT_FINISH
+  #define DE_MENU_TEXT_FINISH                           "                       # Beenden"              // "# Finish"
 #endif
-#ifndef MENU_TEXT_CANCEL
-  #define MENU_TEXT_CANCEL                              "* Abbrechen"                                   // "* Cancel"
+#ifndef DE_MENU_TEXT_CANCEL
+  #define DE_MENU_TEXT_CANCEL                           "* Abbrechen"                                   // "* Cancel"
 #endif
-#ifndef MENU_TEXT_SHOW_DIRECT
-  #define MENU_TEXT_SHOW_DIRECT                         "              # Direkt anzeigen"               // "# Show Direct"
+#ifndef DE_MENU_TEXT_SHOW_DIRECT
+  #define DE_MENU_TEXT_SHOW_DIRECT                      "              # Direkt anzeigen"               // "# Show Direct"
 #endif
-#ifndef MENU_TEXT_ROSTER
-  #define MENU_TEXT_ROSTER                              "* Abbrechen   0-9   #Seite"                    // "* Cancel 0-9 #Pg"
+#ifndef DE_MENU_TEXT_ROSTER
+  #define DE_MENU_TEXT_ROSTER                           "* Abbrechen   0-9   #Seite"                    // "* Cancel 0-9 #Pg"
 #endif
-#ifndef MENU_TEXT_TURNOUT_LIST
-  #define MENU_TEXT_TURNOUT_LIST                        "* Abbrechen   0-9   #Seite"                    // "* Cancel 0-9 #Pg"
+#ifndef DE_MENU_TEXT_TURNOUT_LIST
+  #define DE_MENU_TEXT_TURNOUT_LIST                     "* Abbrechen   0-9   #Seite"                    // "* Cancel 0-9 #Pg"
 #endif
-#ifndef MENU_TEXT_ROUTE_LIST
-  #define MENU_TEXT_ROUTE_LIST                          "* Abbrechen   0-9   #Seite"                    // "* Cancel 0-9 #Pg"
+#ifndef DE_MENU_TEXT_ROUTE_LIST
+  #define DE_MENU_TEXT_ROUTE_LIST                       "* Abbrechen   0-9   #Seite"                    // "* Cancel 0-9 #Pg"
 #endif
-#ifndef MENU_TEXT_FUNCTION_LIST
-  #define MENU_TEXT_FUNCTION_LIST                       "* Abbrechen   0-9   #Seite"                    // "* Cancel 0-9 #Pg"
+#ifndef DE_MENU_TEXT_FUNCTION_LIST
+  #define DE_MENU_TEXT_FUNCTION_LIST                    "* Abbrechen   0-9   #Seite"                    // "* Cancel 0-9 #Pg"
 #endif
-#ifndef MENU_TEXT_SELECT_WIT_SERVICE
-  #define MENU_TEXT_SELECT_WIT_SERVICE                  "0-4       # andere IP       @ AUS"             // "0-4 # Entry E.btn OFF"
+#ifndef DE_MENU_TEXT_SELECT_WIT_SERVICE
+  #define DE_MENU_TEXT_SELECT_WIT_SERVICE               "0-4       # andere IP       @ AUS"             // "0-4 # Entry E.btn OFF"
 #endif
-#ifndef MENU_TEXT_SELECT_WIT_ENTRY
-  #define MENU_TEXT_SELECT_WIT_ENTRY                    "0-9  * Entf  # Verbinde  @ AUS"                // "0-9 * Back # Go E.btn OFF"
+#ifndef DE_MENU_TEXT_SELECT_WIT_ENTRY
+  #define DE_MENU_TEXT_SELECT_WIT_ENTRY                 "0-9  * Entf  # Verbinde  @ AUS"                // "0-9 * Back # Go E.btn OFF"
 #endif
-#ifndef MENU_TEXT_SELECT_SSIDS
-  #define MENU_TEXT_SELECT_SSIDS                        "0-9         # Suche         @ AUS"             // "0-9 # Search E.btn OFF"
+#ifndef DE_MENU_TEXT_SELECT_SSIDS
+  #define DE_MENU_TEXT_SELECT_SSIDS                     "0-9         # Suche         @ AUS"             // "0-9 # Search E.btn OFF"
 #endif
-#ifndef MENU_TEXT_SELECT_SSIDS_FROM_FOUND
-  #define MENU_TEXT_SELECT_SSIDS_FROM_FOUND             "0-4  9 Liste  # Seite  @ AUS"                  // "0-4 9 List # Pg E.btn OFF"
+#ifndef DE_MENU_TEXT_SELECT_SSIDS_FROM_FOUND
+  #define DE_MENU_TEXT_SELECT_SSIDS_FROM_FOUND          "0-4  9 Liste  # Seite  @ AUS"                  // "0-4 9 List # Pg E.btn OFF"
 #endif
-#ifndef MENU_TEXT_ENTER_SSID_PASSWORD
-  #define MENU_TEXT_ENTER_SSID_PASSWORD                 "E Bchst @ Ausw # Verb * Zur."                  // "E Chrs E.btn Slct # Go * Bck"
+#ifndef DE_MENU_TEXT_ENTER_SSID_PASSWORD
+  #define DE_MENU_TEXT_ENTER_SSID_PASSWORD              "E Bchst @ Ausw # Verb * Zur."                  // "E Chrs E.btn Slct # Go * Bck"
 #endif
 
 
-#ifndef DIRECT_COMMAND_LIST
-  #define DIRECT_COMMAND_LIST                           "Direkte Befehle"                               // "Direct Commands"
+#ifndef DE_DIRECT_COMMAND_LIST
+  #define DE_DIRECT_COMMAND_LIST                        "Direkte Befehle"                               // "Direct Commands"
 #endif
-#ifndef DIRECTION_FORWARD_TEXT
-  #define DIRECTION_FORWARD_TEXT                        "Vorw"                                          // "Fwd"
+#ifndef DE_DIRECTION_FORWARD_TEXT
+  #define DE_DIRECTION_FORWARD_TEXT                     "Vorw"                                          // "Fwd"
 #endif
-#ifndef DIRECTION_REVERSE_TEXT
-  #define DIRECTION_REVERSE_TEXT                        "Rückw"                                         // "Rev"
+#ifndef DE_DIRECTION_REVERSE_TEXT
+  #define DE_DIRECTION_REVERSE_TEXT                     "Rückw"                                         // "Rev"
 #endif
 
 
-#ifndef MSG_START
-  #define MSG_START                                     "Start"                                         // "Start"
+#ifndef DE_MSG_START
+  #define DE_MSG_START                                  "Start"                                         // "Start"
 #endif
-#ifndef MSG_BROWSING_FOR_SERVICE
-  #define MSG_BROWSING_FOR_SERVICE                      "Suche nach WiT-Diensten"                       // "Browsing for WiT services"
+#ifndef DE_MSG_BROWSING_FOR_SERVICE
+  #define DE_MSG_BROWSING_FOR_SERVICE                   "Suche nach WiT-Diensten"                       // "Browsing for WiT services"
 #endif
-#ifndef MSG_BROWSING_FOR_SSIDS
-  #define MSG_BROWSING_FOR_SSIDS                        "Suche nach SSIDs"                              // "Browsing for SSIDs"
+#ifndef DE_MSG_BROWSING_FOR_SSIDS
+  #define DE_MSG_BROWSING_FOR_SSIDS                     "Suche nach SSIDs"                              // "Browsing for SSIDs"
 #endif
-#ifndef MSG_NO_SSIDS_FOUND
-  #define MSG_NO_SSIDS_FOUND                            "Keine SSIDs gefunden"                          // "No SSIDs found"
+#ifndef DE_MSG_NO_SSIDS_FOUND
+  #define DE_MSG_NO_SSIDS_FOUND                         "Keine SSIDs gefunden"                          // "No SSIDs found"
 #endif
-#ifndef MSG_SSIDS_LISTED
-  #define MSG_SSIDS_LISTED                              " bekannte SSIDs"                               // "SSIDs listed"
+#ifndef DE_MSG_SSIDS_LISTED
+  #define DE_MSG_SSIDS_LISTED                           " bekannte SSIDs"                               // "SSIDs listed"
 #endif
-#ifndef MSG_SSIDS_FOUND
-  #define MSG_SSIDS_FOUND                               "  SSIDs gefunden"                              // "SSIDs found"
+#ifndef DE_MSG_SSIDS_FOUND
+  #define DE_MSG_SSIDS_FOUND                            "  SSIDs gefunden"                              // "SSIDs found"
 #endif
-#ifndef MSG_BOUNJOUR_SETUP_FAILED
-  #define MSG_BOUNJOUR_SETUP_FAILED                     "Kein Listener eingerichtet"                    // "Unable to setup Listener"
+#ifndef DE_MSG_BOUNJOUR_SETUP_FAILED
+  #define DE_MSG_BOUNJOUR_SETUP_FAILED                  "Kein Listener eingerichtet"                    // "Unable to setup Listener"
 #endif
-#ifndef MSG_NO_SERVICES_FOUND
-  #define MSG_NO_SERVICES_FOUND                         "Keine Dienste gefunden"                        // "No services found"
+#ifndef DE_MSG_NO_SERVICES_FOUND
+  #define DE_MSG_NO_SERVICES_FOUND                      "Keine Dienste gefunden"                        // "No services found"
 #endif
-#ifndef MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED
-  #define MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED          "WitServer IP:Port eingeben"                    // "Enter witServer IP:Port"
+#ifndef DE_MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED
+  #define DE_MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED       "WitServer IP:Port eingeben"                    // "Enter witServer IP:Port"
 #endif
-#ifndef MSG_SERVICES_FOUND
-  #define MSG_SERVICES_FOUND                            "Dienst(e) gefunden"                            // "Service(s) found"
+#ifndef DE_MSG_SERVICES_FOUND
+  #define DE_MSG_SERVICES_FOUND                         "Dienst(e) gefunden"                            // "Service(s) found"
 #endif
-#ifndef MSG_TRYING_TO_CONNECT
-  #define MSG_TRYING_TO_CONNECT                         "Versuche zu verbinden"                         // "Trying to Connect"
+#ifndef DE_MSG_TRYING_TO_CONNECT
+  #define DE_MSG_TRYING_TO_CONNECT                      "Versuche zu verbinden"                         // "Trying to Connect"
 #endif
-#ifndef MSG_CONNECTED
-  #define MSG_CONNECTED                                 "             Verbunden"                        // "Connected"
+#ifndef DE_MSG_CONNECTED
+  #define DE_MSG_CONNECTED                              "             Verbunden"                        // "Connected"
 #endif
-#ifndef MSG_CONNECTING
-  #define MSG_CONNECTING                                "             Verbinden..."                     // "Connecting..."
+#ifndef DE_MSG_CONNECTING
+  #define DE_MSG_CONNECTING                             "             Verbinden..."                     // "Connecting..."
 #endif
 
 
-#ifndef MSG_ADDRESS_LABEL
-  #define MSG_ADDRESS_LABEL                             "IP Adresse:"                                   // "IP address:"
+#ifndef DE_MSG_ADDRESS_LABEL
+  #define DE_MSG_ADDRESS_LABEL                          "IP Adresse:"                                   // "IP address:"
 #endif
-#ifndef MSG_CONNECTION_FAILED
-  #define MSG_CONNECTION_FAILED                         "Verbindung fehlgeschlagen"                     // "Connection failed"
+#ifndef DE_MSG_CONNECTION_FAILED
+  #define DE_MSG_CONNECTION_FAILED                      "Verbindung fehlgeschlagen"                     // "Connection failed"
 #endif
-#ifndef MSG_DISCONNECTED
-  #define MSG_DISCONNECTED                              "Getrennt"                                      // "Disconnected"
+#ifndef DE_MSG_DISCONNECTED
+  #define DE_MSG_DISCONNECTED                           "Getrennt"                                      // "Disconnected"
 #endif
-#ifndef MSG_AUTO_SLEEP
-  #define MSG_AUTO_SLEEP                                "Zu lange auf Auswahl gewartet"                 // "Waited too long for Select"
+#ifndef DE_MSG_AUTO_SLEEP
+  #define DE_MSG_AUTO_SLEEP                             "Zu lange auf Auswahl gewartet"                 // "Waited too long for Select"
 #endif
-#ifndef MSG_BATTERY_SLEEP
-  #define MSG_BATTERY_SLEEP                             "Batterie sehr schwach"                         // "Battery critically low"
+#ifndef DE_MSG_BATTERY_SLEEP
+  #define DE_MSG_BATTERY_SLEEP                          "Batterie sehr schwach"                         // "Battery critically low"
 #endif
-#ifndef MSG_START_SLEEP
-  #define MSG_START_SLEEP                               "Herunterfahren.      @ Neustart"               // "Shutting Down. E.btn ON"
+#ifndef DE_MSG_START_SLEEP
+  #define DE_MSG_START_SLEEP                            "Herunterfahren.      @ Neustart"               // "Shutting Down. E.btn ON"
 #endif
-#ifndef MSG_THROTTLE_NUMBER
-  #define MSG_THROTTLE_NUMBER                           "             Regler #"                         // "Throttle #"
+#ifndef DE_MSG_THROTTLE_NUMBER
+  #define DE_MSG_THROTTLE_NUMBER                        "             Regler #"                         // "Throttle #"
 #endif
-#ifndef MSG_NO_LOCO_SELECTED
-  #define MSG_NO_LOCO_SELECTED                          "      Keine Lok ausgewählt"                    // "No Loco selected"
+#ifndef DE_MSG_NO_LOCO_SELECTED
+  #define DE_MSG_NO_LOCO_SELECTED                       "      Keine Lok ausgewählt"                    // "No Loco selected"
 #endif
-#ifndef MSG_ENTER_PASSWORD
-  #define MSG_ENTER_PASSWORD                            "Passwort eingeben"                             // "Enter Password"
+#ifndef DE_MSG_ENTER_PASSWORD
+  #define DE_MSG_ENTER_PASSWORD                         "Passwort eingeben"                             // "Enter Password"
 #endif
-#ifndef MSG_GUESSED_EX_CS_WIT_SERVER
-  #define MSG_GUESSED_EX_CS_WIT_SERVER                  "EX-CS WiT-Server gefunden"                     // "Guessed' EX-CS WiT server"
+#ifndef DE_MSG_GUESSED_EX_CS_WIT_SERVER
+  #define DE_MSG_GUESSED_EX_CS_WIT_SERVER               "EX-CS WiT-Server gefunden"                     // "Guessed' EX-CS WiT server"
 #endif
-#ifndef MSG_BYPASS_WIT_SERVER_SEARCH
-  #define MSG_BYPASS_WIT_SERVER_SEARCH                  "WiT-Serversuche umgehen"                       // "Bypass WiT server search"
+#ifndef DE_MSG_BYPASS_WIT_SERVER_SEARCH
+  #define DE_MSG_BYPASS_WIT_SERVER_SEARCH               "WiT-Serversuche umgehen"                       // "Bypass WiT server search"
 #endif
-#ifndef MSG_NO_FUNCTIONS
-  #define MSG_NO_FUNCTIONS                              "Funktionsliste - Liste leer"                   // "Function List - No Functions"
+#ifndef DE_MSG_NO_FUNCTIONS
+  #define DE_MSG_NO_FUNCTIONS                           "Funktionsliste - Liste leer"                   // "Function List - No Functions"
 #endif
-#ifndef MSG_HEARTBEAT_CHECK_ENABLED
-  #define MSG_HEARTBEAT_CHECK_ENABLED                   "Heartbeat-Prüfung aktiviert"                   // "Heartbeat Check Enabled"
+#ifndef DE_MSG_HEARTBEAT_CHECK_ENABLED
+  #define DE_MSG_HEARTBEAT_CHECK_ENABLED                "Heartbeat-Prüfung aktiviert"                   // "Heartbeat Check Enabled"
 #endif
-#ifndef MSG_HEARTBEAT_CHECK_DISABLED
-  #define MSG_HEARTBEAT_CHECK_DISABLED                  "Heartbeat-Prüfung deaktiviert"                 // "Heartbeat Check Disabled"
+#ifndef DE_MSG_HEARTBEAT_CHECK_DISABLED
+  #define DE_MSG_HEARTBEAT_CHECK_DISABLED               "Heartbeat-Prüfung deaktiviert"                 // "Heartbeat Check Disabled"
 #endif
-#ifndef MSG_RECEIVING_SERVER_DETAILS
-   #define MSG_RECEIVING_SERVER_DETAILS                 "Empfange Daten vom Server"                    // "Getting data from server"
+#ifndef DE_MSG_RECEIVING_SERVER_DETAILS
+   #define DE_MSG_RECEIVING_SERVER_DETAILS              "Empfange Daten vom Server"                    // "Getting data from server"
 #endif
 
-#ifndef MENU_ITEM_TEXT_TITLE_FUNCTION
-  #define MENU_ITEM_TEXT_TITLE_FUNCTION                 "Funktion"                                      // "Function"
+#ifndef DE_MENU_ITEM_TEXT_TITLE_FUNCTION
+  #define DE_MENU_ITEM_TEXT_TITLE_FUNCTION              "Funktion"                                      // "Function"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_ADD_LOCO
-  #define MENU_ITEM_TEXT_TITLE_ADD_LOCO                 "Lok hinzuf."                                   // "Add Loco"
+#ifndef DE_MENU_ITEM_TEXT_TITLE_ADD_LOCO
+  #define DE_MENU_ITEM_TEXT_TITLE_ADD_LOCO              "Lok hinzuf."                                   // "Add Loco"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_DROP_LOCO
-  #define MENU_ITEM_TEXT_TITLE_DROP_LOCO                "Lok entf."                                     // "Drop Loco"
+#ifndef DE_MENU_ITEM_TEXT_TITLE_DROP_LOCO
+  #define DE_MENU_ITEM_TEXT_TITLE_DROP_LOCO             "Lok entf."                                     // "Drop Loco"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION
-  #define MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION         "Richtung we."                                  // "Toggle Dir"
+#ifndef DE_MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION
+  #define DE_MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION      "Richtung we."                                  // "Toggle Dir"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER
-  #define MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER    "Geschw.Multi"                                  // "X Speed Step"
+#ifndef DE_MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER
+  #define DE_MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER "Geschw.Multi"                                  // "X Speed Step"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_THROW_POINT
-  #define MENU_ITEM_TEXT_TITLE_THROW_POINT              "Weiche abzw"                                   // "Throw Point"
+#ifndef DE_MENU_ITEM_TEXT_TITLE_THROW_POINT
+  #define DE_MENU_ITEM_TEXT_TITLE_THROW_POINT           "Weiche abzw"                                   // "Throw Point"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_CLOSE_POINT
-  #define MENU_ITEM_TEXT_TITLE_CLOSE_POINT              "Weiche grad"                                   // "Close Point"
+#ifndef DE_MENU_ITEM_TEXT_TITLE_CLOSE_POINT
+  #define DE_MENU_ITEM_TEXT_TITLE_CLOSE_POINT           "Weiche grad"                                   // "Close Point"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_ROUTE
-  #define MENU_ITEM_TEXT_TITLE_ROUTE                    "Route"                                         // "Route"
+#ifndef DE_MENU_ITEM_TEXT_TITLE_ROUTE
+  #define DE_MENU_ITEM_TEXT_TITLE_ROUTE                 "Route"                                         // "Route"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_TRACK_POWER
-  #define MENU_ITEM_TEXT_TITLE_TRACK_POWER              "Gleis Power"                                   // "Trk Power"
+#ifndef DE_MENU_ITEM_TEXT_TITLE_TRACK_POWER
+  #define DE_MENU_ITEM_TEXT_TITLE_TRACK_POWER           "Gleis Power"                                   // "Trk Power"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_EXTRAS
-  #define MENU_ITEM_TEXT_TITLE_EXTRAS                   "Extras"                                        // "Extras"
+#ifndef DE_MENU_ITEM_TEXT_TITLE_EXTRAS
+  #define DE_MENU_ITEM_TEXT_TITLE_EXTRAS                "Extras"                                        // "Extras"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_HEARTBEAT
-  #define MENU_ITEM_TEXT_TITLE_HEARTBEAT                "Herzschlag"                                    // "Heartbeat"
+#ifndef DE_MENU_ITEM_TEXT_TITLE_HEARTBEAT
+  #define DE_MENU_ITEM_TEXT_TITLE_HEARTBEAT             "Herzschlag"                                    // "Heartbeat"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_EDIT_CONSIST
-  #define MENU_ITEM_TEXT_TITLE_EDIT_CONSIST             "Bearbeite Traktion"                            // "Edit Consist Facing"
+#ifndef DE_MENU_ITEM_TEXT_TITLE_EDIT_CONSIST
+  #define DE_MENU_ITEM_TEXT_TITLE_EDIT_CONSIST          "Bearbeite Traktion"                            // "Edit Consist Facing"
 #endif
 
 
-#ifndef MENU_ITEM_TEXT_MENU_FUNCTION
-  #define MENU_ITEM_TEXT_MENU_FUNCTION                  "Nr+# Wählen  * Abbr  # Liste"                  // "no+# Select * Cancel # List"
+#ifndef DE_MENU_ITEM_TEXT_MENU_FUNCTION
+  #define DE_MENU_ITEM_TEXT_MENU_FUNCTION               "Nr+# Wählen  * Abbr  # Liste"                  // "no+# Select * Cancel # List"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_ADD_LOCO
-  #define MENU_ITEM_TEXT_MENU_ADD_LOCO                  "Adr+# Hinzuf  * Abbr  # Liste"                 // "addr+# Add * Cancel # Roster"
+#ifndef DE_MENU_ITEM_TEXT_MENU_ADD_LOCO
+  #define DE_MENU_ITEM_TEXT_MENU_ADD_LOCO               "Adr+# Hinzuf  * Abbr  # Liste"                 // "addr+# Add * Cancel # Roster"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_DROP_LOCO
-  #define MENU_ITEM_TEXT_MENU_DROP_LOCO                 "Adr+# Entf   * Abbr   # Alle"                  // "addr+# One * Cancel # All"
+#ifndef DE_MENU_ITEM_TEXT_MENU_DROP_LOCO
+  #define DE_MENU_ITEM_TEXT_MENU_DROP_LOCO              "Adr+# Entf   * Abbr   # Alle"                  // "addr+# One * Cancel # All"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_DROP_LOCO_BYINDEX
-  #define MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX        "Nr+# Entf   * Abbr   # Alle"                   // "no+# One * Cancel # All"
+#ifndef DE_MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX
+  #define DE_MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX     "Nr+# Entf   * Abbr   # Alle"                   // "no+# One * Cancel # All"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_TOGGLE_DIRECTION
-  #define MENU_ITEM_TEXT_MENU_TOGGLE_DIRECTION          "# Umschalten"                                  // "# Toggle"
+#ifndef DE_MENU_ITEM_TEXT_MENU_TOGGLE_DIRECTION
+  #define DE_MENU_ITEM_TEXT_MENU_TOGGLE_DIRECTION       "# Umschalten"                                  // "# Toggle"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_SPEED_STEP_MULTIPLIER
-  #define MENU_ITEM_TEXT_MENU_SPEED_STEP_MULTIPLIER     "* Abbrechen      # Umschalten"                 // "* Cancel # Toggle"
+#ifndef DE_MENU_ITEM_TEXT_MENU_SPEED_STEP_MULTIPLIER
+  #define DE_MENU_ITEM_TEXT_MENU_SPEED_STEP_MULTIPLIER  "* Abbrechen      # Umschalten"                 // "* Cancel # Toggle"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_THROW_POINT
-  #define MENU_ITEM_TEXT_MENU_THROW_POINT               "Nr+# abzweig  * Abbr  # Liste"                 // "no+# Throw * Cancel # List"
+#ifndef DE_MENU_ITEM_TEXT_MENU_THROW_POINT
+  #define DE_MENU_ITEM_TEXT_MENU_THROW_POINT            "Nr+# abzweig  * Abbr  # Liste"                 // "no+# Throw * Cancel # List"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_CLOSE_POINT
-  #define MENU_ITEM_TEXT_MENU_CLOSE_POINT               "Nr+# gerade  * Abbr  # Liste"                  // "no+# Close * Cancel # List"
+#ifndef DE_MENU_ITEM_TEXT_MENU_CLOSE_POINT
+  #define DE_MENU_ITEM_TEXT_MENU_CLOSE_POINT            "Nr+# gerade  * Abbr  # Liste"                  // "no+# Close * Cancel # List"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_ROUTE
-  #define MENU_ITEM_TEXT_MENU_ROUTE                     "Nr+# auswählen * Abbr # Liste"                 // "no+# Select * Cancel # List"
+#ifndef DE_MENU_ITEM_TEXT_MENU_ROUTE
+  #define DE_MENU_ITEM_TEXT_MENU_ROUTE                  "Nr+# auswählen * Abbr # Liste"                 // "no+# Select * Cancel # List"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_TRACK_POWER
-  #define MENU_ITEM_TEXT_MENU_TRACK_POWER               "* Abbrechen      # Umschalten"                 // "* Cancel # Toggle"
+#ifndef DE_MENU_ITEM_TEXT_MENU_TRACK_POWER
+  #define DE_MENU_ITEM_TEXT_MENU_TRACK_POWER            "* Abbrechen      # Umschalten"                 // "* Cancel # Toggle"
   #endif
-#ifndef MENU_ITEM_TEXT_MENU_EXTRAS
-  #define MENU_ITEM_TEXT_MENU_EXTRAS                    "Nr wählen        * Abbrechen"                  // "no Select * Cancel"
+#ifndef DE_MENU_ITEM_TEXT_MENU_EXTRAS
+  #define DE_MENU_ITEM_TEXT_MENU_EXTRAS                 "Nr wählen        * Abbrechen"                  // "no Select * Cancel"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_HEARTBEAT
-  #define MENU_ITEM_TEXT_MENU_HEARTBEAT                 "* Schließen"                                   // "* Close"
+#ifndef DE_MENU_ITEM_TEXT_MENU_HEARTBEAT
+  #define DE_MENU_ITEM_TEXT_MENU_HEARTBEAT              "* Schließen"                                   // "* Close"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_EDIT_CONSIST
-  #define MENU_ITEM_TEXT_MENU_EDIT_CONSIST              "Nr Richtung invert  * Schließen"               // "no Chng Facing * Close"
+#ifndef DE_MENU_ITEM_TEXT_MENU_EDIT_CONSIST
+  #define DE_MENU_ITEM_TEXT_MENU_EDIT_CONSIST           "Nr Richtung invert  * Schließen"               // "no Chng Facing * Close"
 #endif
 
 
-#ifndef EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE
-  #define EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE      "Fn/Befhl tausc"                                // "Fnc/Key Tgl"
+#ifndef DE_EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE
+  #define DE_EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE   "Fn/Befhl tausc"                                // "Fnc/Key Tgl"
+#endif
+#ifndef DE_EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST
+  #define DE_EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST          "Traktion änd"                                  // "Edt Consist"
 #endif
-#ifndef EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST
-  #define EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST             "Traktion änd"                                  // "Edt Consist"
+#ifndef DE_EXTRA_MENU_TEXT_CHAR_LANGUAGE
+  #define DE_EXTRA_MENU_TEXT_CHAR_LANGUAGE              "Sprache"                                       // "Language"
 #endif
 
-#ifndef EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE
-  #define EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE         "Heartbt E/A"                                   // "Heartbt Tgl"
+#ifndef DE_EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE
+  #define DE_EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE      "Heartbt E/A"                                   // "Heartbt Tgl"
+#endif
+#ifndef DE_EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE
+  #define DE_EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE "1 Lok E/A"                                   // "1 loco Tgl"
+#endif
+#ifndef DE_EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS
+  #define DE_EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS         "Loks Speichern"                                   // "1 loco Tgl"
+#endif
+#ifndef DE_EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES
+  #define DE_EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES   "#Regler +"                                     // "#Throttles +"
 #endif
-#ifndef EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE
-  #define EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE "1 Lok E/A"                                   // "1 loco Tgl"
+#ifndef DE_EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES
+  #define DE_EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES   "#Regler -"                                     // "#Throttles -"
 #endif
-#ifndef EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS
-  #define EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS            "Loks Speichern"                                   // "1 loco Tgl"
+#ifndef DE_EXTRA_MENU_TEXT_CHAR_DISCONNECT
+  #define DE_EXTRA_MENU_TEXT_CHAR_DISCONNECT            "Trenne WiT"                                    // "Disconnect"
 #endif
-#ifndef EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES
-  #define EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES   "#Regler +"                                     // "#Throttles +"
+#ifndef DE_EXTRA_MENU_TEXT_CHAR_OFF_SLEEP
+  #define DE_EXTRA_MENU_TEXT_CHAR_OFF_SLEEP             "AUS / Schlaf"                                  // "OFF / Sleep"
 #endif
-#ifndef EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES
-  #define EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES   "#Regler -"                                     // "#Throttles -"
+#ifndef DE_MENU_ITEM_TEXT_TITLE_DIAGNOSTICS
+  #define DE_MENU_ITEM_TEXT_TITLE_DIAGNOSTICS           "Diagnose"                                      // "Diagnostics"
 #endif
-#ifndef EXTRA_MENU_TEXT_CHAR_DISCONNECT
-  #define EXTRA_MENU_TEXT_CHAR_DISCONNECT               "Trenne WiT"                                    // "Disconnect"
+
+
+#ifndef DE_LANGUAGE_NAME
+  #define DE_LANGUAGE_NAME                              "Deutsch"                                       // "English"
 #endif
-#ifndef EXTRA_MENU_TEXT_CHAR_OFF_SLEEP
-  #define EXTRA_MENU_TEXT_CHAR_OFF_SLEEP                "AUS / Schlaf"                                  // "OFF / Sleep"
+
 #endif
 
+#ifndef LANGUAGE_TABLES_H  // included from config_buttons.h
+  #ifndef DEFAULT_LANGUAGE
+    #define DEFAULT_LANGUAGE LANGUAGE_DEUTSCH
+  #endif
 
 #ifndef F0_LABEL
   #define F0_LABEL                                      "Licht"                                         // "Light"
@@ -297,3 +326,4 @@
 #ifndef CHOSEN_KEYPAD_9_DISPLAY_NAME
   #define CHOSEN_KEYPAD_9_DISPLAY_NAME                  "9 Vorwärts"                                    // "9 Fwd"
 #endif
+#endif
@@ -1,254 +1,283 @@
+//
+// Italian - Italiano
+//
+// The menu and message text is compiled into the language tables (language_tables.h) 
+// and the language can be chosen on the device from the Extras menu.
+// Individual texts can be overridden by defining the IT_... name in config_buttons.h
+//
+// The key and function labels at the end are only used if this file is included
+// in config_buttons.h, which also makes this the default language.
 
-#ifndef MENU_TEXT_MENU
-  #define MENU_TEXT_MENU                                "* Menù                 # Funz. Tasti"         // "* Menu # Key Defs"
+#ifndef LANGUAGE_ITALIANO_H
+#define LANGUAGE_ITALIANO_H
+
+#ifndef IT_MENU_TEXT_MENU
+  #define IT_MENU_TEXT_MENU                             "* Menù                 # Funz. Tasti"         // "* Menu # Key Defs"
 #endif
-#ifndef MENU_TEXT_MENU_HASH_IS_FUNCTIONS
-  #define MENU_TEXT_MENU_HASH_IS_FUNCTIONS              "* Menù                          # Fn"         // "* Menu # Fn"
+#ifndef IT_MENU_TEXT_MENU_HASH_IS_FUNCTIONS
+  #define IT_MENU_TEXT_MENU_HASH_IS_FUNCTIONS           "* Menù                          # Fn"         // "* Menu # Fn"
 #endif
-#ifndef MENU_TEXT_FINISH
-  #define MENU_TEXT_FINISH                              "                       # Fine"                // "# Finish"
+#ifndef IT_MENU_TEXT_FINISH
+  #define IT_MENU_TEXT_FINISH                           "                       # Fine"                // "# Finish"
 #endif
-#ifndef MENU_TEXT_CANCEL
-  #define MENU_TEXT_CANCEL                              "* Annulla"                                    // "* Cancel"
+#ifndef IT_MENU_TEXT_CANCEL
+  #define IT_MENU_TEXT_CANCEL                           "* Annulla"                                    // "* Cancel"
 #endif
-#ifndef MENU_TEXT_SHOW_DIRECT
-  #define MENU_TEXT_SHOW_DIRECT                         "              # Mostra direttamente"          // "# Show Direct"
+#ifndef IT_MENU_TEXT_SHOW_DIRECT
+  #define IT_MENU_TEXT_SHOW_DIRECT                      "              # Mostra direttamente"          // "# Show Direct"
 #endif
-#ifndef MENU_TEXT_ROSTER
-  #define MENU_TEXT_ROSTER                              "* Annulla   0-9   #Pagina"                    // "* Cancel 0-9 #Pg"
+#ifndef IT_MENU_TEXT_ROSTER
+  #define IT_MENU_TEXT_ROSTER                           "* Annulla   0-9   #Pagina"                    // "* Cancel 0-9 #Pg"
 #endif
-#ifndef MENU_TEXT_TURNOUT_LIST
-  #define MENU_TEXT_TURNOUT_LIST                        "* Annulla   0-9   #Pagina"                    // "* Cancel 0-9 #Pg"
+#ifndef IT_MENU_TEXT_TURNOUT_LIST
+  #define IT_MENU_TEXT_TURNOUT_LIST                     "* Annulla   0-9   #Pagina"                    // "* Cancel 0-9 #Pg"
 #endif
-#ifndef MENU_TEXT_ROUTE_LIST
-  #define MENU_TEXT_ROUTE_LIST                          "* Annulla   0-9   #Pagina"                    // "* Cancel 0-9 #Pg"
+#ifndef IT_MENU_TEXT_ROUTE_LIST
+  #define IT_MENU_TEXT_ROUTE_LIST                       "* Annulla   0-9   #Pagina"                    // "* Cancel 0-9 #Pg"
 #endif
-#ifndef MENU_TEXT_FUNCTION_LIST
-  #define MENU_TEXT_FUNCTION_LIST                       "* Annulla   0-9   #Pagina"                    // "* Cancel 0-9 #Pg"
+#ifndef IT_MENU_TEXT_FUNCTION_LIST
+  #define IT_MENU_TEXT_FUNCTION_LIST                    "* Annulla   0-9   #Pagina"                    // "* Cancel 0-9 #Pg"
 #endif
-#ifndef MENU_TEXT_SELECT_WIT_SERVICE
-  #define MENU_TEXT_SELECT_WIT_SERVICE                  "0-4       # Altro IP       @ OFF"             // "0-4 # Entry E.btn OFF"
+#ifndef IT_MENU_TEXT_SELECT_WIT_SERVICE
+  #define IT_MENU_TEXT_SELECT_WIT_SERVICE               "0-4       # Altro IP       @ OFF"             // "0-4 # Entry E.btn OFF"
 #endif
-#ifndef MENU_TEXT_SELECT_WIT_ENTRY
-  #define MENU_TEXT_SELECT_WIT_ENTRY                    "0-9  * Canc  # Connetti  @ OFF"               // "0-9 * Back # Go E.btn OFF"
+#ifndef IT_MENU_TEXT_SELECT_WIT_ENTRY
+  #define IT_MENU_TEXT_SELECT_WIT_ENTRY                 "0-9  * Canc  # Connetti  @ OFF"               // "0-9 * Back # Go E.btn OFF"
 #endif
-#ifndef MENU_TEXT_SELECT_SSIDS
-  #define MENU_TEXT_SELECT_SSIDS                        "0-9         # Cerca         @ OFF"            // "0-9 # Search E.btn OFF"
+#ifndef IT_MENU_TEXT_SELECT_SSIDS
+  #define IT_MENU_TEXT_SELECT_SSIDS                     "0-9         # Cerca         @ OFF"            // "0-9 # Search E.btn OFF"
 #endif
-#ifndef MENU_TEXT_SELECT_SSIDS_FROM_FOUND
-  #define MENU_TEXT_SELECT_SSIDS_FROM_FOUND             "0-4  9 Lista  # Pagina  @ OFF"                // "0-4 9 List # Pg E.btn OFF"
+#ifndef IT_MENU_TEXT_SELECT_SSIDS_FROM_FOUND
+  #define IT_MENU_TEXT_SELECT_SSIDS_FROM_FOUND          "0-4  9 Lista  # Pagina  @ OFF"                // "0-4 9 List # Pg E.btn OFF"
 #endif
-#ifndef MENU_TEXT_ENTER_SSID_PASSWORD
-  #define MENU_TEXT_ENTER_SSID_PASSWORD                 "E Car. @ Sel. # Vai * Ind."                   // "E Chrs E.btn Slct # Go * Bck"
+#ifndef IT_MENU_TEXT_ENTER_SSID_PASSWORD
+  #define IT_MENU_TEXT_ENTER_SSID_PASSWORD              "E Car. @ Sel. # Vai * Ind."                   // "E Chrs E.btn Slct # Go * Bck"
 #endif
 
 
-#ifndef DIRECT_COMMAND_LIST
-  #define DIRECT_COMMAND_LIST                           "Comandi diretti"                              // "Direct Commands"
+#ifndef IT_DIRECT_COMMAND_LIST
+  #define IT_DIRECT_COMMAND_LIST                        "Comandi diretti"                              // "Direct Commands"
 #endif
-#ifndef DIRECTION_FORWARD_TEXT
-  #define DIRECTION_FORWARD_TEXT                        "Avanti"                                       // "Fwd"
+#ifndef IT_DIRECTION_FORWARD_TEXT
+  #define IT_DIRECTION_FORWARD_TEXT                     "Avanti"                                       // "Fwd"
 #endif
-#ifndef DIRECTION_REVERSE_TEXT
-  #define DIRECTION_REVERSE_TEXT                        "Indiet."                                      // "Rev"
+#ifndef IT_DIRECTION_REVERSE_TEXT
+  #define IT_DIRECTION_REVERSE_TEXT                     "Indiet."                                      // "Rev"
 #endif
 
 
-#ifndef MSG_START
-  #define MSG_START                                     "Start"                                        // "Start"
+#ifndef IT_MSG_START
+  #define IT_MSG_START                                  "Start"                                        // "Start"
 #endif
-#ifndef MSG_BROWSING_FOR_SERVICE
-  #define MSG_BROWSING_FOR_SERVICE                      "Ricerca server WiT"                           // "Browsing for WiT services"
+#ifndef IT_MSG_BROWSING_FOR_SERVICE
+  #define IT_MSG_BROWSING_FOR_SERVICE                   "Ricerca server WiT"                           // "Browsing for WiT services"
 #endif
-#ifndef MSG_BROWSING_FOR_SSIDS
-  #define MSG_BROWSING_FOR_SSIDS                        "Ricerca SSIDs"                                // "Browsing for SSIDs"
+#ifndef IT_MSG_BROWSING_FOR_SSIDS
+  #define IT_MSG_BROWSING_FOR_SSIDS                     "Ricerca SSIDs"                                // "Browsing for SSIDs"
 #endif
-#ifndef MSG_NO_SSIDS_FOUND
-  #define MSG_NO_SSIDS_FOUND                            "Nessun SSIDs trovato"                         // "No SSIDs found"
+#ifndef IT_MSG_NO_SSIDS_FOUND
+  #define IT_MSG_NO_SSIDS_FOUND                         "Nessun SSIDs trovato"                         // "No SSIDs found"
 #endif
-#ifndef MSG_SSIDS_ListaD
-  #define MSG_SSIDS_ListaD                              "SSIDs salvati"                                // "SSIDs Listad"
+#ifndef IT_MSG_SSIDS_LISTED
+  #define IT_MSG_SSIDS_LISTED                           "SSIDs salvati"                                // "SSIDs Listad"
 #endif
-#ifndef MSG_SSIDS_FOUND
-  #define MSG_SSIDS_FOUND                               "SSIDs trovati"                                // "SSIDs found"
+#ifndef IT_MSG_SSIDS_FOUND
+  #define IT_MSG_SSIDS_FOUND                            "SSIDs trovati"                                // "SSIDs found"
 #endif
-#ifndef MSG_BOUNJOUR_SETUP_FAILED
-  #define MSG_BOUNJOUR_SETUP_FAILED                     "Imp. impostare Listener"                      // "Unable to setup Listener"
+#ifndef IT_MSG_BOUNJOUR_SETUP_FAILED
+  #define IT_MSG_BOUNJOUR_SETUP_FAILED                  "Imp. impostare Listener"                      // "Unable to setup Listener"
 #endif
-#ifndef MSG_NO_SERVICES_FOUND
-  #define MSG_NO_SERVICES_FOUND                         "Nessun servizio trovato"                      // "No services found"
+#ifndef IT_MSG_NO_SERVICES_FOUND
+  #define IT_MSG_NO_SERVICES_FOUND                      "Nessun servizio trovato"                      // "No services found"
 #endif
-#ifndef MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED
-  #define MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED          "Inserire IP:Port WiTserver"                   // "Enter witServer IP:Port"
+#ifndef IT_MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED
+  #define IT_MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED       "Inserire IP:Port WiTserver"                   // "Enter witServer IP:Port"
 #endif
-#ifndef MSG_SERVICES_FOUND
-  #define MSG_SERVICES_FOUND                            "Servizi trovati"                              // "Service(s) found"
+#ifndef IT_MSG_SERVICES_FOUND
+  #define IT_MSG_SERVICES_FOUND                         "Servizi trovati"                              // "Service(s) found"
 #endif
-#ifndef MSG_TRYING_TO_CONNECT
-  #define MSG_TRYING_TO_CONNECT                         "Tentativo di Connessione"                     // "Trying to Connect"
+#ifndef IT_MSG_TRYING_TO_CONNECT
+  #define IT_MSG_TRYING_TO_CONNECT                      "Tentativo di Connessione"                     // "Trying to Connect"
 #endif
-#ifndef MSG_CONNECTED
-  #define MSG_CONNECTED                                 "             Connesso"                        // "Connected"
+#ifndef IT_MSG_CONNECTED
+  #define IT_MSG_CONNECTED                              "             Connesso"                        // "Connected"
 #endif
-#ifndef MSG_CONNECTING
-  #define MSG_CONNECTING                                "             Connessione..."                  // "Connecting..."
+#ifndef IT_MSG_CONNECTING
+  #define IT_MSG_CONNECTING                             "             Connessione..."                  // "Connecting..."
 #endif
 
 
-#ifndef MSG_ADDRESS_LABEL
-  #define MSG_ADDRESS_LABEL                             "Indirizzo IP:"                                // "IP address:"
+#ifndef IT_MSG_ADDRESS_LABEL
+  #define IT_MSG_ADDRESS_LABEL                          "Indirizzo IP:"                                // "IP address:"
 #endif
-#ifndef MSG_CONNECTION_FAILED
-  #define MSG_CONNECTION_FAILED                         "Connessione fallita"                          // "Connection failed"
+#ifndef IT_MSG_CONNECTION_FAILED
+  #define IT_MSG_CONNECTION_FAILED                      "Connessione fallita"                          // "Connection failed"
 #endif
-#ifndef MSG_DISCONNECTED
-  #define MSG_DISCONNECTED                              "Disconnessso"                                 // "Disconnected"
+#ifndef IT_MSG_DISCONNECTED
+  #define IT_MSG_DISCONNECTED                           "Disconnessso"                                 // "Disconnected"
 #endif
-#ifndef MSG_AUTO_SLEEP
-  #define MSG_AUTO_SLEEP                                "Attesa selezione troppo lunga"                // "Waited too long for Select"
+#ifndef IT_MSG_AUTO_SLEEP
+  #define IT_MSG_AUTO_SLEEP                             "Attesa selezione troppo lunga"                // "Waited too long for Select"
 #endif
-#ifndef MSG_BATTERY_SLEEP
-  #define MSG_BATTERY_SLEEP                             "Batteria scarica"                             // "Battery critically low"
+#ifndef IT_MSG_BATTERY_SLEEP
+  #define IT_MSG_BATTERY_SLEEP                          "Batteria scarica"                             // "Battery critically low"
 #endif
-#ifndef MSG_START_SLEEP
-  #define MSG_START_SLEEP                               "Spegnimento.      @ Riavvia"                  // "Shutting Down. E.btn ON"
+#ifndef IT_MSG_START_SLEEP
+  #define IT_MSG_START_SLEEP                            "Spegnimento.      @ Riavvia"                  // "Shutting Down. E.btn ON"
 #endif
-#ifndef MSG_THROTTLE_NUMBER
-  #define MSG_THROTTLE_NUMBER                           "             Throttle #"                      // "Throttle #"
+#ifndef IT_MSG_THROTTLE_NUMBER
+  #define IT_MSG_THROTTLE_NUMBER                        "             Throttle #"                      // "Throttle #"
 #endif
-#ifndef MSG_NO_LOCO_SELECTED
-  #define MSG_NO_LOCO_SELECTED                          "     Nessuna loco selezionata"                // "No Loco selected"
+#ifndef IT_MSG_NO_LOCO_SELECTED
+  #define IT_MSG_NO_LOCO_SELECTED                       "     Nessuna loco selezionata"                // "No Loco selected"
 #endif
-#ifndef MSG_ENTER_PASSWORD
-  #define MSG_ENTER_PASSWORD                            "Inserire Password"                            // "Enter Password"
+#ifndef IT_MSG_ENTER_PASSWORD
+  #define IT_MSG_ENTER_PASSWORD                         "Inserire Password"                            // "Enter Password"
 #endif
-#ifndef MSG_GUESSED_EX_CS_WIT_SERVER
-  #define MSG_GUESSED_EX_CS_WIT_SERVER                  "EX-CS WiT-Server trovato"                     // "Guessed' EX-CS WiT server"
+#ifndef IT_MSG_GUESSED_EX_CS_WIT_SERVER
+  #define IT_MSG_GUESSED_EX_CS_WIT_SERVER               "EX-CS WiT-Server trovato"                     // "Guessed' EX-CS WiT server"
 #endif
-#ifndef MSG_BYPASS_WIT_SERVER_SEARCH
-  #define MSG_BYPASS_WIT_SERVER_SEARCH                  "Bypass ricerca WiT server"                    // "Bypass WiT server search"
+#ifndef IT_MSG_BYPASS_WIT_SERVER_SEARCH
+  #define IT_MSG_BYPASS_WIT_SERVER_SEARCH               "Bypass ricerca WiT server"                    // "Bypass WiT server search"
 #endif
-#ifndef MSG_NO_FUNCTIONS
-  #define MSG_NO_FUNCTIONS                              "Lista funzioni - Lista vuota"                 // "Function List - No Functions"
+#ifndef IT_MSG_NO_FUNCTIONS
+  #define IT_MSG_NO_FUNCTIONS                           "Lista funzioni - Lista vuota"                 // "Function List - No Functions"
 #endif
-#ifndef MSG_HEARTBEAT_CHECK_ENABLED
-  #define MSG_HEARTBEAT_CHECK_ENABLED                   "Controllo Heartbeat attivato"                 // "Heartbeat Check Enabled"
+#ifndef IT_MSG_HEARTBEAT_CHECK_ENABLED
+  #define IT_MSG_HEARTBEAT_CHECK_ENABLED                "Controllo Heartbeat attivato"                 // "Heartbeat Check Enabled"
 #endif
-#ifndef MSG_HEARTBEAT_CHECK_DISABLED
-  #define MSG_HEARTBEAT_CHECK_DISABLED                  "Controllo Heartbeat disattivato"              // "Heartbeat Check Disabled"
+#ifndef IT_MSG_HEARTBEAT_CHECK_DISABLED
+  #define IT_MSG_HEARTBEAT_CHECK_DISABLED               "Controllo Heartbeat disattivato"              // "Heartbeat Check Disabled"
 #endif
-#ifndef MSG_RECEIVING_SERVER_DETAILS
-   #define MSG_RECEIVING_SERVER_DETAILS                 "Ricezioni dati dal Server"                    // "Getting data from server"
+#ifndef IT_MSG_RECEIVING_SERVER_DETAILS
+   #define IT_MSG_RECEIVING_SERVER_DETAILS              "Ricezioni dati dal Server"                    // "Getting data from server"
 #endif
 
-#ifndef MENU_ITEM_TEXT_TITLE_FUNCTION
-  #define MENU_ITEM_TEXT_TITLE_FUNCTION                 "Funzione"                                     // "Function"
+#ifndef IT_MENU_ITEM_TEXT_TITLE_FUNCTION
+  #define IT_MENU_ITEM_TEXT_TITLE_FUNCTION              "Funzione"                                     // "Function"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_ADD_LOCO
-  #define MENU_ITEM_TEXT_TITLE_ADD_LOCO                 "Agg. Loco"                                    // "Add Loco"
+#ifndef IT_MENU_ITEM_TEXT_TITLE_ADD_LOCO
+  #define IT_MENU_ITEM_TEXT_TITLE_ADD_LOCO              "Agg. Loco"                                    // "Add Loco"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_DROP_LOCO
-  #define MENU_ITEM_TEXT_TITLE_DROP_LOCO                "Canc. Loco"                                   // "Drop Loco"
+#ifndef IT_MENU_ITEM_TEXT_TITLE_DROP_LOCO
+  #define IT_MENU_ITEM_TEXT_TITLE_DROP_LOCO             "Canc. Loco"                                   // "Drop Loco"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION
-  #define MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION         "Cambio Dir."                                  // "Toggle Dir"
+#ifndef IT_MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION
+  #define IT_MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION      "Cambio Dir."                                  // "Toggle Dir"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER
-  #define MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER    "Molt. Vel."                                   // "X Speed Step"
+#ifndef IT_MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER
+  #define IT_MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER "Molt. Vel."                                   // "X Speed Step"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_THROW_POINT
-  #define MENU_ITEM_TEXT_TITLE_THROW_POINT              "Sc. Deviata"                                  // "Throw Point"
+#ifndef IT_MENU_ITEM_TEXT_TITLE_THROW_POINT
+  #define IT_MENU_ITEM_TEXT_TITLE_THROW_POINT           "Sc. Deviata"                                  // "Throw Point"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_CLOSE_POINT
-  #define MENU_ITEM_TEXT_TITLE_CLOSE_POINT              "Sc. Corretto"                                 // "Close Point"
+#ifndef IT_MENU_ITEM_TEXT_TITLE_CLOSE_POINT
+  #define IT_MENU_ITEM_TEXT_TITLE_CLOSE_POINT           "Sc. Corretto"                                 // "Close Point"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_ROUTE
-  #define MENU_ITEM_TEXT_TITLE_ROUTE                    "Route"                                        // "Route"
+#ifndef IT_MENU_ITEM_TEXT_TITLE_ROUTE
+  #define IT_MENU_ITEM_TEXT_TITLE_ROUTE                 "Route"                                        // "Route"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_TRACK_POWER
-  #define MENU_ITEM_TEXT_TITLE_TRACK_POWER              "Trk Power"                                    // "Trk Power"
+#ifndef IT_MENU_ITEM_TEXT_TITLE_TRACK_POWER
+  #define IT_MENU_ITEM_TEXT_TITLE_TRACK_POWER           "Trk Power"                                    // "Trk Power"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_EXTRAS
-  #define MENU_ITEM_TEXT_TITLE_EXTRAS                   "Extras"                                       // "Extras"
+#ifndef IT_MENU_ITEM_TEXT_TITLE_EXTRAS
+  #define IT_MENU_ITEM_TEXT_TITLE_EXTRAS                "Extras"                                       // "Extras"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_HEARTBEAT
-  #define MENU_ITEM_TEXT_TITLE_HEARTBEAT                "Heartbeat"                                    // "Heartbeat"
+#ifndef IT_MENU_ITEM_TEXT_TITLE_HEARTBEAT
+  #define IT_MENU_ITEM_TEXT_TITLE_HEARTBEAT             "Heartbeat"                                    // "Heartbeat"
 #endif
-#ifndef MENU_ITEM_TEXT_TITLE_EDIT_CONSIST
-  #define MENU_ITEM_TEXT_TITLE_EDIT_CONSIST             "Mod. Multitraz."                              // "Edit Consist Facing"
+#ifndef IT_MENU_ITEM_TEXT_TITLE_EDIT_CONSIST
+  #define IT_MENU_ITEM_TEXT_TITLE_EDIT_CONSIST          "Mod. Multitraz."                              // "Edit Consist Facing"
 #endif
 
 
-#ifndef MENU_ITEM_TEXT_MENU_FUNCTION
-  #define MENU_ITEM_TEXT_MENU_FUNCTION                  "Nr+# Scegli  * Annulla  # Lista"               // "no+# Select * Cancel # List"
+#ifndef IT_MENU_ITEM_TEXT_MENU_FUNCTION
+  #define IT_MENU_ITEM_TEXT_MENU_FUNCTION               "Nr+# Scegli  * Annulla  # Lista"               // "no+# Select * Cancel # List"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_ADD_LOCO
-  #define MENU_ITEM_TEXT_MENU_ADD_LOCO                  "Ind.+# Agg.  * Annulla  # Lista"               // "addr+# Add * Cancel # Roster"
+#ifndef IT_MENU_ITEM_TEXT_MENU_ADD_LOCO
+  #define IT_MENU_ITEM_TEXT_MENU_ADD_LOCO               "Ind.+# Agg.  * Annulla  # Lista"               // "addr+# Add * Cancel # Roster"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_DROP_LOCO
-  #define MENU_ITEM_TEXT_MENU_DROP_LOCO                 "Ind.+# Canc.  * Annulla  # Tutte"              // "addr+# One * Cancel # All"
+#ifndef IT_MENU_ITEM_TEXT_MENU_DROP_LOCO
+  #define IT_MENU_ITEM_TEXT_MENU_DROP_LOCO              "Ind.+# Canc.  * Annulla  # Tutte"              // "addr+# One * Cancel # All"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX
-  #define MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX        "Nr.+# Canc.  * Annulla  # Tutte"               // "no+# One * Cancel # All"
+#ifndef IT_MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX
+  #define IT_MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX     "Nr.+# Canc.  * Annulla  # Tutte"               // "no+# One * Cancel # All"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_TOGGLE_DIRECTION
-  #define MENU_ITEM_TEXT_MENU_TOGGLE_DIRECTION          "# Cambia"                                      // "# Toggle"
+#ifndef IT_MENU_ITEM_TEXT_MENU_TOGGLE_DIRECTION
+  #define IT_MENU_ITEM_TEXT_MENU_TOGGLE_DIRECTION       "# Cambia"                                      // "# Toggle"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_SPEED_STEP_MULTIPLIER
-  #define MENU_ITEM_TEXT_MENU_SPEED_STEP_MULTIPLIER     "* Annulla      # Cambia"                       // "* Cancel # Toggle"
+#ifndef IT_MENU_ITEM_TEXT_MENU_SPEED_STEP_MULTIPLIER
+  #define IT_MENU_ITEM_TEXT_MENU_SPEED_STEP_MULTIPLIER  "* Annulla      # Cambia"                       // "* Cancel # Toggle"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_THROW_POINT
-  #define MENU_ITEM_TEXT_MENU_THROW_POINT               "Nr+# deviata  * Ann  # Lista"                  // "no+# Throw * Cancel # List"
+#ifndef IT_MENU_ITEM_TEXT_MENU_THROW_POINT
+  #define IT_MENU_ITEM_TEXT_MENU_THROW_POINT            "Nr+# deviata  * Ann  # Lista"                  // "no+# Throw * Cancel # List"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_CLOSE_POINT
-  #define MENU_ITEM_TEXT_MENU_CLOSE_POINT               "Nr+# corretto  * Ann  # Lista"                 // "no+# Close * Cancel # List"
+#ifndef IT_MENU_ITEM_TEXT_MENU_CLOSE_POINT
+  #define IT_MENU_ITEM_TEXT_MENU_CLOSE_POINT            "Nr+# corretto  * Ann  # Lista"                 // "no+# Close * Cancel # List"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_ROUTE
-  #define MENU_ITEM_TEXT_MENU_ROUTE                     "Nr+# Scegli * Ann # Lista"                     // "no+# Select * Cancel # List"
+#ifndef IT_MENU_ITEM_TEXT_MENU_ROUTE
+  #define IT_MENU_ITEM_TEXT_MENU_ROUTE                  "Nr+# Scegli * Ann # Lista"                     // "no+# Select * Cancel # List"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_TRACK_POWER
-  #define MENU_ITEM_TEXT_MENU_TRACK_POWER               "* Annulla      # Cambia"                       // "* Cancel # Toggle"
+#ifndef IT_MENU_ITEM_TEXT_MENU_TRACK_POWER
+  #define IT_MENU_ITEM_TEXT_MENU_TRACK_POWER            "* Annulla      # Cambia"                       // "* Cancel # Toggle"
   #endif
-#ifndef MENU_ITEM_TEXT_MENU_EXTRAS
-  #define MENU_ITEM_TEXT_MENU_EXTRAS                    "Scegli Nr       * Annulla"                     // "no Select * Cancel"
+#ifndef IT_MENU_ITEM_TEXT_MENU_EXTRAS
+  #define IT_MENU_ITEM_TEXT_MENU_EXTRAS                 "Scegli Nr       * Annulla"                     // "no Select * Cancel"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_HEARTBEAT
-  #define MENU_ITEM_TEXT_MENU_HEARTBEAT                 "* Chiudi"                                      // "* Close"
+#ifndef IT_MENU_ITEM_TEXT_MENU_HEARTBEAT
+  #define IT_MENU_ITEM_TEXT_MENU_HEARTBEAT              "* Chiudi"                                      // "* Close"
 #endif
-#ifndef MENU_ITEM_TEXT_MENU_EDIT_CONSIST
-  #define MENU_ITEM_TEXT_MENU_EDIT_CONSIST              "Cambia dir. Nr  * Chiudi"                      // "no Chng Facing * Close"
+#ifndef IT_MENU_ITEM_TEXT_MENU_EDIT_CONSIST
+  #define IT_MENU_ITEM_TEXT_MENU_EDIT_CONSIST           "Cambia dir. Nr  * Chiudi"                      // "no Chng Facing * Close"
 #endif
 
 
-#ifndef EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE
-  #define EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE      "Cmb Fn/Tast"                                  // "Fnc/Key Tgl"
+#ifndef IT_EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE
+  #define IT_EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE   "Cmb Fn/Tast"                                  // "Fnc/Key Tgl"
+#endif
+#ifndef IT_EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST
+  #define IT_EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST          "Cmb Multitrz."                                // "Edt Consist"
 #endif
-#ifndef EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST
-  #define EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST             "Cmb Multitrz."                                // "Edt Consist"
+#ifndef IT_EXTRA_MENU_TEXT_CHAR_LANGUAGE
+  #define IT_EXTRA_MENU_TEXT_CHAR_LANGUAGE              "Lingua"                                        // "Language"
 #endif
 
-#ifndef EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE
-  #define EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE         "Heartbt Cmb"                                  // "Heartbt Tgl"
+#ifndef IT_EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE
+  #define IT_EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE      "Heartbt Cmb"                                  // "Heartbt Tgl"
+#endif
+#ifndef IT_EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE
+  #define IT_EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE "1 Lok Cmb"                                  // "1 loco Tgl"
+#endif
+#ifndef IT_EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS
+  #define IT_EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS         "Loks Salva"                                   // "1 loco Tgl"
+#endif
+#ifndef IT_EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES
+  #define IT_EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES   "#Controll. +"                                 // "#Throttles +"
 #endif
-#ifndef EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE
-  #define EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE "1 Lok Cmb"                                  // "1 loco Tgl"
+#ifndef IT_EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES
+  #define IT_EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES   "#Controll. -"                                 // "#Throttles -"
 #endif
-#ifndef EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS
-  #define EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS            "Loks Salva"                                   // "1 loco Tgl"
+#ifndef IT_EXTRA_MENU_TEXT_CHAR_DISCONNECT
+  #define IT_EXTRA_MENU_TEXT_CHAR_DISCONNECT            "Disconnetti"                                  // "Disconnect"
 #endif
-#ifndef EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES
-  #define EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES   "#Controll. +"                                 // "#Throttles +"
+#ifndef IT_EXTRA_MENU_TEXT_CHAR_OFF_SLEEP
+  #define IT_EXTRA_MENU_TEXT_CHAR_OFF_SLEEP             "OFF / Sleep"                                  // "OFF / Sleep"
 #endif
-#ifndef EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES
-  #define EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES   "#Controll. -"                                 // "#Throttles -"
+#ifndef IT_MENU_ITEM_TEXT_TITLE_DIAGNOSTICS
+  #define IT_MENU_ITEM_TEXT_TITLE_DIAGNOSTICS           "Diagnostica"                                  // "Diagnostics"
 #endif
-#ifndef EXTRA_MENU_TEXT_CHAR_DISCONNECT
-  #define EXTRA_MENU_TEXT_CHAR_DISCONNECT               "Disconnetti"                                  // "Disconnect"
+
+
+#ifndef IT_LANGUAGE_NAME
+  #define IT_LANGUAGE_NAME                              "Italiano"                                      // "English"
 #endif
-#ifndef EXTRA_MENU_TEXT_CHAR_OFF_SLEEP
-  #define EXTRA_MENU_TEXT_CHAR_OFF_SLEEP                "OFF / Sleep"                                  // "OFF / Sleep"
+
 #endif
 
+#ifndef LANGUAGE_TABLES_H  // included from config_buttons.h
+  #ifndef DEFAULT_LANGUAGE
+    #define DEFAULT_LANGUAGE LANGUAGE_ITALIANO
+  #endif
 
 #ifndef F0_LABEL
   #define F0_LABEL                                      "Luci"                                         // "Light"
@@ -297,3 +326,4 @@
 #ifndef CHOSEN_KEYPAD_9_DISPLAY_NAME
   #define CHOSEN_KEYPAD_9_DISPLAY_NAME                  "9 Avanti"                                     // "9 Fwd"
 #endif
+#endif
@@ -0,0 +1,279 @@
+//
+// Menu and message text for each language, indexed by the TEXT_... ids in static.h
+// 
+// The tables (and the text they point to) are constant, so they stay in flash and use no RAM.
+// Use getText() to get the text in the current language.
+//
+// DO NOT alter this file. Override individual texts in config_buttons.h instead.
+// To add a language, add its file, a table and a LANGUAGE_... id (static.h).
+//
+
+#ifndef LANGUAGE_TABLES_H
+#define LANGUAGE_TABLES_H
+
+#include "language_deutsch.h"
+#include "language_italiano.h"
+
+// English (the MSG_... etc. defines in static.h)
+constexpr const char* text_english[] = {
+  MENU_TEXT_MENU,
+  MENU_TEXT_MENU_HASH_IS_FUNCTIONS,
+  MENU_TEXT_FINISH,
+  MENU_TEXT_CANCEL,
+  MENU_TEXT_SHOW_DIRECT,
+  MENU_TEXT_ROSTER,
+  MENU_TEXT_TURNOUT_LIST,
+  MENU_TEXT_ROUTE_LIST,
+  MENU_TEXT_FUNCTION_LIST,
+  MENU_TEXT_SELECT_WIT_SERVICE,
+  MENU_TEXT_SELECT_WIT_ENTRY,
+  MENU_TEXT_SELECT_SSIDS,
+  MENU_TEXT_SELECT_SSIDS_FROM_FOUND,
+  MENU_TEXT_ENTER_SSID_PASSWORD,
+  DIRECT_COMMAND_LIST,
+  DIRECTION_FORWARD_TEXT,
+  DIRECTION_REVERSE_TEXT,
+  MSG_START,
+  MSG_BROWSING_FOR_SERVICE,
+  MSG_BROWSING_FOR_SSIDS,
+  MSG_NO_SSIDS_FOUND,
+  MSG_SSIDS_LISTED,
+  MSG_SSIDS_FOUND,
+  MSG_BOUNJOUR_SETUP_FAILED,
+  MSG_NO_SERVICES_FOUND,
+  MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED,
+  MSG_SERVICES_FOUND,
+  MSG_TRYING_TO_CONNECT,
+  MSG_CONNECTED,
+  MSG_CONNECTING,
+  MSG_ADDRESS_LABEL,
+  MSG_CONNECTION_FAILED,
+  MSG_DISCONNECTED,
+  MSG_AUTO_SLEEP,
+  MSG_BATTERY_SLEEP,
+  MSG_START_SLEEP,
+  MSG_THROTTLE_NUMBER,
+  MSG_NO_LOCO_SELECTED,
+  MSG_ENTER_PASSWORD,
+  MSG_GUESSED_EX_CS_WIT_SERVER,
+  MSG_BYPASS_WIT_SERVER_SEARCH,
+  MSG_NO_FUNCTIONS,
+  MSG_HEARTBEAT_CHECK_ENABLED,
+  MSG_HEARTBEAT_CHECK_DISABLED,
+  MSG_RECEIVING_SERVER_DETAILS,
+  MENU_ITEM_TEXT_TITLE_FUNCTION,
+  MENU_ITEM_TEXT_TITLE_ADD_LOCO,
+  MENU_ITEM_TEXT_TITLE_DROP_LOCO,
+  MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION,
+  MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER,
+  MENU_ITEM_TEXT_TITLE_THROW_POINT,
+  MENU_ITEM_TEXT_TITLE_CLOSE_POINT,
+  MENU_ITEM_TEXT_TITLE_ROUTE,
+  MENU_ITEM_TEXT_TITLE_TRACK_POWER,
+  MENU_ITEM_TEXT_TITLE_EXTRAS,
+  MENU_ITEM_TEXT_TITLE_HEARTBEAT,
+  MENU_ITEM_TEXT_TITLE_EDIT_CONSIST,
+  MENU_ITEM_TEXT_MENU_FUNCTION,
+  MENU_ITEM_TEXT_MENU_ADD_LOCO,
+  MENU_ITEM_TEXT_MENU_DROP_LOCO,
+  MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX,
+  MENU_ITEM_TEXT_MENU_THROW_POINT,
+  MENU_ITEM_TEXT_MENU_CLOSE_POINT,
+  MENU_ITEM_TEXT_MENU_ROUTE,
+  MENU_ITEM_TEXT_MENU_EXTRAS,
+  MENU_ITEM_TEXT_MENU_HEARTBEAT,
+  MENU_ITEM_TEXT_MENU_EDIT_CONSIST,
+  EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE,
+  EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST,
+  EXTRA_MENU_TEXT_CHAR_LANGUAGE,
+  EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE,
+  EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE,
+  EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS,
+  EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES,
+  EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES,
+  EXTRA_MENU_TEXT_CHAR_DISCONNECT,
+  EXTRA_MENU_TEXT_CHAR_OFF_SLEEP,
+  MENU_ITEM_TEXT_TITLE_DIAGNOSTICS,
+  LANGUAGE_NAME,
+  ""
+};
+static_assert(sizeof(text_english)/sizeof(text_english[0]) == TEXT_COUNT, "text_english is missing entries");
+
+// German - Deutsche
+constexpr const char* text_deutsch[] = {
+  DE_MENU_TEXT_MENU,
+  DE_MENU_TEXT_MENU_HASH_IS_FUNCTIONS,
+  DE_MENU_TEXT_FINISH,
+  DE_MENU_TEXT_CANCEL,
+  DE_MENU_TEXT_SHOW_DIRECT,
+  DE_MENU_TEXT_ROSTER,
+  DE_MENU_TEXT_TURNOUT_LIST,
+  DE_MENU_TEXT_ROUTE_LIST,
+  DE_MENU_TEXT_FUNCTION_LIST,
+  DE_MENU_TEXT_SELECT_WIT_SERVICE,
+  DE_MENU_TEXT_SELECT_WIT_ENTRY,
+  DE_MENU_TEXT_SELECT_SSIDS,
+  DE_MENU_TEXT_SELECT_SSIDS_FROM_FOUND,
+  DE_MENU_TEXT_ENTER_SSID_PASSWORD,
+  DE_DIRECT_COMMAND_LIST,
+  DE_DIRECTION_FORWARD_TEXT,
+  DE_DIRECTION_REVERSE_TEXT,
+  DE_MSG_START,
+  DE_MSG_BROWSING_FOR_SERVICE,
+  DE_MSG_BROWSING_FOR_SSIDS,
+  DE_MSG_NO_SSIDS_FOUND,
+  DE_MSG_SSIDS_LISTED,
+  DE_MSG_SSIDS_FOUND,
+  DE_MSG_BOUNJOUR_SETUP_FAILED,
+  DE_MSG_NO_SERVICES_FOUND,
+  DE_MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED,
+  DE_MSG_SERVICES_FOUND,
+  DE_MSG_TRYING_TO_CONNECT,
+  DE_MSG_CONNECTED,
+  DE_MSG_CONNECTING,
+  DE_MSG_ADDRESS_LABEL,
+  DE_MSG_CONNECTION_FAILED,
+  DE_MSG_DISCONNECTED,
+  DE_MSG_AUTO_SLEEP,
+  DE_MSG_BATTERY_SLEEP,
+  DE_MSG_START_SLEEP,
+  DE_MSG_THROTTLE_NUMBER,
+  DE_MSG_NO_LOCO_SELECTED,
+  DE_MSG_ENTER_PASSWORD,
+  DE_MSG_GUESSED_EX_CS_WIT_SERVER,
+  DE_MSG_BYPASS_WIT_SERVER_SEARCH,
+  DE_MSG_NO_FUNCTIONS,
+  DE_MSG_HEARTBEAT_CHECK_ENABLED,
+  DE_MSG_HEARTBEAT_CHECK_DISABLED,
+  DE_MSG_RECEIVING_SERVER_DETAILS,
+  DE_MENU_ITEM_TEXT_TITLE_FUNCTION,
+  DE_MENU_ITEM_TEXT_TITLE_ADD_LOCO,
+  DE_MENU_ITEM_TEXT_TITLE_DROP_LOCO,
+  DE_MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION,
+  DE_MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER,
+  DE_MENU_ITEM_TEXT_TITLE_THROW_POINT,
+  DE_MENU_ITEM_TEXT_TITLE_CLOSE_POINT,
+  DE_MENU_ITEM_TEXT_TITLE_ROUTE,
+  DE_MENU_ITEM_TEXT_TITLE_TRACK_POWER,
+  DE_MENU_ITEM_TEXT_TITLE_EXTRAS,
+  DE_MENU_ITEM_TEXT_TITLE_HEARTBEAT,
+  DE_MENU_ITEM_TEXT_TITLE_EDIT_CONSIST,
+  DE_MENU_ITEM_TEXT_MENU_FUNCTION,
+  DE_MENU_ITEM_TEXT_MENU_ADD_LOCO,
+  DE_MENU_ITEM_TEXT_MENU_DROP_LOCO,
+  DE_MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX,
+  DE_MENU_ITEM_TEXT_MENU_THROW_POINT,
+  DE_MENU_ITEM_TEXT_MENU_CLOSE_POINT,
+  DE_MENU_ITEM_TEXT_MENU_ROUTE,
+  DE_MENU_ITEM_TEXT_MENU_EXTRAS,
+  DE_MENU_ITEM_TEXT_MENU_HEARTBEAT,
+  DE_MENU_ITEM_TEXT_MENU_EDIT_CONSIST,
+  DE_EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE,
+  DE_EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST,
+  DE_EXTRA_MENU_TEXT_CHAR_LANGUAGE,
+  DE_EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE,
+  DE_EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE,
+  DE_EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS,
+  DE_EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES,
+  DE_EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES,
+  DE_EXTRA_MENU_TEXT_CHAR_DISCONNECT,
+  DE_EXTRA_MENU_TEXT_CHAR_OFF_SLEEP,
+  DE_MENU_ITEM_TEXT_TITLE_DIAGNOSTICS,
+  DE_LANGUAGE_NAME,
+  ""
+};
+static_assert(sizeof(text_deutsch)/sizeof(text_deutsch[0]) == TEXT_COUNT, "text_deutsch is missing entries");
+
+// Italian - Italiano
+constexpr const char* text_italiano[] = {
+  IT_MENU_TEXT_MENU,
+  IT_MENU_TEXT_MENU_HASH_IS_FUNCTIONS,
+  IT_MENU_TEXT_FINISH,
+  IT_MENU_TEXT_CANCEL,
+  IT_MENU_TEXT_SHOW_DIRECT,
+  IT_MENU_TEXT_ROSTER,
+  IT_MENU_TEXT_TURNOUT_LIST,
+  IT_MENU_TEXT_ROUTE_LIST,
+  IT_MENU_TEXT_FUNCTION_LIST,
+  IT_MENU_TEXT_SELECT_WIT_SERVICE,
+  IT_MENU_TEXT_SELECT_WIT_ENTRY,
+  IT_MENU_TEXT_SELECT_SSIDS,
+  IT_MENU_TEXT_SELECT_SSIDS_FROM_FOUND,
+  IT_MENU_TEXT_ENTER_SSID_PASSWORD,
+  IT_DIRECT_COMMAND_LIST,
+  IT_DIRECTION_FORWARD_TEXT,
+  IT_DIRECTION_REVERSE_TEXT,
+  IT_MSG_START,
+  IT_MSG_BROWSING_FOR_SERVICE,
+  IT_MSG_BROWSING_FOR_SSIDS,
+  IT_MSG_NO_SSIDS_FOUND,
+  IT_MSG_SSIDS_LISTED,
+  IT_MSG_SSIDS_FOUND,
+  IT_MSG_BOUNJOUR_SETUP_FAILED,
+  IT_MSG_NO_SERVICES_FOUND,
+  IT_MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED,
+  IT_MSG_SERVICES_FOUND,
+  IT_MSG_TRYING_TO_CONNECT,
+  IT_MSG_CONNECTED,
+  IT_MSG_CONNECTING,
+  IT_MSG_ADDRESS_LABEL,
+  IT_MSG_CONNECTION_FAILED,
+  IT_MSG_DISCONNECTED,
+  IT_MSG_AUTO_SLEEP,
+  IT_MSG_BATTERY_SLEEP,
+  IT_MSG_START_SLEEP,
+  IT_MSG_THROTTLE_NUMBER,
+  IT_MSG_NO_LOCO_SELECTED,
+  IT_MSG_ENTER_PASSWORD,
+  IT_MSG_GUESSED_EX_CS_WIT_SERVER,
+  IT_MSG_BYPASS_WIT_SERVER_SEARCH,
+  IT_MSG_NO_FUNCTIONS,
+  IT_MSG_HEARTBEAT_CHECK_ENABLED,
+  IT_MSG_HEARTBEAT_CHECK_DISABLED,
+  IT_MSG_RECEIVING_SERVER_DETAILS,
+  IT_MENU_ITEM_TEXT_TITLE_FUNCTION,
+  IT_MENU_ITEM_TEXT_TITLE_ADD_LOCO,
+  IT_MENU_ITEM_TEXT_TITLE_DROP_LOCO,
+  IT_MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION,
+  IT_MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER,
+  IT_MENU_ITEM_TEXT_TITLE_THROW_POINT,
+  IT_MENU_ITEM_TEXT_TITLE_CLOSE_POINT,
+  IT_MENU_ITEM_TEXT_TITLE_ROUTE,
+  IT_MENU_ITEM_TEXT_TITLE_TRACK_POWER,
+  IT_MENU_ITEM_TEXT_TITLE_EXTRAS,
+  IT_MENU_ITEM_TEXT_TITLE_HEARTBEAT,
+  IT_MENU_ITEM_TEXT_TITLE_EDIT_CONSIST,
+  IT_MENU_ITEM_TEXT_MENU_FUNCTION,
+  IT_MENU_ITEM_TEXT_MENU_ADD_LOCO,
+  IT_MENU_ITEM_TEXT_MENU_DROP_LOCO,
+  IT_MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX,
+  IT_MENU_ITEM_TEXT_MENU_THROW_POINT,
+  IT_MENU_ITEM_TEXT_MENU_CLOSE_POINT,
+  IT_MENU_ITEM_TEXT_MENU_ROUTE,
+  IT_MENU_ITEM_TEXT_MENU_EXTRAS,
+  IT_MENU_ITEM_TEXT_MENU_HEARTBEAT,
+  IT_MENU_ITEM_TEXT_MENU_EDIT_CONSIST,
+  IT_EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE,
+  IT_EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST,
+  IT_EXTRA_MENU_TEXT_CHAR_LANGUAGE,
+  IT_EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE,
+  IT_EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE,
+  IT_EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS,
+  IT_EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES,
+  IT_EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES,
+  IT_EXTRA_MENU_TEXT_CHAR_DISCONNECT,
+  IT_EXTRA_MENU_TEXT_CHAR_OFF_SLEEP,
+  IT_MENU_ITEM_TEXT_TITLE_DIAGNOSTICS,
+  IT_LANGUAGE_NAME,
+  ""
+};
+static_assert(sizeof(text_italiano)/sizeof(text_italiano[0]) == TEXT_COUNT, "text_italiano is missing entries");
+
+// in LANGUAGE_... order
+constexpr const char* const* languageTexts[LANGUAGE_COUNT] = {
+  text_english,
+  text_deutsch,
+  text_italiano
+};
+
+#endif
@@ -1,8 +1,8 @@
-const String appVersion = "v1.92";
+const char appVersion[] = "v1.118";
 #ifndef CUSTOM_APPNAME
-   const String appName = "WiTcontroller";
+   const char appName[] = "WiTcontroller";
 #else
-   const String appName = CUSTOM_APPNAME;
+   const char appName[] = CUSTOM_APPNAME;
 #endif
 #ifndef DEVICE_NAME
    #define DEVICE_NAME "WiTcontroller"
@@ -62,37 +62,117 @@ const String appVersion = "v1.92";
    #define MENU_TEXT_ENTER_SSID_PASSWORD       "E Chrs  E.btn Slct  # Go  * Bck"
 #endif
 
-const String menu_text[14] = {
-  MENU_TEXT_MENU,
-  MENU_TEXT_MENU_HASH_IS_FUNCTIONS,
-  MENU_TEXT_FINISH,
-  MENU_TEXT_CANCEL,
-  MENU_TEXT_SHOW_DIRECT,
-  MENU_TEXT_ROSTER,
-  MENU_TEXT_TURNOUT_LIST,
-  MENU_TEXT_ROUTE_LIST,
-  MENU_TEXT_FUNCTION_LIST,
-  MENU_TEXT_SELECT_WIT_SERVICE,
-  MENU_TEXT_SELECT_WIT_ENTRY,
-  MENU_TEXT_SELECT_SSIDS,
-  MENU_TEXT_SELECT_SSIDS_FROM_FOUND,
-  MENU_TEXT_ENTER_SSID_PASSWORD
-};
-
-const int menu_menu =                     0;
-const int menu_menu_hash_is_functions =   1;
-const int menu_finish =                   2;
-const int menu_cancel =                   3;
-const int menu_show_direct =              4;
-const int menu_roster =                   5;
-const int menu_turnout_list =             6;
-const int menu_route_list =               7;
-const int menu_function_list =            8;
-const int menu_select_wit_service =       9;
-const int menu_select_wit_entry =        10;
-const int menu_select_ssids =            11;
-const int menu_select_ssids_from_found = 12;
-const int menu_enter_ssid_password =     13;
+// languages. The text for each is in language_tables.h
+#define LANGUAGE_ENGLISH 0
+#define LANGUAGE_DEUTSCH 1
+#define LANGUAGE_ITALIANO 2
+#define LANGUAGE_COUNT 3
+
+#ifndef DEFAULT_LANGUAGE
+   #define DEFAULT_LANGUAGE LANGUAGE_ENGLISH
+#endif
+
+#ifndef LANGUAGE_NAME
+   #define LANGUAGE_NAME                       "English"
+#endif
+
+// menu and message text ids. Index into the language tables in language_tables.h
+#define TEXT_MENU_TEXT_MENU                                       0
+#define TEXT_MENU_TEXT_MENU_HASH_IS_FUNCTIONS                     1
+#define TEXT_MENU_TEXT_FINISH                                     2
+#define TEXT_MENU_TEXT_CANCEL                                     3
+#define TEXT_MENU_TEXT_SHOW_DIRECT                                4
+#define TEXT_MENU_TEXT_ROSTER                                     5
+#define TEXT_MENU_TEXT_TURNOUT_LIST                               6
+#define TEXT_MENU_TEXT_ROUTE_LIST                                 7
+#define TEXT_MENU_TEXT_FUNCTION_LIST                              8
+#define TEXT_MENU_TEXT_SELECT_WIT_SERVICE                         9
+#define TEXT_MENU_TEXT_SELECT_WIT_ENTRY                           10
+#define TEXT_MENU_TEXT_SELECT_SSIDS                               11
+#define TEXT_MENU_TEXT_SELECT_SSIDS_FROM_FOUND                    12
+#define TEXT_MENU_TEXT_ENTER_SSID_PASSWORD                        13
+#define TEXT_DIRECT_COMMAND_LIST                                  14
+#define TEXT_DIRECTION_FORWARD_TEXT                               15
+#define TEXT_DIRECTION_REVERSE_TEXT                               16
+#define TEXT_MSG_START                                            17
+#define TEXT_MSG_BROWSING_FOR_SERVICE                             18
+#define TEXT_MSG_BROWSING_FOR_SSIDS                               19
+#define TEXT_MSG_NO_SSIDS_FOUND                                   20
+#define TEXT_MSG_SSIDS_LISTED                                     21
+#define TEXT_MSG_SSIDS_FOUND                                      22
+#define TEXT_MSG_BOUNJOUR_SETUP_FAILED                            23
+#define TEXT_MSG_NO_SERVICES_FOUND                                24
+#define TEXT_MSG_NO_SERVICES_FOUND_ENTRY_REQUIRED                 25
+#define TEXT_MSG_SERVICES_FOUND                                   26
+#define TEXT_MSG_TRYING_TO_CONNECT                                27
+#define TEXT_MSG_CONNECTED                                        28
+#define TEXT_MSG_CONNECTING                                       29
+#define TEXT_MSG_ADDRESS_LABEL                                    30
+#define TEXT_MSG_CONNECTION_FAILED                                31
+#define TEXT_MSG_DISCONNECTED                                     32
+#define TEXT_MSG_AUTO_SLEEP                                       33
+#define TEXT_MSG_BATTERY_SLEEP                                    34
+#define TEXT_MSG_START_SLEEP                                      35
+#define TEXT_MSG_THROTTLE_NUMBER                                  36
+#define TEXT_MSG_NO_LOCO_SELECTED                                 37
+#define TEXT_MSG_ENTER_PASSWORD                                   38
+#define TEXT_MSG_GUESSED_EX_CS_WIT_SERVER                         39
+#define TEXT_MSG_BYPASS_WIT_SERVER_SEARCH                         40
+#define TEXT_MSG_NO_FUNCTIONS                                     41
+#define TEXT_MSG_HEARTBEAT_CHECK_ENABLED                          42
+#define TEXT_MSG_HEARTBEAT_CHECK_DISABLED                         43
+#define TEXT_MSG_RECEIVING_SERVER_DETAILS                         44
+#define TEXT_MENU_ITEM_TEXT_TITLE_FUNCTION                        45
+#define TEXT_MENU_ITEM_TEXT_TITLE_ADD_LOCO                        46
+#define TEXT_MENU_ITEM_TEXT_TITLE_DROP_LOCO                       47
+#define TEXT_MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION                48
+#define TEXT_MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER           49
+#define TEXT_MENU_ITEM_TEXT_TITLE_THROW_POINT                     50
+#define TEXT_MENU_ITEM_TEXT_TITLE_CLOSE_POINT                     51
+#define TEXT_MENU_ITEM_TEXT_TITLE_ROUTE                           52
+#define TEXT_MENU_ITEM_TEXT_TITLE_TRACK_POWER                     53
+#define TEXT_MENU_ITEM_TEXT_TITLE_EXTRAS                          54
+#define TEXT_MENU_ITEM_TEXT_TITLE_HEARTBEAT                       55
+#define TEXT_MENU_ITEM_TEXT_TITLE_EDIT_CONSIST                    56
+#define TEXT_MENU_ITEM_TEXT_MENU_FUNCTION                         57
+#define TEXT_MENU_ITEM_TEXT_MENU_ADD_LOCO                         58
+#define TEXT_MENU_ITEM_TEXT_MENU_DROP_LOCO                        59
+#define TEXT_MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX               60
+#define TEXT_MENU_ITEM_TEXT_MENU_THROW_POINT                      61
+#define TEXT_MENU_ITEM_TEXT_MENU_CLOSE_POINT                      62
+#define TEXT_MENU_ITEM_TEXT_MENU_ROUTE                            63
+#define TEXT_MENU_ITEM_TEXT_MENU_EXTRAS                           64
+#define TEXT_MENU_ITEM_TEXT_MENU_HEARTBEAT                        65
+#define TEXT_MENU_ITEM_TEXT_MENU_EDIT_CONSIST                     66
+#define TEXT_EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE             67
+#define TEXT_EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST                    68
+#define TEXT_EXTRA_MENU_TEXT_CHAR_LANGUAGE                        69
+#define TEXT_EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE                70
+#define TEXT_EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE      71
+#define TEXT_EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS                   72
+#define TEXT_EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES          73
+#define TEXT_EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES          74
+#define TEXT_EXTRA_MENU_TEXT_CHAR_DISCONNECT                      75
+#define TEXT_EXTRA_MENU_TEXT_CHAR_OFF_SLEEP                       76
+#define TEXT_MENU_ITEM_TEXT_TITLE_DIAGNOSTICS                     77
+#define TEXT_LANGUAGE_NAME                                        78
+#define TEXT_EMPTY                                                79    // for items that don't require showing a menu
+#define TEXT_COUNT                                                80
+
+const int menu_menu =                     TEXT_MENU_TEXT_MENU;
+const int menu_menu_hash_is_functions =   TEXT_MENU_TEXT_MENU_HASH_IS_FUNCTIONS;
+const int menu_finish =                   TEXT_MENU_TEXT_FINISH;
+const int menu_cancel =                   TEXT_MENU_TEXT_CANCEL;
+const int menu_show_direct =              TEXT_MENU_TEXT_SHOW_DIRECT;
+const int menu_roster =                   TEXT_MENU_TEXT_ROSTER;
+const int menu_turnout_list =             TEXT_MENU_TEXT_TURNOUT_LIST;
+const int menu_route_list =               TEXT_MENU_TEXT_ROUTE_LIST;
+const int menu_function_list =            TEXT_MENU_TEXT_FUNCTION_LIST;
+const int menu_select_wit_service =       TEXT_MENU_TEXT_SELECT_WIT_SERVICE;
+const int menu_select_wit_entry =        TEXT_MENU_TEXT_SELECT_WIT_ENTRY;
+const int menu_select_ssids =            TEXT_MENU_TEXT_SELECT_SSIDS;
+const int menu_select_ssids_from_found = TEXT_MENU_TEXT_SELECT_SSIDS_FROM_FOUND;
+const int menu_enter_ssid_password =     TEXT_MENU_TEXT_ENTER_SSID_PASSWORD;
 
 const int last_oled_screen_speed =            0;
 const int last_oled_screen_roster =           1;
@@ -104,6 +184,7 @@ const int last_oled_screen_extra_submenu =    6;
 const int last_oled_screen_all_locos =        7;
 const int last_oled_screen_edit_consist =     8;
 const int last_oled_screen_direct_commands =  9;
+const int last_oled_screen_diagnostics =     10;
 
 typedef enum ShowBattery {
     NONE = 0,
@@ -218,7 +299,7 @@ typedef enum ShowBattery {
    #define MSG_RECEIVING_SERVER_DETAILS  "Getting data from server"
 #endif
 
-const String label_track_power = "TRK";
+const char label_track_power[] = "TRK";
 
 const int glyph_heartbeat_off = 0x00b7;
 const int glyph_track_power = 0x00eb;
@@ -246,6 +327,12 @@ const int glyph_speed_step = 0x00d6;
 #define ENCODER_USE_OPERATION 0
 #define ENCODER_USE_SSID_PASSWORD 1
 
+// startup commands, once parsed
+#define STARTUP_ACTION_NONE 0
+#define STARTUP_ACTION_DIRECT 1      // direct command keys e.g. "6"
+#define STARTUP_ACTION_MENU 2        // a menu command e.g. "*1222#" 
+#define STARTUP_ACTION_KEYS 3        // anything else. Replayed as key presses
+
 // used for both wit and ssid
 #define CONNECTION_STATE_DISCONNECTED 0
 #define CONNECTION_STATE_CONNECTED 1
@@ -254,10 +341,54 @@ const int glyph_speed_step = 0x00d6;
 #define CONNECTION_STATE_SELECTED 4
 #define CONNECTION_STATE_PASSWORD_ENTRY 5
 #define CONNECTION_STATE_ENTERED 6
+#define CONNECTION_STATE_SCANNING 7
 
 #define SSID_CONNECTION_SOURCE_LIST 0
 #define SSID_CONNECTION_SOURCE_BROWSE 1
 
+// WiThrottle protocol separators (used by the inbound fast path)
+#define WIT_PROPERTY_SEPARATOR "<;>"
+#define WIT_ENTRY_SEPARATOR "]\\["
+#define WIT_SEGMENT_SEPARATOR "}|{"
+
+// outbound command scheduler priority classes (lower is sent first)
+#define OUTBOUND_CLASS_ESTOP 0
+#define OUTBOUND_CLASS_SPEED_DIRECTION 1
+#define OUTBOUND_CLASS_FUNCTION 2
+#define OUTBOUND_CLASS_OTHER 3    // turnouts, routes, queries and custom commands
+#define OUTBOUND_CLASS_COUNT 4
+
+// latency benchmark scenarios
+#define LATENCY_SCENARIO_SPEED_UP 0
+#define LATENCY_SCENARIO_ESTOP 1
+#define LATENCY_SCENARIO_FUNCTION 2
+#define LATENCY_SCENARIO_CONSIST_REVERSE 3
+#define LATENCY_SCENARIO_THROTTLE_SWITCH 4
+#define LATENCY_SCENARIO_COUNT 5
+#define LATENCY_SCENARIO_NONE -1
+
+// loop stages timed while recording or replaying a session
+#define LOOP_STAGE_NETWORK 0
+#define LOOP_STAGE_SCHEDULER 1
+#define LOOP_STAGE_INPUT 2
+#define LOOP_STAGE_REPLAY 3
+#define LOOP_STAGE_OTHER 4
+#define LOOP_STAGE_FLUSH 5
+#define LOOP_STAGE_COUNT 6
+
+// outbound command types
+#define OUTBOUND_CMD_SPEED 0
+#define OUTBOUND_CMD_DIRECTION 1
+#define OUTBOUND_CMD_POWER 2
+#define OUTBOUND_CMD_FUNCTION 3
+#define OUTBOUND_CMD_TURNOUT 4
+#define OUTBOUND_CMD_ROUTE 5
+#define OUTBOUND_CMD_QUERY_DIRECTION 6
+#define OUTBOUND_CMD_QUERY_SPEED 7
+#define OUTBOUND_CMD_CUSTOM 8
+#define OUTBOUND_CMD_DIRECTION_CONSIST 9   // a direction for each loco of a consist facing both ways, in one write
+#define OUTBOUND_CMD_RAW 10   // already formatted by the protocol library, e.g. a release
+
 #define CMD_FUNCTION 0
 
 #define MAX_LOCOS     10  // maximum number of locos that can be added to the consist
@@ -315,9 +446,9 @@ const int glyph_speed_step = 0x00d6;
    #define MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX     "no+# One     * Cancel    # All"
 #endif
 #if DROP_LOCO_BY_INDEX
-   #define MENU_ITEM_TEXT_MENU_DROP_LOCO_REAL MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX
+   #define TEXT_MENU_ITEM_TEXT_MENU_DROP_LOCO_REAL TEXT_MENU_ITEM_TEXT_MENU_DROP_LOCO_BY_INDEX
 #else
-   #define MENU_ITEM_TEXT_MENU_DROP_LOCO_REAL MENU_ITEM_TEXT_MENU_DROP_LOCO
+   #define TEXT_MENU_ITEM_TEXT_MENU_DROP_LOCO_REAL TEXT_MENU_ITEM_TEXT_MENU_DROP_LOCO
 #endif
 #ifndef MENU_ITEM_TEXT_MENU_TOGGLE_DIRECTION
    #define MENU_ITEM_TEXT_MENU_TOGGLE_DIRECTION       "# Toggle                      "
@@ -346,7 +477,6 @@ const int glyph_speed_step = 0x00d6;
 #ifndef MENU_ITEM_TEXT_MENU_EDIT_CONSIST
    #define MENU_ITEM_TEXT_MENU_EDIT_CONSIST           "no Chng Facing   * Close"
 #endif
-#define MENU_ITEM_TEXT_MENU_NA                     ""   // for items that don't require showing a menu
 
 
 #ifndef EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE
@@ -355,8 +485,8 @@ const int glyph_speed_step = 0x00d6;
 #ifndef EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST
    #define EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST           "Edt Consist"
 #endif
-#ifndef EXTRA_MENU_TEXT_CHAR_TBA
-   #define EXTRA_MENU_TEXT_CHAR_TBA                    "" 
+#ifndef EXTRA_MENU_TEXT_CHAR_LANGUAGE
+   #define EXTRA_MENU_TEXT_CHAR_LANGUAGE               "Language" 
 #endif
 #ifndef EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE
    #define EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE       "Heartbt Tgl"
@@ -379,6 +509,9 @@ const int glyph_speed_step = 0x00d6;
 #ifndef EXTRA_MENU_TEXT_CHAR_OFF_SLEEP
    #define EXTRA_MENU_TEXT_CHAR_OFF_SLEEP              "OFF / Sleep"
 #endif
+#ifndef MENU_ITEM_TEXT_TITLE_DIAGNOSTICS
+   #define MENU_ITEM_TEXT_TITLE_DIAGNOSTICS            "Diagnostics"
+#endif
 
 #define MENU_ITEM_TYPE_DIRECT_COMMAND 0
 #define MENU_ITEM_TYPE_SELECT_FROM_LIST 1
@@ -401,7 +534,7 @@ const int glyph_speed_step = 0x00d6;
 
    #define MENU_ITEM_FUNCTION_KEY_TOGGLE        'A'
    #define MENU_ITEM_EDIT_CONSIST               'B'
-   #define MENU_ITEM_TBA                        'C'
+   #define MENU_ITEM_LANGUAGE                   'C'
    #define MENU_ITEM_HEARTBEAT_TOGGLE           'D'
    #define MENU_ITEM_INCREASE_MAX_THROTTLES     'E'
    #define MENU_ITEM_DECREASE_MAX_THROTTLES     'F'
@@ -412,31 +545,31 @@ const int glyph_speed_step = 0x00d6;
 #endif
 
 #ifndef USER_DEFINED_MENUS
-   // menu item labels, menu to appear at the bottom of the screen
-   const String menuText[20][2] = {
-      {MENU_ITEM_TEXT_TITLE_FUNCTION,              MENU_ITEM_TEXT_MENU_FUNCTION},      //0
-      {MENU_ITEM_TEXT_TITLE_ADD_LOCO,              MENU_ITEM_TEXT_MENU_ADD_LOCO},      //1
-      {MENU_ITEM_TEXT_TITLE_DROP_LOCO,             MENU_ITEM_TEXT_MENU_DROP_LOCO_REAL},//2
-      {MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION,      MENU_ITEM_TEXT_MENU_NA},            //3
-      {MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER, MENU_ITEM_TEXT_MENU_NA},            //4
-      {MENU_ITEM_TEXT_TITLE_THROW_POINT,           MENU_ITEM_TEXT_MENU_THROW_POINT},   //5
-      {MENU_ITEM_TEXT_TITLE_CLOSE_POINT,           MENU_ITEM_TEXT_MENU_CLOSE_POINT},   //6
-      {MENU_ITEM_TEXT_TITLE_ROUTE,                 MENU_ITEM_TEXT_MENU_ROUTE},         //7
-      {MENU_ITEM_TEXT_TITLE_TRACK_POWER,           MENU_ITEM_TEXT_MENU_NA},            //8 
-      {MENU_ITEM_TEXT_TITLE_EXTRAS,                MENU_ITEM_TEXT_MENU_EXTRAS},        //9
-      {EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE,   MENU_ITEM_TEXT_MENU_NA},            // 10 A
-      {EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST,          MENU_ITEM_TEXT_MENU_EDIT_CONSIST},  // 11 B
-      {EXTRA_MENU_TEXT_CHAR_TBA,                   MENU_ITEM_TEXT_MENU_NA},            // 12 C
-      {EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE,      MENU_ITEM_TEXT_MENU_NA},            // 13 D
-      {EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES,MENU_ITEM_TEXT_MENU_NA},            // 14 E
-      {EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES,MENU_ITEM_TEXT_MENU_NA},            // 15 F
-      {EXTRA_MENU_TEXT_CHAR_DISCONNECT,            MENU_ITEM_TEXT_MENU_NA},            // 16 G
-      {EXTRA_MENU_TEXT_CHAR_OFF_SLEEP,             MENU_ITEM_TEXT_MENU_NA},            // 17 H
-      {EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE, MENU_ITEM_TEXT_MENU_NA},       // 18 I
-      {EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS,         MENU_ITEM_TEXT_MENU_NA}             // 19 J
+   // menu item labels, menu to appear at the bottom of the screen. (TEXT_... ids)
+   const int menuText[20][2] = {
+      {TEXT_MENU_ITEM_TEXT_TITLE_FUNCTION,                TEXT_MENU_ITEM_TEXT_MENU_FUNCTION},         //0
+      {TEXT_MENU_ITEM_TEXT_TITLE_ADD_LOCO,                TEXT_MENU_ITEM_TEXT_MENU_ADD_LOCO},         //1
+      {TEXT_MENU_ITEM_TEXT_TITLE_DROP_LOCO,               TEXT_MENU_ITEM_TEXT_MENU_DROP_LOCO_REAL},   //2
+      {TEXT_MENU_ITEM_TEXT_TITLE_TOGGLE_DIRECTION,        TEXT_EMPTY},                                //3
+      {TEXT_MENU_ITEM_TEXT_TITLE_SPEED_STEP_MULTIPLIER,   TEXT_EMPTY},                                //4
+      {TEXT_MENU_ITEM_TEXT_TITLE_THROW_POINT,             TEXT_MENU_ITEM_TEXT_MENU_THROW_POINT},      //5
+      {TEXT_MENU_ITEM_TEXT_TITLE_CLOSE_POINT,             TEXT_MENU_ITEM_TEXT_MENU_CLOSE_POINT},      //6
+      {TEXT_MENU_ITEM_TEXT_TITLE_ROUTE,                   TEXT_MENU_ITEM_TEXT_MENU_ROUTE},            //7
+      {TEXT_MENU_ITEM_TEXT_TITLE_TRACK_POWER,             TEXT_EMPTY},                                //8 
+      {TEXT_MENU_ITEM_TEXT_TITLE_EXTRAS,                  TEXT_MENU_ITEM_TEXT_MENU_EXTRAS},           //9
+      {TEXT_EXTRA_MENU_TEXT_CHAR_FUNCTION_KEY_TOGGLE,     TEXT_EMPTY},                                // 10 A
+      {TEXT_EXTRA_MENU_TEXT_CHAR_EDIT_CONSIST,            TEXT_MENU_ITEM_TEXT_MENU_EDIT_CONSIST},     // 11 B
+      {TEXT_EXTRA_MENU_TEXT_CHAR_LANGUAGE,                TEXT_EMPTY},                                // 12 C
+      {TEXT_EXTRA_MENU_TEXT_CHAR_HEARTBEAT_TOGGLE,        TEXT_EMPTY},                                // 13 D
+      {TEXT_EXTRA_MENU_TEXT_CHAR_INCREASE_MAX_THROTTLES,  TEXT_EMPTY},                                // 14 E
+      {TEXT_EXTRA_MENU_TEXT_CHAR_DECREASE_MAX_THROTTLES,  TEXT_EMPTY},                                // 15 F
+      {TEXT_EXTRA_MENU_TEXT_CHAR_DISCONNECT,              TEXT_EMPTY},                                // 16 G
+      {TEXT_EXTRA_MENU_TEXT_CHAR_OFF_SLEEP,               TEXT_EMPTY},                                // 17 H
+      {TEXT_EXTRA_MENU_TEXT_CHAR_DROP_BEFORE_ACQUIRE_TOGGLE,TEXT_EMPTY},                                // 18 I
+      {TEXT_EXTRA_MENU_TEXT_SAVE_CURRENT_LOCOS,           TEXT_EMPTY}                                 // 19 J
    };
 #else 
-   const String menuText[20][2] = MENU_STRUCTURE;
+   const char* const menuText[20][2] = MENU_STRUCTURE;  // not translated
 #endif
 
 #ifndef USER_DEFINED_MENUS
@@ -495,6 +628,20 @@ const int glyph_speed_step = 0x00d6;
    #define SPEED_STEP_ADDITIONAL_MULTIPLIER 2
 #endif
 
+// momentum
+#ifndef USE_MOMENTUM
+   #define USE_MOMENTUM false
+#endif
+#ifndef MOMENTUM_ACCELERATION
+   #define MOMENTUM_ACCELERATION 20         // speed steps per second
+#endif
+#ifndef MOMENTUM_BRAKING
+   #define MOMENTUM_BRAKING 40              // speed steps per second
+#endif
+#ifndef MOMENTUM_COMMAND_INTERVAL
+   #define MOMENTUM_COMMAND_INTERVAL 100    // milliseconds
+#endif
+
 #ifdef  DISPLAY_SPEED_AS_PERCENT
   const bool speedDisplayAsPercent = DISPLAY_SPEED_AS_PERCENT;
 #else
@@ -516,6 +663,16 @@ String witServerIpAndPortEntryMask = "###.###.###.###:#####";
 #ifndef SSID_CONNECTION_TIMEOUT 
   #define SSID_CONNECTION_TIMEOUT 10000
 #endif
+#ifndef SSID_FAST_SCAN_KNOWN_CHANNELS
+  #define SSID_FAST_SCAN_KNOWN_CHANNELS true
+#endif
+#ifndef SSID_SCAN_TIME_PER_CHANNEL
+  #define SSID_SCAN_TIME_PER_CHANNEL 300
+#endif
+#define SSID_SCAN_TIMEOUT 10000           // give up on a scan that has not finished
+#define FOUND_SSIDS_HASH_SIZE 128         // power of 2, at least twice maxFoundSsids
+#define SSID_SCAN_MAX_CHANNELS 14
+#define NVS_SSID_CHANNELS_KEY "ssidChannels"
 
 const char ssidPasswordBlankChar = 164;
 
@@ -560,6 +717,57 @@ const char ssidPasswordBlankChar = 164;
   #define DEBUG_LEVEL   1
 #endif
 
+#define DEBUG_LEVEL_ERRORS    0
+#define DEBUG_LEVEL_DEFAULT   1
+#define DEBUG_LEVEL_VERBOSE   2
+#define DEBUG_LEVEL_EXTREME   3
+
+#ifndef LOG_LEVEL_THROTTLE
+  #define LOG_LEVEL_THROTTLE   DEBUG_LEVEL    // speed, direction and momentum
+#endif
+#ifndef LOG_LEVEL_SERVER
+  #define LOG_LEVEL_SERVER     DEBUG_LEVEL    // messages received from the server
+#endif
+#ifndef LOG_LEVEL_INPUT
+  #define LOG_LEVEL_INPUT      DEBUG_LEVEL    // throttle pot, encoder and buttons
+#endif
+
+#ifndef ASYNC_LOG
+  #define ASYNC_LOG true
+#endif
+
+#ifndef LATENCY_BENCHMARK
+  #define LATENCY_BENCHMARK false
+#endif
+
+#ifndef USE_ASYNC_DISPLAY
+  #define USE_ASYNC_DISPLAY false
+#endif
+
+#ifndef OLED_FRAME_BUFFER_SIZE
+  #define OLED_FRAME_BUFFER_SIZE 1024    // 128x64 full buffer
+#endif
+
+#ifndef LATENCY_BENCHMARK_SAMPLES
+  #define LATENCY_BENCHMARK_SAMPLES 64
+#endif
+
+#ifndef LATENCY_BENCHMARK_REPORT_INTERVAL
+  #define LATENCY_BENCHMARK_REPORT_INTERVAL 30000
+#endif
+
+#ifndef SESSION_RECORDER
+  #define SESSION_RECORDER false
+#endif
+
+#ifndef SERIAL_API
+  #define SERIAL_API false
+#endif
+
+#ifndef SESSION_REPLAY_LINE_SIZE
+  #define SESSION_REPLAY_LINE_SIZE 2048
+#endif
+
 // *******************************************************************************************************************
 
 #ifndef AUTO_CONNECT_TO_FIRST_DEFINED_SERVER
@@ -574,10 +782,44 @@ const char ssidPasswordBlankChar = 164;
   #define OUTBOUND_COMMANDS_MINIMUM_DELAY 50
 #endif
 
+#ifndef USE_DCC_EX_NATIVE_PROTOCOL
+  #define USE_DCC_EX_NATIVE_PROTOCOL false
+#endif
+
+#ifndef DCC_EX_MOMENTARY_FUNCTIONS
+  #define DCC_EX_MOMENTARY_FUNCTIONS (1UL<<2)   // one bit per function
+#endif
+
+#ifndef WIT_STREAM_FAST_PARSE
+  #define WIT_STREAM_FAST_PARSE true
+#endif
+
+#ifndef OUTBOUND_QUEUE_SIZE
+  #define OUTBOUND_QUEUE_SIZE 16
+#endif
+
+#ifndef ACQUIRE_QUEUE_SIZE
+  #define ACQUIRE_QUEUE_SIZE (THROTTLE_POOL_SIZE * MAX_LOCOS)   // every loco of every throttle
+#endif
+
+#ifndef ACQUIRE_SETTLE_TIME
+  #define ACQUIRE_SETTLE_TIME 200   // ms without a reply before an acquisition is treated as complete
+#endif
+
+#ifndef ACQUIRE_SETTLE_MAX
+  #define ACQUIRE_SETTLE_MAX 3000   // ms after the last was sent, the longest an acquisition waits for its replies
+#endif
+
 #ifndef SEND_LEADING_CR_LF_FOR_COMMANDS
   #define SEND_LEADING_CR_LF_FOR_COMMANDS true
 #endif
 
+#ifndef ENCODER_FAST_DETENTS_PER_SECOND
+  #define ENCODER_FAST_DETENTS_PER_SECOND 25
+#endif
+
+#define ENCODER_RING_SIZE 32   // must be a power of 2
+
 #ifndef ROTARY_ENCODER_DEBOUNCE_TIME
   #define ROTARY_ENCODER_DEBOUNCE_TIME 200
 #endif
@@ -724,6 +966,17 @@ const char ssidPasswordBlankChar = 164;
 #ifndef MAX_THROTTLES
     #define MAX_THROTTLES 2  // default if not defined in config_buttons.h
 #endif
+#ifndef THROTTLE_POOL_SIZE
+    #define THROTTLE_POOL_SIZE 6  // the most throttles that can be used. Memory is reserved for each
+#endif
+#if (THROTTLE_POOL_SIZE < 1) || (THROTTLE_POOL_SIZE > 10)
+    #error "THROTTLE_POOL_SIZE must be 1 to 10"
+#endif
+#if MAX_THROTTLES > THROTTLE_POOL_SIZE
+    #error "MAX_THROTTLES can't be more than THROTTLE_POOL_SIZE"
+#endif
+
+#define NVS_LEGACY_MAX_THROTTLES 6   // older versions saved the locos of up to 6 throttles
 
 #ifndef ENCODER_BUTTON_ACTION
     #define ENCODER_BUTTON_ACTION SPEED_STOP_THEN_TOGGLE_DIRECTION  // default if not defined in config_buttons.h
@@ -1084,6 +1337,85 @@ const char ssidPasswordBlankChar = 164;
    #define RESTORE_ACQUIRED_LOCOS true
 #endif
 
+#ifndef AUTO_SAVE_ACQUIRED_LOCOS
+   #define AUTO_SAVE_ACQUIRED_LOCOS false
+#endif
+
+#ifndef AUTO_SAVE_ACQUIRED_LOCOS_INTERVAL
+   #define AUTO_SAVE_ACQUIRED_LOCOS_INTERVAL 2000
+#endif
+
+#define NVS_LOCO_RECORD_KEY "locos"
+#define NVS_LOCO_RECORD_VERSION 1   // change if the record layout changes
+#define NVS_LOCO_RECORD_SIZE 512
+
+#ifndef USE_FAST_RESUME
+   #define USE_FAST_RESUME true
+#endif
+
+#define FAST_RESUME_MAGIC 0x57695402   // change if the snapshot layout changes
+
+#ifndef ROAMING_ENABLED
+   #define ROAMING_ENABLED false
+#endif
+#ifndef ROAMING_RSSI_THRESHOLD
+   #define ROAMING_RSSI_THRESHOLD -72     // dBm. move if the signal is weaker than this
+#endif
+#ifndef ROAMING_PRESCAN_RSSI
+   #define ROAMING_PRESCAN_RSSI -67       // dBm. start looking for other access points
+#endif
+#ifndef ROAMING_RSSI_MARGIN
+   #define ROAMING_RSSI_MARGIN 8          // dB. how much stronger the other access point must be
+#endif
+#ifndef ROAMING_SAMPLE_INTERVAL
+   #define ROAMING_SAMPLE_INTERVAL 1000
+#endif
+#ifndef ROAMING_SCAN_INTERVAL
+   #define ROAMING_SCAN_INTERVAL 20000
+#endif
+#ifndef ROAMING_SCAN_TIME_PER_CHANNEL
+   #define ROAMING_SCAN_TIME_PER_CHANNEL 60   // short, as the throttle is off its channel while scanning
+#endif
+#ifndef ROAMING_SILENT_TIME
+   #define ROAMING_SILENT_TIME 5000       // nothing received from the server for this long is a poor link
+#endif
+#define ROAMING_CANDIDATE_MAX_AGE 30000
+#define ROAMING_DISCONNECT_TIMEOUT 1000   // waiting to leave the old access point
+#ifndef ROAMING_CONNECTION_TIMEOUT
+   #define ROAMING_CONNECTION_TIMEOUT 4000   // to join the new access point, and per attempt (two) when reconnecting
+#endif
+#define ROAMING_STATE_IDLE 0
+#define ROAMING_STATE_LEAVING 1           // waiting to leave the old access point
+#define ROAMING_STATE_JOINING 2           // waiting to join the new one
+
+#ifndef SHOW_LINK_INDICATOR
+   #define SHOW_LINK_INDICATOR true
+#endif
+#define LINK_RTT_SAMPLES 32               // the percentiles are over the most recent samples
+#define LINK_PROBE_TIMEOUT 5000           // no echo in this time counts as lost
+#define LINK_TELEMETRY_INTERVAL 1000
+
+#define LINK_PROBE_SPEED 0
+#define LINK_PROBE_DIRECTION 1
+#define LINK_PROBE_FUNCTION 2
+#define LINK_PROBE_COUNT 3
+#define ROAMING_HOLD_OFF 30000            // after moving, before moving again
+
+#ifndef METRICS_UDP
+  #define METRICS_UDP false
+#endif
+#ifndef METRICS_UDP_HOST
+  #define METRICS_UDP_HOST ""             // "" = broadcast
+#endif
+#ifndef METRICS_UDP_PORT
+  #define METRICS_UDP_PORT 12095
+#endif
+#ifndef METRICS_UDP_INTERVAL
+  #define METRICS_UDP_INTERVAL 5000
+#endif
+#define METRICS_DATAGRAM_VERSION 1        // change with any change to the layout. See metricsSend()
+#define METRICS_DATAGRAM_SIZE 256
+
 #ifndef CONSIST_RELEASE_BY_INDEX
    #define CONSIST_RELEASE_BY_INDEX true
 #endif
\ No newline at end of file
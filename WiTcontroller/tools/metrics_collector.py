@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""
+Collect the metrics sent by WiTcontrollers and show them together.
+
+The WiTcontrollers must be built with  #define METRICS_UDP true  (see config_network.h)
+Run this on a computer on the same network:
+
+    python3 metrics_collector.py
+    python3 metrics_collector.py --port 12095 --refresh 10 --csv session.csv
+
+Every --refresh seconds a table shows each handset's latest figures, with flags for the
+ones that look like trouble:
+  RSSI   weak signal (average below --rssi dBm)
+  RTT    slow round trips to the server (p99 above --rtt ms)
+  LOOP   a slow loop (longest above --loop ms)
+  HEAP   low memory (lowest free below --heap KB)
+  LOST   commands with no reply from the server since the last datagram
+  RECON  reconnected to the WiFi or the server since the last datagram
+  MISS   datagrams missing (sequence gap)
+  STALE  nothing heard for --stale seconds
+With --csv every datagram is also written to the file.
+
+No extra packages are needed.  See metricsSend() in WiTcontroller.ino for the datagram layout.
+"""
+
+import argparse
+import csv
+import socket
+import struct
+import time
+
+VERSION = 1
+STAGE_NAMES = ['network', 'scheduler', 'input', 'replay', 'other', 'flush']
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+
+    def take(self, fmt):
+        values = struct.unpack_from('<' + fmt, self.data, self.offset)
+        self.offset += struct.calcsize('<' + fmt)
+        return values if len(values) > 1 else values[0]
+
+
+def parse(data):
+    """returns a dict, or None if it isn't a WiTcontroller metrics datagram"""
+    if len(data) < 4 or data[0:3] != b'WTM' or data[3] != VERSION:
+        return None
+    r = Reader(data)
+    r.take('4s')
+    m = {}
+    try:
+        m['mac'] = ':'.join('%02x' % b for b in r.take('6B'))
+        m['sequence'], m['uptime'], m['period'] = r.take('III')
+        m['loops'], m['loop_max'] = r.take('II')
+        stages = r.take('B')
+        m['stages'] = [r.take('II') for _ in range(stages)]
+        m['heap_free'], m['heap_min'], m['heap_max_alloc'] = r.take('III')
+        m['rtt_p50'], m['rtt_p90'], m['rtt_p99'] = [None if v == 0xFFFF else v for v in r.take('HHH')]
+        m['rtt_answered'], m['rtt_lost'] = r.take('II')
+        m['rssi'], m['rssi_avg'], m['rssi_min'], m['battery'] = r.take('bbbb')
+        m['wifi_connects'], m['server_connects'], m['roams'] = r.take('HHH')
+        m['ssid_state'], m['server_state'] = r.take('BB')
+        m['commands'], m['lines'], m['bytes_sent'], m['bytes_received'] = r.take('IIII')
+        name_length = r.take('B')
+        m['name'] = r.take('%ds' % name_length).decode('utf-8', errors='replace')
+    except struct.error:
+        return None
+    return m
+
+
+class Handset:
+    def __init__(self):
+        self.latest = None
+        self.previous = None
+        self.address = ''
+        self.last_heard = 0
+        self.missed = 0
+        self.flags = set()
+
+    def update(self, m, address, args):
+        self.previous, self.latest = self.latest, m
+        self.address = address
+        self.last_heard = time.time()
+        self.flags = set()
+        p = self.previous
+        if p is not None:
+            if m['uptime'] < p['uptime']:
+                p = None   # restarted
+            elif m['sequence'] > p['sequence'] + 1:
+                self.missed += m['sequence'] - p['sequence'] - 1
+                self.flags.add('MISS')
+        if m['rssi_avg'] < args.rssi and m['rssi_avg'] != 0:
+            self.flags.add('RSSI')
+        if m['rtt_p99'] is not None and m['rtt_p99'] > args.rtt:
+            self.flags.add('RTT')
+        if m['loop_max'] > args.loop * 1000:
+            self.flags.add('LOOP')
+        if m['heap_min'] < args.heap * 1024:
+            self.flags.add('HEAP')
+        if p is not None:
+            if m['rtt_lost'] > p['rtt_lost']:
+                self.flags.add('LOST')
+            if m['wifi_connects'] > p['wifi_connects'] or m['server_connects'] > p['server_connects']:
+                self.flags.add('RECON')
+
+    def rate(self, key):
+        """per second since the previous datagram. The counters restart with each server connection"""
+        m, p = self.latest, self.previous
+        if p is None or m['period'] == 0 or m[key] < p[key]:
+            return None
+        return (m[key] - p[key]) * 1000.0 / m['period']
+
+
+def show(handsets, args):
+    now = time.time()
+    print('\n%s  %d handsets' % (time.strftime('%H:%M:%S'), len(handsets)))
+    print('%-16s %-15s %6s %7s %8s %-19s %9s %9s %10s %5s %5s %7s %6s  %s' % (
+        'name', 'address', 'up', 'loops/s', 'loop max', 'slowest stage', 'heap KB', 'rtt p50/99',
+        'rssi/min', 'batt', 'lost', 'recon', 'cmd/s', 'flags'))
+    for mac in sorted(handsets, key=lambda k: handsets[k].latest['name']):
+        h = handsets[mac]
+        m = h.latest
+        flags = set(h.flags)
+        if now - h.last_heard > args.stale:
+            flags.add('STALE')
+        slowest = max(range(len(m['stages'])), key=lambda i: m['stages'][i][1])
+        stage = '%s %d/%dms' % (STAGE_NAMES[slowest] if slowest < len(STAGE_NAMES) else slowest,
+                                m['stages'][slowest][0] // 1000, m['stages'][slowest][1] // 1000)
+        commands = h.rate('commands')
+        print('%-16s %-15s %5dm %7.0f %6.1fms %-19s %4d/%-4d %4s/%-4s %4d/%-5d %5s %5d %2d/%d/%d %6s  %s' % (
+            m['name'][:16], h.address, m['uptime'] // 60000,
+            m['loops'] * 1000.0 / m['period'] if m['period'] else 0, m['loop_max'] / 1000.0, stage,
+            m['heap_free'] // 1024, m['heap_min'] // 1024,
+            '-' if m['rtt_p50'] is None else m['rtt_p50'], '-' if m['rtt_p99'] is None else m['rtt_p99'],
+            m['rssi_avg'], m['rssi_min'], '-' if m['battery'] < 0 else '%d%%' % m['battery'], m['rtt_lost'],
+            max(m['wifi_connects'] - 1, 0), max(m['server_connects'] - 1, 0), m['roams'],
+            '-' if commands is None else '%.1f' % commands,
+            ' '.join(sorted(flags))))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Collect WiTcontroller metrics')
+    parser.add_argument('--port', type=int, default=12095)
+    parser.add_argument('--refresh', type=float, default=10, help='seconds between tables')
+    parser.add_argument('--csv', help='also write every datagram to this file')
+    parser.add_argument('--stale', type=float, default=30, help='seconds without a datagram')
+    parser.add_argument('--rssi', type=int, default=-75, help='dBm')
+    parser.add_argument('--rtt', type=int, default=500, help='ms')
+    parser.add_argument('--loop', type=int, default=100, help='ms')
+    parser.add_argument('--heap', type=int, default=20, help='KB')
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(('', args.port))
+    sock.settimeout(1)
+
+    csv_file = open(args.csv, 'a', newline='') if args.csv else None
+    csv_writer = None
+    handsets = {}
+    next_show = time.time() + args.refresh
+    print('listening on UDP port %d' % args.port)
+    try:
+        while True:
+            try:
+                data, (address, _) = sock.recvfrom(1024)
+                m = parse(data)
+                if m is not None:
+                    handsets.setdefault(m['mac'], Handset()).update(m, address, args)
+                    if csv_file:
+                        row = dict(m, time=time.time(), address=address)
+                        for i, (avg, longest) in enumerate(row.pop('stages')):
+                            name = STAGE_NAMES[i] if i < len(STAGE_NAMES) else str(i)
+                            row['stage_%s_avg' % name] = avg
+                            row['stage_%s_max' % name] = longest
+                        if csv_writer is None:
+                            csv_writer = csv.DictWriter(csv_file, fieldnames=list(row.keys()))
+                            csv_writer.writeheader()
+                        csv_writer.writerow(row)
+                        csv_file.flush()
+            except socket.timeout:
+                pass
+            if time.time() >= next_show:
+                next_show = time.time() + args.refresh
+                if handsets:
+                    show(handsets, args)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if csv_file:
+            csv_file.close()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+"""
+A stand-in WiThrottle server, to time what a WiTcontroller sends without a real layout.
+
+    python3 mock_server.py
+    python3 mock_server.py --port 12090 --roster 10
+    python3 mock_server.py --dcc-ex --port 2560
+
+Connect the WiTcontroller to this computer's IP address and port (enter it with the '#' key on the
+server selection, or add it to config_network.h).  Nothing is announced over mDNS.
+
+Acquired locos are kept per throttle, and speed, direction, function and query commands are
+answered the way JMRI does (one reply per loco), so consists, facing and the screens behave normally.
+
+With --dcc-ex it describes itself as a DCC-EX EX-CommandStation, so a WiTcontroller built with
+USE_DCC_EX_NATIVE_PROTOCOL true sends native commands, and it answers those the way the command station
+does: <t ...> and <F ...> with an <l cab reg speedByte functions> broadcast, <1>/<0> with <p1>/<p0>,
+<T id state> with <H id state>.
+
+To compare the native and WiThrottle paths, run the same serial_scenario.py scenario against it with
+USE_DCC_EX_NATIVE_PROTOCOL true and false, then compare the bursts below (commands and bytes per action)
+and the round trip times from  #GET METRICS  (the native commands are answered by the <l> broadcast).
+
+Every command received is printed with the time since the previous one.  The commands that arrive
+close together (less than --gap ms apart) are counted as one burst, and each burst is summarised:
+  commands   lines received
+  bytes      including the line ends
+  writes     TCP segments they arrived in
+  span       ms from the first to the last
+  reverse    for a consist reversal: ms from the first direction command to the last one
+             (i.e. until every loco in the consist has been told)
+  acquire    for acquisitions: the locos acquired, and locos/s from the first acquire to the
+             last direction query answered (compare with acquire_locos and acquire_ms in  #GET METRICS)
+
+No extra packages are needed.
+"""
+
+import argparse
+import socket
+import time
+
+SEPARATOR = '<;>'
+
+
+class Throttle:
+    def __init__(self):
+        self.locos = []          # in order, the lead first
+        self.speed = 0
+
+
+class Session:
+    def __init__(self, connection, address, args):
+        self.connection = connection
+        self.address = address
+        self.args = args
+        self.throttles = {}
+        self.direction = {}      # loco: 1 forward, 0 reverse
+        self.functions = {}      # loco: set of functions that are on
+        self.cabs = {}           # DCC-EX native. cab: [speed, direction, function bits]
+        self.buffer = b''
+        self.burst = []          # (time, line, segment)
+        self.segment = 0
+        self.last_time = None
+
+    def send(self, line):
+        self.connection.sendall((line + '\n').encode())
+
+    def start(self):
+        self.send('VN2.0')
+        self.send('HtDCC-EX v5.0.0 Mock' if self.args.dcc_ex else 'HtMock-WiThrottle 1.0')
+        roster = ['RL%d' % self.args.roster]
+        for i in range(self.args.roster):
+            number = 3 + i
+            roster.append(']\\[Loco %d}|{%d}|{%s' % (number, number, 'L' if number > 127 else 'S'))
+        self.send(''.join(roster))
+        self.send('PPA1')
+        self.send('*%d' % self.args.heartbeat)
+
+    # *****************************************************************
+    # commands
+
+    def received(self, line, now):
+        if self.last_time is not None and (now - self.last_time) * 1000 > self.args.gap:
+            self.summarise()
+        gap = '' if self.last_time is None else '+%.1fms' % ((now - self.last_time) * 1000)
+        self.last_time = now
+        self.burst.append((now, line, self.segment))
+        if not (line.startswith('*') and not self.args.verbose):
+            print('%-10s %s' % (gap, line))
+
+        if line.startswith('M') and len(line) > 2:
+            self.multi_throttle(line)
+        elif line.startswith('PPA'):
+            self.send(line)
+        elif line.startswith('<') and self.args.dcc_ex:
+            self.native(line)
+
+    def multi_throttle(self, line):
+        throttle_char, action = line[1], line[2]
+        throttle = self.throttles.setdefault(throttle_char, Throttle())
+        key, _, command = line[3:].partition(SEPARATOR)
+        prefix = 'M' + throttle_char
+
+        if action == '+':
+            if key not in throttle.locos:
+                throttle.locos.append(key)
+            self.direction.setdefault(key, 1)
+            self.functions.setdefault(key, set())
+            self.send(prefix + '+' + key + SEPARATOR)
+            self.send(prefix + 'L' + key + SEPARATOR + ']\\[Headlight]\\[Bell]\\[Horn' + ']\\[' * 26)
+            for function in range(29):
+                self.send(prefix + 'A' + key + SEPARATOR + 'F%d%d' % (1 if function in self.functions[key] else 0, function))
+            self.send(prefix + 'A' + key + SEPARATOR + 'V%d' % throttle.speed)
+            self.send(prefix + 'A' + key + SEPARATOR + 'R%d' % self.direction[key])
+            self.send(prefix + 'A' + key + SEPARATOR + 's1')
+        elif action == '-':
+            for loco in self.locos(throttle, key):
+                throttle.locos.remove(loco)
+                self.send(prefix + '-' + loco + SEPARATOR)
+        elif action == 'A':
+            self.throttle_action(prefix, throttle, key, command)
+
+    def locos(self, throttle, key):
+        return list(throttle.locos) if key == '*' else [key] if key in throttle.locos else []
+
+    def throttle_action(self, prefix, throttle, key, command):
+        locos = self.locos(throttle, key)
+        if command.startswith('V'):
+            throttle.speed = int(command[1:])
+            for loco in locos:
+                self.send(prefix + 'A' + loco + SEPARATOR + command)
+        elif command.startswith('X'):
+            throttle.speed = 0
+            for loco in locos:
+                self.send(prefix + 'A' + loco + SEPARATOR + 'V-1')
+        elif command.startswith('R'):
+            for loco in locos:
+                self.direction[loco] = int(command[1:])
+                self.send(prefix + 'A' + loco + SEPARATOR + command)
+        elif command.startswith('F') or command.startswith('f'):
+            pressed, function = command[1] == '1', int(command[2:])
+            for loco in locos:
+                on = self.functions[loco]
+                if command[0] == 'f':    # forced
+                    on.add(function) if pressed else on.discard(function)
+                elif pressed:
+                    on.symmetric_difference_update({function})
+                else:
+                    continue
+                self.send(prefix + 'A' + loco + SEPARATOR + 'F%d%d' % (1 if function in on else 0, function))
+        elif command == 'qV':
+            for loco in locos:
+                self.send(prefix + 'A' + loco + SEPARATOR + 'V%d' % throttle.speed)
+        elif command == 'qR':
+            for loco in locos:
+                self.send(prefix + 'A' + loco + SEPARATOR + 'R%d' % self.direction[loco])
+
+    # *****************************************************************
+    # DCC-EX native commands
+
+    def native(self, line):
+        values = line.strip('<>').split()
+        if not values:
+            return
+        command = values[0]
+        if command == 't' and len(values) >= 4:
+            cab = self.cab(values[1])
+            cab[0], cab[1] = int(values[2]), int(values[3])
+            self.broadcast(values[1])
+        elif command == 'F' and len(values) >= 4:
+            cab = self.cab(values[1])
+            bit = 1 << int(values[2])
+            cab[2] = (cab[2] | bit) if values[3] == '1' else (cab[2] & ~bit)
+            self.broadcast(values[1])
+        elif command == '!':
+            for number in self.cabs:
+                self.cabs[number][0] = -1
+                self.broadcast(number)
+        elif command in ('1', '0'):
+            self.send('<p%s>' % command)
+            self.send('PPA%s' % command)
+        elif command == 'T' and len(values) >= 3:
+            self.send('<H %s %s>' % (values[1], values[2]))
+
+    def cab(self, number):
+        return self.cabs.setdefault(number, [0, 1, 0])
+
+    def broadcast(self, number):
+        speed, direction, functions = self.cabs[number]
+        speed_byte = 1 if speed < 0 else (0 if speed == 0 else speed + 1)
+        self.send('<l %s 0 %d %d>' % (number, speed_byte | (0x80 if direction else 0), functions))
+
+    # *****************************************************************
+    # timing
+
+    def summarise(self):
+        lines = [entry for entry in self.burst if not entry[1].startswith('*')]
+        self.burst = []
+        directions = [entry[0] for entry in lines if SEPARATOR + 'R' in entry[1]]
+        acquires = [entry[0] for entry in lines if entry[1][:1] == 'M' and entry[1][2:3] == '+']
+        queries = [entry[0] for entry in lines if entry[1].endswith(SEPARATOR + 'qR')]
+        if len(lines) < 2 and len(directions) == 0:
+            return
+        first, last = lines[0][0], lines[-1][0]
+        summary = '  burst: %d commands, %d bytes, %d writes, span %.1fms' % (
+            len(lines), sum(len(entry[1]) + 1 for entry in lines), len(set(entry[2] for entry in lines)), (last - first) * 1000)
+        if len(directions) > 0:
+            summary += ', reverse %.1fms (%d direction commands)' % ((directions[-1] - directions[0]) * 1000, len(directions))
+        if len(acquires) > 0 and len(queries) > 0:
+            elapsed = max(queries[-1] - acquires[0], 0.001)
+            summary += ', acquire %d locos in %.1fms, %.1f locos/s' % (len(acquires), elapsed * 1000, len(acquires) / elapsed)
+        print(summary)
+
+    def run(self):
+        self.start()
+        self.connection.settimeout(0.2)
+        while True:
+            try:
+                data = self.connection.recv(4096)
+            except socket.timeout:
+                if self.last_time is not None and (time.time() - self.last_time) * 1000 > self.args.gap:
+                    self.summarise()
+                continue
+            if not data:
+                break
+            now = time.time()
+            self.segment += 1
+            self.buffer += data
+            while b'\n' in self.buffer:
+                line, self.buffer = self.buffer.split(b'\n', 1)
+                line = line.decode('utf-8', errors='replace').strip('\r')
+                if line:
+                    self.received(line, now)
+        self.summarise()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Stand-in WiThrottle server')
+    parser.add_argument('--port', type=int, default=12090)
+    parser.add_argument('--roster', type=int, default=6, help='number of roster entries')
+    parser.add_argument('--dcc-ex', action='store_true', help='act as a DCC-EX EX-CommandStation')
+    parser.add_argument('--heartbeat', type=int, default=10, help='seconds')
+    parser.add_argument('--gap', type=float, default=150, help='ms between commands that ends a burst')
+    parser.add_argument('--verbose', action='store_true', help='show the heartbeats too')
+    args = parser.parse_args()
+
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(('', args.port))
+    server.listen(1)
+    print('listening on port %d' % args.port)
+    try:
+        while True:
+            connection, address = server.accept()
+            connection.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            print('connected: %s' % address[0])
+            try:
+                Session(connection, address, args).run()
+            except (ConnectionError, OSError) as error:
+                print('connection lost: %s' % error)
+            connection.close()
+            print('disconnected')
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""
+Run a scenario of serial API commands on a WiTcontroller.
+
+The WiTcontroller must be built with  #define SERIAL_API true  (see config_buttons.h)
+
+A scenario is a text file with one serial API command per line, e.g.
+
+    ; acquire, run up, stop
+    #MENU 13
+    wait 2000
+    #ENC 10
+    wait 500
+    #ACTION 40
+    #GET THROTTLES
+
+  'wait <ms>' pauses, ';' starts a comment.  Add  --repeat  to run it more than once.
+
+    python3 serial_scenario.py /dev/ttyUSB0 scenario.txt
+    python3 serial_scenario.py /dev/ttyUSB0 scenario.txt --repeat 10 --metrics
+
+Each command is printed with its results and the time (ms) until the WiTcontroller answered.
+With --metrics the '#GET METRICS' results are printed at the end.
+
+Needs pyserial  (pip install pyserial)
+"""
+
+import argparse
+import sys
+import time
+
+import serial
+
+
+def read_line(port):
+    line = port.readline()
+    return line.decode('utf-8', errors='replace').rstrip('\r\n')
+
+
+def send(port, command, timeout=10):
+    """send a command and return (ok, result lines, ms)"""
+    port.write((command + '\n').encode())
+    start = time.time()
+    results = []
+    while time.time() - start < timeout:
+        line = read_line(port)
+        if line == '#OK' or line.startswith('#ERR'):
+            return line == '#OK', results, (time.time() - start) * 1000
+        if line.startswith('#') and not line.startswith('#REC '):
+            results.append(line)
+    return False, results, None
+
+
+def run(port, steps, verbose):
+    failures = 0
+    for step in steps:
+        if step.startswith('wait '):
+            time.sleep(int(step.split(' ')[1]) / 1000.0)
+            continue
+        ok, results, ms = send(port, step)
+        if ms is None:
+            sys.exit('no answer to %s. Is SERIAL_API enabled?' % step)
+        if not ok:
+            failures += 1
+        if verbose or not ok or results:
+            print('%-30s %s %6.1fms' % (step, 'ok ' if ok else 'ERR', ms))
+            for line in results:
+                print('    ' + line)
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Run serial API commands on a WiTcontroller')
+    parser.add_argument('port', help='serial port e.g. /dev/ttyUSB0 or COM3')
+    parser.add_argument('file', help='scenario file')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--repeat', type=int, default=1)
+    parser.add_argument('--metrics', action='store_true', help='show the metrics at the end')
+    parser.add_argument('--verbose', action='store_true', help='show every command, not just the ones with results')
+    args = parser.parse_args()
+
+    with open(args.file) as scenario:
+        steps = [line.split(';')[0].strip() for line in scenario]
+    steps = [step for step in steps if step]
+
+    with serial.Serial(args.port, args.baud, timeout=1) as port:
+        start = time.time()
+        failures = 0
+        for _ in range(args.repeat):
+            failures += run(port, steps, args.verbose)
+        print('ran %d steps x %d in %.1fs. %d failed' % (len(steps), args.repeat, time.time() - start, failures))
+
+        if args.metrics:
+            ok, results, ms = send(port, '#GET METRICS')
+            for line in results:
+                print(line)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+Record and replay WiTcontroller sessions over the serial console.
+
+The WiTcontroller must be built with  #define SESSION_RECORDER true  (see config_buttons.h)
+
+  Record (Ctrl-C to stop):
+    python3 session_replay.py record /dev/ttyUSB0 session.txt
+
+  Replay at the original speed, or faster (0 = as fast as possible):
+    python3 session_replay.py replay /dev/ttyUSB0 session.txt
+    python3 session_replay.py replay /dev/ttyUSB0 session.txt --speed 10
+
+The replay prints the loop stage timings reported by the WiTcontroller at the end.
+Keep the captures of problem sessions so they can be replayed after changes.
+
+Needs pyserial  (pip install pyserial)
+"""
+
+import argparse
+import sys
+import time
+
+import serial
+
+
+def read_line(port):
+    line = port.readline()
+    return line.decode('utf-8', errors='replace').rstrip('\r\n')
+
+
+def record(args):
+    with serial.Serial(args.port, args.baud, timeout=1) as port, open(args.file, 'w') as capture:
+        port.write(b'#RECORD ON\n')
+        count = 0
+        try:
+            while True:
+                line = read_line(port)
+                if line.startswith('#REC '):
+                    capture.write(line + '\n')
+                    count += 1
+                elif line and args.verbose:
+                    print(line)
+        except KeyboardInterrupt:
+            pass
+        print('recorded %d events to %s' % (count, args.file))
+
+
+def wait_for(port, wanted, timeout):
+    end = time.time() + timeout
+    while time.time() < end:
+        line = read_line(port)
+        if line.startswith(wanted):
+            return True
+        if line.startswith('#REPORT') or line.startswith('#REPLAY'):
+            print(line)
+    return False
+
+
+def replay(args):
+    with open(args.file) as capture:
+        events = [line.rstrip('\r\n') for line in capture if line.startswith('#REC ')]
+    if not events:
+        sys.exit('no #REC lines in ' + args.file)
+
+    with serial.Serial(args.port, args.baud, timeout=1) as port:
+        port.write(('#REPLAY %g\n' % args.speed).encode())
+        if not wait_for(port, '#NEXT', 5):
+            sys.exit('no reply from the WiTcontroller. Is SESSION_RECORDER enabled?')
+
+        start = time.time()
+        previous = None
+        for i, event in enumerate(events):
+            port.write((event + '\n').encode())
+            # the WiTcontroller holds each event until it is due, so allow for the gap before it
+            millis = int(event.split(' ')[1])
+            gap = 0 if (previous is None or args.speed == 0) else (millis - previous) / 1000.0 / args.speed
+            previous = millis
+            if not wait_for(port, '#NEXT', gap + 10):
+                sys.exit('lost the WiTcontroller at event %d' % (i + 1))
+
+        port.write(b'#END\n')
+        end = time.time() + 10
+        while time.time() < end:
+            line = read_line(port)
+            if line.startswith('#REPORT'):
+                print(line)
+                if line == '#REPORT END':
+                    break
+        print('replayed %d events in %.1fs' % (len(events), time.time() - start))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Record and replay WiTcontroller sessions')
+    parser.add_argument('mode', choices=['record', 'replay'])
+    parser.add_argument('port', help='serial port e.g. /dev/ttyUSB0 or COM3')
+    parser.add_argument('file', help='capture file')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--speed', type=float, default=1.0, help='replay speed. 1 = original, 0 = as fast as possible')
+    parser.add_argument('--verbose', action='store_true', help='show the other console output while recording')
+    args = parser.parse_args()
+
+    if args.mode == 'record':
+        record(args)
+    else:
+        replay(args)
+
+
+if __name__ == '__main__':
+    main()